@@ -47,6 +47,7 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "gromacs/analysisdata/abstractdata.h"
@@ -245,7 +246,7 @@ class AnalysisDataStorageImpl
          * There is always one unused frame in the buffer, which is initialized
          * such that when \a firstFrameLocation_ is incremented, it becomes
          * valid.  This makes it easier to rotate the buffer in concurrent
-         * access scenarions (which are not yet otherwise implemented).
+         * access scenarions.
          */
         FrameList               frames_;
         //! Location of oldest frame in \a frames_.
@@ -270,6 +271,13 @@ class AnalysisDataStorageImpl
          * frame (see \a frames_).
          */
         int                     nextIndex_;
+        /*! \brief
+         * Serializes the frame management for frames built concurrently.
+         *
+         * Recursive, because serial modules can access the stored frames
+         * from their notification callbacks.
+         */
+        mutable std::recursive_mutex mutex_;
 };
 
 /********************************************************************
@@ -494,6 +502,7 @@ AnalysisDataStorageImpl::getFrameBuilder()
 void
 AnalysisDataStorageImpl::finishFrame(int index)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const int storageIndex = computeStorageLocation(index);
     GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
 
@@ -516,6 +525,7 @@ AnalysisDataStorageImpl::finishFrame(int index)
 void
 AnalysisDataStorageImpl::finishFrameSerial(int index)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     GMX_RELEASE_ASSERT(index == firstUnnotifiedIndex_,
                        "Out of order finisFrameSerial() calls");
     const int storageIndex = computeStorageLocation(index);
@@ -780,6 +790,7 @@ AnalysisDataStorage::~AnalysisDataStorage()
 int
 AnalysisDataStorage::frameCount() const
 {
+    std::lock_guard<std::recursive_mutex> lock(impl_->mutex_);
     return impl_->firstUnnotifiedIndex();
 }
 
@@ -787,6 +798,7 @@ AnalysisDataStorage::frameCount() const
 AnalysisDataFrameRef
 AnalysisDataStorage::tryGetDataFrame(int index) const
 {
+    std::lock_guard<std::recursive_mutex> lock(impl_->mutex_);
     int storageIndex = impl_->computeStorageLocation(index);
     if (storageIndex == -1)
     {
@@ -860,6 +872,7 @@ AnalysisDataStorageFrame &
 AnalysisDataStorage::startFrame(const AnalysisDataFrameHeader &header)
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
+    std::lock_guard<std::recursive_mutex> lock(impl_->mutex_);
     internal::AnalysisDataStorageFrameData *storedFrame;
     if (impl_->storeAll())
     {
@@ -903,6 +916,7 @@ AnalysisDataStorage::startFrame(int index, real x, real dx)
 AnalysisDataStorageFrame &
 AnalysisDataStorage::currentFrame(int index)
 {
+    std::lock_guard<std::recursive_mutex> lock(impl_->mutex_);
     const int storageIndex = impl_->computeStorageLocation(index);
     GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
 
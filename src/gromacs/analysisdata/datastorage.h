@@ -257,8 +257,11 @@ class AnalysisDataStorageFrame
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * With startParallelDataStorage(), different frames can be built
+ * concurrently from different threads.  Starting and finishing frames is
+ * serialized internally, but point sets are passed to parallel modules
+ * concurrently for different frames.  finishFrameSerial() should be called
+ * from a single thread.
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
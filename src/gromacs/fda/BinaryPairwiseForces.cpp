@@ -0,0 +1,428 @@
+/*
+ * BinaryPairwiseForces.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "BinaryPairwiseForces.h"
+#include "config.h"
+
+#if !GMX_NATIVE_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fda {
+
+namespace {
+
+const char header_magic[8] = {'F', 'D', 'A', 'P', 'F', 'B', '0', '1'};
+const char index_magic[8] = {'F', 'D', 'A', 'P', 'F', 'B', 'I', 'X'};
+const std::int32_t plain_version = 1;
+const std::int32_t compressed_version = 2;
+
+/// Number of frames after which a compressed frame is encoded without reference to the previous one
+const std::int32_t key_frame_interval = 100;
+
+const size_t header_size = sizeof(header_magic) + 4 * sizeof(std::int32_t);
+const size_t compressed_header_size = header_size + sizeof(double) + 2 * sizeof(std::int32_t);
+const size_t frame_header_size = 2 * sizeof(std::int64_t);
+const size_t compressed_frame_header_size = 3 * sizeof(std::int64_t);
+const size_t trailer_size = sizeof(std::int64_t) + sizeof(index_magic);
+
+template <class T>
+void write_value(std::ostream& os, T const& value)
+{
+    os.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template <class T>
+T read_value(char const* position)
+{
+    T value;
+    std::memcpy(&value, position, sizeof(T));
+    return value;
+}
+
+/// Append value in LEB128 encoding, seven bits per byte
+void put_varint(std::vector<unsigned char>& encoded, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        encoded.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    encoded.push_back(static_cast<unsigned char>(value));
+}
+
+/// Append signed value with zigzag mapping, such that small magnitudes give short encodings
+void put_signed_varint(std::vector<unsigned char>& encoded, std::int64_t value)
+{
+    put_varint(encoded, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+/// Sequential reading of the variable-length integers of an encoded frame
+class VarintReader
+{
+public:
+
+    VarintReader(char const* begin, char const* end)
+     : position(reinterpret_cast<unsigned char const*>(begin)),
+       end(reinterpret_cast<unsigned char const*>(end))
+    {}
+
+    std::uint64_t get()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (position == end) throw std::runtime_error("Compressed frame of binary pairwise forces file is corrupted");
+            unsigned char byte = *position++;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Compressed frame of binary pairwise forces file is corrupted");
+    }
+
+    std::int64_t get_signed()
+    {
+        std::uint64_t value = get();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+private:
+
+    unsigned char const* position;
+
+    unsigned char const* end;
+
+};
+
+} // namespace
+
+BinaryPairwiseForcesWriter::BinaryPairwiseForcesWriter(std::ostream& os, int syslen, double precision)
+ : os(os),
+   precision(precision)
+{
+    os.write(header_magic, sizeof(header_magic));
+    write_value(os, precision > 0.0 ? compressed_version : plain_version);
+    write_value(os, static_cast<std::int32_t>(sizeof(real)));
+    write_value(os, static_cast<std::int32_t>(syslen));
+    write_value(os, static_cast<std::int32_t>(0));
+    if (precision > 0.0) {
+        write_value(os, precision);
+        write_value(os, key_frame_interval);
+        write_value(os, static_cast<std::int32_t>(0));
+    }
+}
+
+void BinaryPairwiseForcesWriter::write_frame(std::int64_t frame, std::vector<BinaryPairwiseForce>& pairwise_forces)
+{
+    std::sort(pairwise_forces.begin(), pairwise_forces.end());
+    frame_offsets.push_back(os.tellp());
+    write_value(os, frame);
+    write_value(os, static_cast<std::int64_t>(pairwise_forces.size()));
+    if (precision > 0.0) {
+        if ((frame_offsets.size() - 1) % key_frame_interval == 0) {
+            previous.clear();
+            previous_quantized.clear();
+        }
+        encode_frame(pairwise_forces);
+        write_value(os, static_cast<std::int64_t>(encoded.size()));
+        encoded.resize((encoded.size() + 7) / 8 * 8, 0);
+        os.write(reinterpret_cast<char const*>(encoded.data()), encoded.size());
+    } else {
+        os.write(reinterpret_cast<char const*>(pairwise_forces.data()), pairwise_forces.size() * sizeof(BinaryPairwiseForce));
+    }
+}
+
+void BinaryPairwiseForcesWriter::encode_frame(std::vector<BinaryPairwiseForce> const& pairwise_forces)
+{
+    encoded.clear();
+
+    // Match the pairs with the previous frame, both are sorted
+    std::vector<std::int64_t> reference(pairwise_forces.size(), 0);
+    std::vector<BinaryPairwiseForce> new_pairs;
+    std::vector<std::uint64_t> runs;
+    bool keep = true;
+    std::uint64_t run = 0;
+    size_t p = 0;
+    auto add_to_run = [&](bool kept) {
+        if (kept != keep) {
+            runs.push_back(run);
+            keep = kept;
+            run = 0;
+        }
+        ++run;
+    };
+    for (size_t c = 0; c != pairwise_forces.size(); ++c) {
+        for (; p != previous.size() and previous[p] < pairwise_forces[c]; ++p) add_to_run(false);
+        if (p != previous.size() and !(pairwise_forces[c] < previous[p])) {
+            add_to_run(true);
+            reference[c] = previous_quantized[p++];
+        } else {
+            new_pairs.push_back(pairwise_forces[c]);
+        }
+    }
+    for (; p != previous.size(); ++p) add_to_run(false);
+    if (!previous.empty()) runs.push_back(run);
+
+    for (auto r : runs) put_varint(encoded, r);
+
+    put_varint(encoded, new_pairs.size());
+    std::int32_t last_i = 0, last_j = 0;
+    for (auto const& pf : new_pairs) {
+        put_varint(encoded, static_cast<std::uint32_t>(pf.i - last_i));
+        put_varint(encoded, static_cast<std::uint32_t>(pf.i == last_i ? pf.j - last_j : pf.j));
+        put_varint(encoded, static_cast<std::uint32_t>(pf.type));
+        last_i = pf.i;
+        last_j = pf.j;
+    }
+
+    previous_quantized.resize(pairwise_forces.size());
+    for (size_t c = 0; c != pairwise_forces.size(); ++c) {
+        previous_quantized[c] = std::llround(pairwise_forces[c].force * precision);
+        put_signed_varint(encoded, previous_quantized[c] - reference[c]);
+    }
+    previous = pairwise_forces;
+}
+
+void BinaryPairwiseForcesWriter::write_index()
+{
+    os.write(reinterpret_cast<char const*>(frame_offsets.data()), frame_offsets.size() * sizeof(std::int64_t));
+    write_value(os, static_cast<std::int64_t>(frame_offsets.size()));
+    os.write(index_magic, sizeof(index_magic));
+    os.flush();
+}
+
+BinaryPairwiseForcesReader::BinaryPairwiseForcesReader(std::string const& filename)
+ : data(nullptr),
+   data_size(0),
+   frame_offsets(nullptr),
+   nb_frames(0),
+   syslen(0),
+   version(plain_version),
+   precision(0.0),
+   key_frame_interval(0),
+   has_decoded_frame(false),
+   decoded_frame(0)
+{
+#if GMX_NATIVE_WINDOWS
+    std::ifstream is(filename, std::ios::binary);
+    if (!is) throw std::runtime_error("Error opening file " + filename);
+    buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    data_size = buffer.size();
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) throw std::runtime_error("Error opening file " + filename);
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        close(fd);
+        throw std::runtime_error("Error reading file status of " + filename);
+    }
+    data_size = file_stat.st_size;
+    if (data_size != 0) {
+        void* mapped = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Error mapping file " + filename);
+        }
+        data = static_cast<char const*>(mapped);
+    }
+    close(fd);
+#endif
+
+    try {
+        if (data_size < header_size + trailer_size or std::memcmp(data, header_magic, sizeof(header_magic)) != 0)
+            throw std::runtime_error(filename + " is not a binary pairwise forces file");
+        version = read_value<std::int32_t>(data + 8);
+        if (version != plain_version and version != compressed_version)
+            throw std::runtime_error(filename + ": unsupported version of binary pairwise forces file");
+        if (read_value<std::int32_t>(data + 12) != static_cast<std::int32_t>(sizeof(real)))
+            throw std::runtime_error(filename + ": precision of binary pairwise forces file does not match");
+        syslen = read_value<std::int32_t>(data + 16);
+        if (syslen < 0)
+            throw std::runtime_error(filename + ": header of binary pairwise forces file is corrupted");
+        if (version == compressed_version) {
+            if (data_size < compressed_header_size + trailer_size)
+                throw std::runtime_error(filename + " is not a binary pairwise forces file");
+            precision = read_value<double>(data + header_size);
+            key_frame_interval = read_value<std::int32_t>(data + header_size + sizeof(double));
+            if (!(precision > 0.0) or key_frame_interval < 1)
+                throw std::runtime_error(filename + ": header of binary pairwise forces file is corrupted");
+        }
+
+        char const* trailer = data + data_size - trailer_size;
+        if (std::memcmp(trailer + sizeof(std::int64_t), index_magic, sizeof(index_magic)) != 0)
+            throw std::runtime_error(filename + ": frame index not found, the file is incomplete");
+        size_t body_begin = version == compressed_version ? compressed_header_size : header_size;
+        std::int64_t nb_index_entries = read_value<std::int64_t>(trailer);
+        if (nb_index_entries < 0 or static_cast<std::uint64_t>(nb_index_entries) > (data_size - body_begin - trailer_size) / sizeof(std::int64_t))
+            throw std::runtime_error(filename + ": frame index is corrupted");
+        nb_frames = nb_index_entries;
+        frame_offsets = reinterpret_cast<std::int64_t const*>(trailer - nb_frames * sizeof(std::int64_t));
+
+        // All frames must lie between the header and the index, the pairs of plain frames included
+        size_t body_end = data_size - trailer_size - nb_frames * sizeof(std::int64_t);
+        size_t frame_end = body_begin;
+        for (size_t frame = 0; frame != nb_frames; ++frame) {
+            std::int64_t offset = frame_offsets[frame];
+            if (offset < static_cast<std::int64_t>(frame_end) or static_cast<size_t>(offset) > body_end)
+                throw std::runtime_error(filename + ": frame index is corrupted");
+            size_t available = body_end - offset;
+            if (version == plain_version) {
+                if (available < frame_header_size)
+                    throw std::runtime_error(filename + ": frame index is corrupted");
+                std::uint64_t nb_pairs = read_value<std::int64_t>(data + offset + sizeof(std::int64_t));
+                if (nb_pairs > (available - frame_header_size) / sizeof(BinaryPairwiseForce))
+                    throw std::runtime_error(filename + ": frame " + std::to_string(frame) + " of binary pairwise forces file is corrupted");
+                frame_end = offset + frame_header_size + nb_pairs * sizeof(BinaryPairwiseForce);
+            } else {
+                if (available < compressed_frame_header_size)
+                    throw std::runtime_error(filename + ": frame index is corrupted");
+                std::uint64_t encoded_size = read_value<std::int64_t>(data + offset + 2 * sizeof(std::int64_t));
+                if (encoded_size > available - compressed_frame_header_size)
+                    throw std::runtime_error(filename + ": frame " + std::to_string(frame) + " of binary pairwise forces file is corrupted");
+                frame_end = offset + compressed_frame_header_size + encoded_size;
+            }
+        }
+    } catch (...) {
+#if !GMX_NATIVE_WINDOWS
+        if (data) munmap(const_cast<char*>(data), data_size);
+#endif
+        throw;
+    }
+}
+
+BinaryPairwiseForcesReader::~BinaryPairwiseForcesReader()
+{
+#if !GMX_NATIVE_WINDOWS
+    if (data) munmap(const_cast<char*>(data), data_size);
+#endif
+}
+
+bool BinaryPairwiseForcesReader::is_binary(std::string const& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    char magic[sizeof(header_magic)];
+    if (!is.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, header_magic, sizeof(header_magic)) == 0;
+}
+
+char const* BinaryPairwiseForcesReader::frame_header(size_t frame) const
+{
+    if (frame >= nb_frames) throw std::runtime_error("Frame " + std::to_string(frame) + " not found");
+    return data + frame_offsets[frame];
+}
+
+std::int64_t BinaryPairwiseForcesReader::frame_number(size_t frame) const
+{
+    return read_value<std::int64_t>(frame_header(frame));
+}
+
+size_t BinaryPairwiseForcesReader::size(size_t frame) const
+{
+    return read_value<std::int64_t>(frame_header(frame) + sizeof(std::int64_t));
+}
+
+BinaryPairwiseForce const* BinaryPairwiseForcesReader::begin(size_t frame) const
+{
+    if (version == plain_version)
+        return reinterpret_cast<BinaryPairwiseForce const*>(frame_header(frame) + frame_header_size);
+    decode_frame(frame);
+    return decoded.data();
+}
+
+void BinaryPairwiseForcesReader::decode_frame(size_t frame) const
+{
+    frame_header(frame);
+    if (has_decoded_frame and frame == decoded_frame) return;
+
+    // Continue after the decoded frame if it is in the interval of the key frame, otherwise start at the key frame
+    size_t key_frame = frame - frame % key_frame_interval;
+    size_t next_frame = key_frame;
+    if (has_decoded_frame and decoded_frame >= key_frame and decoded_frame < frame) {
+        next_frame = decoded_frame + 1;
+    } else {
+        decoded.clear();
+        decoded_quantized.clear();
+    }
+    // On error nothing is decoded
+    has_decoded_frame = false;
+    for (; next_frame <= frame; ++next_frame) decode_next_frame(next_frame);
+    decoded_frame = frame;
+    has_decoded_frame = true;
+}
+
+void BinaryPairwiseForcesReader::decode_next_frame(size_t frame) const
+{
+    char const* header = frame_header(frame);
+    size_t nb_pairs = read_value<std::int64_t>(header + sizeof(std::int64_t));
+    size_t encoded_size = read_value<std::int64_t>(header + 2 * sizeof(std::int64_t));
+    char const* encoded = header + compressed_frame_header_size;
+    VarintReader reader(encoded, encoded + encoded_size);
+
+    // Kept pairs of the previous frame, alternating runs of kept and dropped pairs
+    std::vector<bool> kept(decoded.size());
+    bool keep = true;
+    for (size_t p = 0; p != decoded.size(); keep = !keep) {
+        size_t run = reader.get();
+        if (run > decoded.size() - p)
+            throw std::runtime_error("Compressed frame of binary pairwise forces file is corrupted");
+        std::fill(kept.begin() + p, kept.begin() + p + run, keep);
+        p += run;
+    }
+
+    size_t nb_new_pairs = reader.get();
+    std::vector<BinaryPairwiseForce> new_pairs;
+    new_pairs.reserve(std::min(nb_new_pairs, nb_pairs));
+    std::int32_t last_i = 0, last_j = 0;
+    for (size_t n = 0; n != nb_new_pairs; ++n) {
+        std::int32_t i = last_i + static_cast<std::int32_t>(reader.get());
+        std::int32_t j = static_cast<std::int32_t>(reader.get()) + (i == last_i ? last_j : 0);
+        std::int32_t type = static_cast<std::int32_t>(reader.get());
+        new_pairs.push_back(BinaryPairwiseForce(i, j, 0.0, type));
+        last_i = i;
+        last_j = j;
+    }
+
+    // Merge the kept and the new pairs, equal pairs are matched with the previous frame
+    std::vector<BinaryPairwiseForce> pairwise_forces;
+    std::vector<std::int64_t> quantized;
+    pairwise_forces.reserve(nb_pairs);
+    quantized.reserve(nb_pairs);
+    size_t p = 0, n = 0;
+    while (true) {
+        while (p != decoded.size() and !kept[p]) ++p;
+        bool take_previous = p != decoded.size() and (n == new_pairs.size() or !(new_pairs[n] < decoded[p]));
+        if (take_previous) {
+            pairwise_forces.push_back(decoded[p]);
+            quantized.push_back(decoded_quantized[p++]);
+        } else if (n != new_pairs.size()) {
+            pairwise_forces.push_back(new_pairs[n++]);
+            quantized.push_back(0);
+        } else {
+            break;
+        }
+    }
+    if (pairwise_forces.size() != nb_pairs)
+        throw std::runtime_error("Compressed frame of binary pairwise forces file is corrupted");
+
+    for (size_t c = 0; c != nb_pairs; ++c) {
+        quantized[c] += reader.get_signed();
+        pairwise_forces[c].force = quantized[c] / precision;
+    }
+
+    decoded.swap(pairwise_forces);
+    decoded_quantized.swap(quantized);
+}
+
+} // namespace fda
@@ -0,0 +1,188 @@
+/*
+ * BinaryPairwiseForces.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_BINARYPAIRWISEFORCES_H_
+#define SRC_GROMACS_FDA_BINARYPAIRWISEFORCES_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Binary pairwise forces format (pfb)
+ *
+ * Layout of the file:
+ *
+ *   header:  char magic[8] = "FDAPFB01", int32 version, int32 sizeof(real), int32 syslen, int32 reserved
+ *   frames:  int64 frame number, int64 number of pairs, BinaryPairwiseForce[number of pairs]
+ *   index:   int64 offset of each frame, int64 number of frames, char magic[8] = "FDAPFBIX"
+ *
+ * The pairs of a frame are sorted by i, j, and type. All blocks are multiples of eight bytes,
+ * such that the records of a memory-mapped file can be accessed directly.
+ *
+ * Version 2 stores the frames compressed, similar to the xtc format:
+ *
+ *   header:  as version 1, followed by double precision, int32 key frame interval, int32 reserved
+ *   frames:  int64 frame number, int64 number of pairs, int64 size of the encoded frame,
+ *            encoded frame padded to a multiple of eight bytes
+ *
+ * The pairs of a frame are encoded as difference to the previous frame: run lengths of the
+ * kept and dropped pairs of the previous frame, followed by the new pairs with delta-encoded
+ * indices. The forces are quantized to round(force * precision) and stored as difference to the
+ * previous value of the same pair. All integers are variable-length encoded. Every
+ * key frame interval frames the previous frame is reset to empty, such that random access
+ * needs to decode at most key frame interval frames.
+ */
+struct BinaryPairwiseForce
+{
+    BinaryPairwiseForce(std::int32_t i = 0, std::int32_t j = 0, real force = 0.0, std::int32_t type = 0)
+     : i(i), j(j), force(force), type(type)
+    {}
+
+    bool operator < (BinaryPairwiseForce const& other) const {
+        return i < other.i or (i == other.i and (j < other.j or (j == other.j and type < other.type)));
+    }
+
+    std::int32_t i;
+    std::int32_t j;
+    real force;
+    std::int32_t type;
+};
+
+/// Sequential writer of the binary pairwise forces format
+class BinaryPairwiseForcesWriter
+{
+public:
+
+    /**
+     * Write the file header to os, which must be opened in binary mode.
+     * If precision is larger than zero, the frames are compressed (version 2)
+     * and the forces are stored with a resolution of 1/precision.
+     */
+    BinaryPairwiseForcesWriter(std::ostream& os, int syslen, double precision = 0.0);
+
+    /// Sort the pairs and append them as frame
+    void write_frame(std::int64_t frame, std::vector<BinaryPairwiseForce>& pairwise_forces);
+
+    /// Append the frame index, must be called once after the last frame
+    void write_index();
+
+private:
+
+    /// Encode the frame relative to the previous frame
+    void encode_frame(std::vector<BinaryPairwiseForce> const& pairwise_forces);
+
+    std::ostream& os;
+
+    /// Zero for uncompressed frames
+    double precision;
+
+    /// File offsets of the frames
+    std::vector<std::int64_t> frame_offsets;
+
+    /// Previous frame and its quantized forces, only used for compressed frames
+    std::vector<BinaryPairwiseForce> previous;
+    std::vector<std::int64_t> previous_quantized;
+
+    /// Encoded frame
+    std::vector<unsigned char> encoded;
+
+};
+
+/**
+ * Random access to the frames of a binary pairwise forces file.
+ *
+ * The file is memory-mapped and the records are not copied. Compressed frames are
+ * decoded on access into an internal buffer, the pointers returned by begin and end
+ * are valid until another frame is accessed. Sequential access decodes each frame once.
+ * Throws std::runtime_error if the file is not a valid binary pairwise forces file.
+ */
+class BinaryPairwiseForcesReader
+{
+public:
+
+    explicit BinaryPairwiseForcesReader(std::string const& filename);
+
+    ~BinaryPairwiseForcesReader();
+
+    BinaryPairwiseForcesReader(BinaryPairwiseForcesReader const&) = delete;
+    BinaryPairwiseForcesReader& operator = (BinaryPairwiseForcesReader const&) = delete;
+
+    /// Returns true if the file starts with the magic number of the binary format
+    static bool is_binary(std::string const& filename);
+
+    /// Total number of atoms/residues in the system
+    int get_syslen() const { return syslen; }
+
+    /// Force resolution of compressed frames, 0 for uncompressed frames
+    double get_precision() const { return precision; }
+
+    size_t number_of_frames() const { return nb_frames; }
+
+    /// Frame number as written by mdrun
+    std::int64_t frame_number(size_t frame) const;
+
+    /// Number of pairs of a frame
+    size_t size(size_t frame) const;
+
+    /// Pointer to the first pair of a frame
+    BinaryPairwiseForce const* begin(size_t frame) const;
+
+    BinaryPairwiseForce const* end(size_t frame) const { return begin(frame) + size(frame); }
+
+private:
+
+    /// Header of the frame, checks the range of frame
+    char const* frame_header(size_t frame) const;
+
+    /// Decode the compressed frame into decoded
+    void decode_frame(size_t frame) const;
+
+    /// Decode the frame relative to decoded, which holds the previous frame
+    void decode_next_frame(size_t frame) const;
+
+    /// Begin of the file content
+    char const* data;
+
+    /// Size of the file in bytes
+    size_t data_size;
+
+    /// File content if memory mapping is not available
+    std::vector<char> buffer;
+
+    /// Start of the frame index
+    std::int64_t const* frame_offsets;
+
+    size_t nb_frames;
+
+    int syslen;
+
+    std::int32_t version;
+
+    /// Force resolution of compressed frames
+    double precision;
+
+    std::int32_t key_frame_interval;
+
+    /// True if decoded holds the frame decoded_frame
+    mutable bool has_decoded_frame;
+
+    /// Last decoded frame, only valid if has_decoded_frame is true
+    mutable size_t decoded_frame;
+
+    mutable std::vector<BinaryPairwiseForce> decoded;
+    mutable std::vector<std::int64_t> decoded_quantized;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_BINARYPAIRWISEFORCES_H_ */
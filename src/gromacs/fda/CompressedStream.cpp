@@ -0,0 +1,206 @@
+/*
+ * CompressedStream.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <stdexcept>
+#include "CompressedStream.h"
+#include "config.h"
+
+#if GMX_FDA_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fda {
+
+namespace {
+
+const unsigned char gzip_magic[2] = {0x1f, 0x8b};
+
+#if GMX_FDA_ZLIB
+/// Window bits for deflate/inflate with gzip header and trailer
+const int gzip_window_bits = 15 + 16;
+#else
+void throw_no_zlib()
+{
+    throw std::runtime_error("Compressed FDA result files are not supported, GROMACS was compiled without zlib");
+}
+#endif
+
+} // namespace
+
+bool compression_available()
+{
+    return GMX_FDA_ZLIB;
+}
+
+bool is_compressed(std::string const& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    char magic[2];
+    if (!is.read(magic, sizeof(magic))) return false;
+    return static_cast<unsigned char>(magic[0]) == gzip_magic[0] and static_cast<unsigned char>(magic[1]) == gzip_magic[1];
+}
+
+#if GMX_FDA_ZLIB
+struct CompressingStreamBuffer::Stream
+{
+    z_stream z;
+};
+
+struct DecompressingStreamBuffer::Stream
+{
+    z_stream z;
+};
+#else
+struct CompressingStreamBuffer::Stream {};
+struct DecompressingStreamBuffer::Stream {};
+#endif
+
+CompressingStreamBuffer::CompressingStreamBuffer(std::streambuf *sink, size_t block_size)
+ : stream(new Stream),
+   sink(sink),
+   input(block_size),
+   output(block_size)
+{
+#if GMX_FDA_ZLIB
+    stream->z = z_stream();
+    if (deflateInit2(&stream->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Error initializing zlib compression");
+    setp(input.data(), input.data() + input.size());
+#else
+    throw_no_zlib();
+#endif
+}
+
+CompressingStreamBuffer::~CompressingStreamBuffer()
+{
+#if GMX_FDA_ZLIB
+    compress(true);
+    deflateEnd(&stream->z);
+#endif
+}
+
+CompressingStreamBuffer::int_type CompressingStreamBuffer::overflow(int_type c)
+{
+    compress(false);
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int CompressingStreamBuffer::sync()
+{
+    compress(false);
+    return sink->pubsync();
+}
+
+void CompressingStreamBuffer::compress(bool finish)
+{
+#if GMX_FDA_ZLIB
+    z_stream& z = stream->z;
+    z.next_in = reinterpret_cast<Bytef*>(pbase());
+    z.avail_in = pptr() - pbase();
+    int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+    int status;
+    do {
+        z.next_out = reinterpret_cast<Bytef*>(output.data());
+        z.avail_out = output.size();
+        status = deflate(&z, flush);
+        if (status == Z_STREAM_ERROR) throw std::runtime_error("Error in zlib compression");
+        std::streamsize size = output.size() - z.avail_out;
+        if (sink->sputn(output.data(), size) != size) throw std::runtime_error("Error writing compressed FDA result file");
+    } while (z.avail_out == 0 or (finish and status != Z_STREAM_END));
+    setp(input.data(), input.data() + input.size());
+#else
+    (void) finish;
+#endif
+}
+
+DecompressingStreamBuffer::DecompressingStreamBuffer(std::streambuf *source, size_t block_size)
+ : stream(new Stream),
+   source(source),
+   input(block_size),
+   output(block_size)
+{
+#if GMX_FDA_ZLIB
+    stream->z = z_stream();
+    if (inflateInit2(&stream->z, gzip_window_bits) != Z_OK)
+        throw std::runtime_error("Error initializing zlib decompression");
+    setg(output.data(), output.data(), output.data());
+#else
+    throw_no_zlib();
+#endif
+}
+
+DecompressingStreamBuffer::~DecompressingStreamBuffer()
+{
+#if GMX_FDA_ZLIB
+    inflateEnd(&stream->z);
+#endif
+}
+
+DecompressingStreamBuffer::int_type DecompressingStreamBuffer::underflow()
+{
+#if GMX_FDA_ZLIB
+    z_stream& z = stream->z;
+    while (true) {
+        if (z.avail_in == 0) {
+            z.next_in = reinterpret_cast<Bytef*>(input.data());
+            z.avail_in = source->sgetn(input.data(), input.size());
+            if (z.avail_in == 0) return traits_type::eof();
+        }
+        z.next_out = reinterpret_cast<Bytef*>(output.data());
+        z.avail_out = output.size();
+        int status = inflate(&z, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            // Concatenated gzip members are read as one stream
+            if (inflateReset(&z) != Z_OK) throw std::runtime_error("Error in zlib decompression");
+        } else if (status != Z_OK and status != Z_BUF_ERROR) {
+            throw std::runtime_error("Corrupted compressed FDA result file");
+        }
+        size_t size = output.size() - z.avail_out;
+        if (size) {
+            setg(output.data(), output.data(), output.data() + size);
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+#else
+    return traits_type::eof();
+#endif
+}
+
+InputFileStream::InputFileStream()
+ : std::istream(nullptr)
+{
+    rdbuf(&file);
+}
+
+InputFileStream::InputFileStream(std::string const& filename)
+ : std::istream(nullptr)
+{
+    open(filename);
+}
+
+void InputFileStream::open(std::string const& filename)
+{
+    decompressor.reset();
+    rdbuf(&file);
+    if (file.is_open()) file.close();
+
+    bool compressed = is_compressed(filename);
+    if (!file.open(filename, compressed ? std::ios::in | std::ios::binary : std::ios::in)) {
+        setstate(std::ios::failbit);
+        return;
+    }
+    if (compressed) {
+        decompressor.reset(new DecompressingStreamBuffer(&file));
+        rdbuf(decompressor.get());
+    }
+}
+
+} // namespace fda
@@ -0,0 +1,131 @@
+/*
+ * CompressedStream.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_COMPRESSEDSTREAM_H_
+#define SRC_GROMACS_FDA_COMPRESSEDSTREAM_H_
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fda {
+
+/// Returns true if zlib support is compiled in
+bool compression_available();
+
+/// Returns true if the file starts with the gzip magic number
+bool is_compressed(std::string const& filename);
+
+/**
+ * Stream buffer compressing all characters in gzip format into sink.
+ *
+ * The characters are collected in blocks of block_size and passed to zlib,
+ * the gzip trailer is written at destruction. The sink must outlive the buffer.
+ * Throws std::runtime_error if zlib is not available.
+ */
+class CompressingStreamBuffer : public std::streambuf
+{
+public:
+
+    explicit CompressingStreamBuffer(std::streambuf *sink, size_t block_size = 1 << 18);
+
+    ~CompressingStreamBuffer();
+
+    CompressingStreamBuffer(CompressingStreamBuffer const&) = delete;
+    CompressingStreamBuffer& operator = (CompressingStreamBuffer const&) = delete;
+
+protected:
+
+    int_type overflow(int_type c) override;
+
+    /// Passes the collected characters to zlib, the gzip stream is only complete after destruction
+    int sync() override;
+
+private:
+
+    /// Compress the collected characters, finish the gzip stream if finish is true
+    void compress(bool finish);
+
+    struct Stream;
+
+    std::unique_ptr<Stream> stream;
+
+    std::streambuf *sink;
+
+    /// Uncompressed characters
+    std::vector<char> input;
+
+    /// Compressed characters
+    std::vector<char> output;
+
+};
+
+/**
+ * Stream buffer decompressing gzip data from source block by block.
+ * Throws std::runtime_error if zlib is not available or the data are corrupted.
+ */
+class DecompressingStreamBuffer : public std::streambuf
+{
+public:
+
+    explicit DecompressingStreamBuffer(std::streambuf *source, size_t block_size = 1 << 18);
+
+    ~DecompressingStreamBuffer();
+
+    DecompressingStreamBuffer(DecompressingStreamBuffer const&) = delete;
+    DecompressingStreamBuffer& operator = (DecompressingStreamBuffer const&) = delete;
+
+protected:
+
+    int_type underflow() override;
+
+private:
+
+    struct Stream;
+
+    std::unique_ptr<Stream> stream;
+
+    std::streambuf *source;
+
+    /// Compressed characters
+    std::vector<char> input;
+
+    /// Decompressed characters
+    std::vector<char> output;
+
+};
+
+/**
+ * Input file stream for FDA result files, which decompresses gzip-compressed
+ * files transparently. Can be used like std::ifstream.
+ */
+class InputFileStream : public std::istream
+{
+public:
+
+    InputFileStream();
+
+    explicit InputFileStream(std::string const& filename);
+
+    void open(std::string const& filename);
+
+    bool is_open() const { return file.is_open(); }
+
+private:
+
+    std::filebuf file;
+
+    /// Only allocated for compressed files
+    std::unique_ptr<DecompressingStreamBuffer> decompressor;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_COMPRESSEDSTREAM_H_ */
@@ -8,39 +8,103 @@
 #ifndef SRC_GROMACS_FDA_DETAILEDFORCE_H_
 #define SRC_GROMACS_FDA_DETAILEDFORCE_H_
 
-#include <array>
+#include <vector>
 #include "PureInteractionType.h"
 #include "Vector.h"
 
 namespace fda {
 
+/// Vector force of a single interaction type of a pair
 struct DetailedForce
 {
-    /// Default constructor
-    DetailedForce()
-     : number{0}
+    DetailedForce(Vector const& force, PureInteractionType type, int next)
+     : force(force), type(type), next(next)
     {}
 
-    DetailedForce(Vector force_in, PureInteractionType type)
-     : number{0}
+    Vector force;
+
+    PureInteractionType type;
+
+    /// Position of the force of the next interaction type of the same pair, -1 for the last one
+    int next;
+};
+
+/**
+ * Detailed forces of all pairs of a row.
+ *
+ * Only the interaction types which are present are stored. The forces of a pair
+ * are linked in ascending order of the interaction type, all forces of the row are
+ * stored contiguously in the order of their first appearance.
+ */
+class DetailedForceList
+{
+public:
+
+    /// Add force of type to pair p, a new pair is appended if p == size()
+    void add(size_t p, Vector const& force, PureInteractionType type)
+    {
+        if (p == first.size()) first.push_back(-1);
+
+        int previous = -1;
+        int k = first[p];
+        while (k != -1 and forces[k].type < type) {
+            previous = k;
+            k = forces[k].next;
+        }
+
+        if (k != -1 and forces[k].type == type) {
+            forces[k].force += force;
+            return;
+        }
+
+        forces.push_back(DetailedForce(force, type, k));
+        if (previous == -1) first[p] = forces.size() - 1;
+        else forces[previous].next = forces.size() - 1;
+    }
+
+    /// Add all forces of pair q of other to pair p, a new pair is appended if p == size()
+    void add(size_t p, DetailedForceList const& other, size_t q)
+    {
+        if (p == first.size()) first.push_back(-1);
+        other.for_each(q, [this, p](PureInteractionType type, Vector const& force){ add(p, force, type); });
+    }
+
+    /// Call f(type, force) for all interaction types of pair p in ascending order
+    template <class Function>
+    void for_each(size_t p, Function f) const
+    {
+        for (int k = first[p]; k != -1; k = forces[k].next) f(forces[k].type, forces[k].force);
+    }
+
+    /// Number of pairs
+    size_t size() const { return first.size(); }
+
+    bool empty() const { return first.empty(); }
+
+    /// Remove all pairs, but keep the capacity
+    void clear()
     {
-        int i = to_index(type);
-        force[i] = force_in;
-        ++number[i];
+        first.clear();
+        forces.clear();
     }
 
-    void add(Vector force_in, PureInteractionType type)
+    /// Reorder or select the pairs, the new pair p is the old pair permutation[p]
+    void permute(std::vector<size_t> const& permutation)
     {
-        int i = to_index(type);
-        force[i] += force_in;
-        ++number[i];
+        std::vector<int> permuted;
+        permuted.reserve(first.size());
+        for (auto p : permutation) permuted.push_back(first[p]);
+        first.swap(permuted);
     }
 
-    /// Vector force separated for each interaction type
-    std::array<Vector, static_cast<int>(PureInteractionType::NUMBER)> force;
+private:
+
+    /// Position of the force with the lowest interaction type of each pair
+    std::vector<int> first;
+
+    /// Forces of all pairs and interaction types
+    std::vector<DetailedForce> forces;
 
-    /// Number of forces for each interaction type
-    std::array<int, static_cast<int>(PureInteractionType::NUMBER)> number;
 };
 
 } // namespace fda
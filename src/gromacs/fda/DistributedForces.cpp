@@ -6,10 +6,14 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include "CompatInteractionType.h"
 #include "DistributedForces.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/fatalerror.h"
+#include "TextWriter.h"
 #include "Utilities.h"
 
 namespace fda {
@@ -17,8 +21,12 @@ namespace fda {
 DistributedForces::DistributedForces(int syslen, FDASettings const& fda_settings)
  : syslen(syslen),
    indices(syslen),
+   pair_index(syslen),
    scalar_indices(syslen),
+   scalar_pair_index(syslen),
    scalar(syslen),
+   scalar_average(syslen),
+   scalar_steps(0),
    summed(syslen),
    detailed(syslen),
    fda_settings(fda_settings)
@@ -27,6 +35,7 @@ DistributedForces::DistributedForces(int syslen, FDASettings const& fda_settings
 void DistributedForces::clear()
 {
     for (auto& e : indices) e.clear();
+    for (auto& e : pair_index) e.clear();
     for (auto& e : summed) e.clear();
     for (auto& e : detailed) e.clear();
 }
@@ -34,7 +43,24 @@ void DistributedForces::clear()
 void DistributedForces::clear_scalar()
 {
     for (auto& e : scalar_indices) e.clear();
+    for (auto& e : scalar_pair_index) e.clear();
     for (auto& e : scalar) e.clear();
+    for (auto& e : scalar_average) e.clear();
+    scalar_steps = 0;
+}
+
+void DistributedForces::swap(DistributedForces& other)
+{
+    std::swap(syslen, other.syslen);
+    indices.swap(other.indices);
+    pair_index.swap(other.pair_index);
+    scalar_indices.swap(other.scalar_indices);
+    scalar_pair_index.swap(other.scalar_pair_index);
+    scalar.swap(other.scalar);
+    scalar_average.swap(other.scalar_average);
+    std::swap(scalar_steps, other.scalar_steps);
+    summed.swap(other.summed);
+    detailed.swap(other.detailed);
 }
 
 void DistributedForces::add_summed(int i, int j, Vector const& force, InteractionType type)
@@ -43,14 +69,16 @@ void DistributedForces::add_summed(int i, int j, Vector const& force, Interactio
 
     auto & summed_i = summed[i];
     auto & indices_i = indices[i];
+    auto & pair_index_i = pair_index[i];
 
-    auto iter = std::find(indices_i.begin(), indices_i.end(), j);
+    int p = pair_index_i.find(j);
 
-    if (iter == indices_i.end()) {
+    if (p == -1) {
+        pair_index_i.insert(j, indices_i.size());
         indices_i.push_back(j);
         summed_i.push_back(Force<Vector>(force, type));
     } else {
-        summed_i[std::distance(indices_i.begin(), iter)] += Force<Vector>(force, type);
+        summed_i[p] += Force<Vector>(force, type);
     }
 }
 
@@ -60,57 +88,153 @@ void DistributedForces::add_detailed(int i, int j, Vector const& force, PureInte
 
     auto & detailed_i = detailed[i];
     auto & indices_i = indices[i];
+    auto & pair_index_i = pair_index[i];
 
-    auto iter = std::find(indices_i.begin(), indices_i.end(), j);
+    int p = pair_index_i.find(j);
 
-    if (iter == indices_i.end()) {
+    if (p == -1) {
+        pair_index_i.insert(j, indices_i.size());
         indices_i.push_back(j);
-        detailed_i.push_back(DetailedForce(force, type));
+        detailed_i.add(detailed_i.size(), force, type);
     } else {
-        detailed_i[std::distance(indices_i.begin(), iter)].add(force, type);
+        detailed_i.add(p, force, type);
+    }
+}
+
+void DistributedForces::add(DistributedForces const& other)
+{
+    for (size_t i = 0; i != other.indices.size(); ++i) {
+        auto const& other_indices_i = other.indices[i];
+        if (other_indices_i.empty()) continue;
+        auto & indices_i = indices[i];
+        auto & pair_index_i = pair_index[i];
+        for (size_t q = 0; q != other_indices_i.size(); ++q) {
+            int j = other_indices_i[q];
+            int p = pair_index_i.find(j);
+            if (p == -1) {
+                pair_index_i.insert(j, indices_i.size());
+                indices_i.push_back(j);
+                if (!other.summed[i].empty()) summed[i].push_back(other.summed[i][q]);
+                if (!other.detailed[i].empty()) detailed[i].add(detailed[i].size(), other.detailed[i], q);
+            } else {
+                if (!other.summed[i].empty()) summed[i][p] += other.summed[i][q];
+                if (!other.detailed[i].empty()) detailed[i].add(p, other.detailed[i], q);
+            }
+        }
+    }
+}
+
+namespace {
+
+/// Append the bytes of value to buffer
+template <class T>
+void append_bytes(std::vector<char>& buffer, T const& value)
+{
+    char const* bytes = reinterpret_cast<char const*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/// Read value from the bytes at position and advance position
+template <class T>
+T extract_bytes(char const*& position)
+{
+    T value;
+    std::memcpy(&value, position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+} // namespace
+
+void DistributedForces::serialize(std::vector<char>& buffer) const
+{
+    for (size_t i = 0; i != indices.size(); ++i) {
+        auto const& indices_i = indices[i];
+        for (size_t p = 0; p != indices_i.size(); ++p) {
+            append_bytes(buffer, static_cast<int>(i));
+            append_bytes(buffer, indices_i[p]);
+            if (fda_settings.one_pair == OnePair::SUMMED) {
+                append_bytes(buffer, summed[i][p]);
+            } else {
+                int nb_types = 0;
+                detailed[i].for_each(p, [&nb_types](PureInteractionType, Vector const&){ ++nb_types; });
+                append_bytes(buffer, nb_types);
+                detailed[i].for_each(p, [&buffer](PureInteractionType type, Vector const& force){
+                    append_bytes(buffer, type);
+                    append_bytes(buffer, force);
+                });
+            }
+        }
+    }
+}
+
+void DistributedForces::add_serialized(char const* buffer, size_t size)
+{
+    for (char const* position = buffer; position < buffer + size;) {
+        int i = extract_bytes<int>(position);
+        int j = extract_bytes<int>(position);
+        auto & indices_i = indices[i];
+        auto & pair_index_i = pair_index[i];
+        int p = pair_index_i.find(j);
+        if (p == -1) {
+            pair_index_i.insert(j, indices_i.size());
+            indices_i.push_back(j);
+        }
+        if (fda_settings.one_pair == OnePair::SUMMED) {
+            Force<Vector> force = extract_bytes<Force<Vector>>(position);
+            if (p == -1) summed[i].push_back(force);
+            else summed[i][p] += force;
+        } else {
+            if (p == -1) p = indices_i.size() - 1;
+            int nb_types = extract_bytes<int>(position);
+            for (int k = 0; k != nb_types; ++k) {
+                PureInteractionType type = extract_bytes<PureInteractionType>(position);
+                detailed[i].add(p, extract_bytes<Vector>(position), type);
+            }
+        }
     }
 }
 
 void DistributedForces::write_detailed_vector(std::ostream& os) const
 {
+    TextWriter writer(os);
+
     for (size_t i = 0; i != detailed.size(); ++i) {
         auto const& detailed_i = detailed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != detailed_i.size(); ++p) {
             size_t j = indices_i[p];
-            auto const& detailed_j = detailed_i[p];
-            for (int type = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
-                if (detailed_j.number[type] == 0) continue;
-                Vector const& force = detailed_j.force[type];
-                os << i << " " << j << " "
-                   << force[XX] << " " << force[YY] << " " << force[ZZ] << " "
-                   << from_pure(static_cast<PureInteractionType>(type)) << std::endl;
-            }
+            detailed_i.for_each(p, [&](PureInteractionType type, Vector const& force){
+                writer << i << " " << j << " "
+                       << force[XX] << " " << force[YY] << " " << force[ZZ] << " "
+                       << from_pure(type) << '\n';
+            });
         }
     }
 }
 
 void DistributedForces::write_detailed_scalar(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const
 {
+    TextWriter writer(os);
+
     for (size_t i = 0; i != detailed.size(); ++i) {
         auto const& detailed_i = detailed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != detailed_i.size(); ++p) {
             size_t j = indices_i[p];
-            auto const& detailed_j = detailed_i[p];
-            for (int type = 0; type != static_cast<int>(PureInteractionType::NUMBER); ++type) {
-                if (detailed_j.number[type] == 0) continue;
-                Vector const& force = detailed_j.force[type];
-                os << i << " " << j << " "
-                   << vector2signedscalar(force.get_pointer(), x[i], x[j], fda_settings.v2s) << " "
-                   << from_pure(static_cast<PureInteractionType>(type)) << std::endl;
-            }
+            detailed_i.for_each(p, [&](PureInteractionType type, Vector const& force){
+                writer << i << " " << j << " "
+                       << vector2signedscalar(force.get_pointer(), x[i], x[j], fda_settings.v2s) << " "
+                       << from_pure(type) << '\n';
+            });
         }
     }
 }
 
 void DistributedForces::write_summed_vector(std::ostream& os) const
 {
+    TextWriter writer(os);
+
     for (size_t i = 0; i != summed.size(); ++i) {
         auto const& summed_i = summed[i];
         auto const& indices_i = indices[i];
@@ -118,39 +242,59 @@ void DistributedForces::write_summed_vector(std::ostream& os) const
             size_t j = indices_i[p];
             auto const& summed_j = summed_i[p];
             Vector const& force = summed_j.force;
-            os << i << " " << j << " "
-               << force[XX] << " " << force[YY] << " " << force[ZZ] << " "
-               << summed_j.type << std::endl;
+            writer << i << " " << j << " "
+                   << force[XX] << " " << force[YY] << " " << force[ZZ] << " "
+                   << summed_j.type << '\n';
         }
     }
 }
 
 void DistributedForces::write_summed_scalar(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const
 {
+    TextWriter writer(os);
+
     for (size_t i = 0; i != summed.size(); ++i) {
         auto const& summed_i = summed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
             size_t j = indices_i[p];
             auto const& summed_j = summed_i[p];
-            os << i << " " << j << " "
-               << vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s) << " "
-               << summed_j.type << std::endl;
+            writer << i << " " << j << " "
+                   << vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s) << " "
+                   << summed_j.type << '\n';
         }
     }
 }
 
 void DistributedForces::write_scalar(std::ostream& os) const
 {
+    TextWriter writer(os);
+
     for (size_t i = 0; i != scalar.size(); ++i) {
         auto const& scalar_i = scalar[i];
         auto const& scalar_indices_i = scalar_indices[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             size_t j = scalar_indices_i[p];
             auto const& scalar_j = scalar_i[p];
-            os << i << " " << j << " "
-               << scalar_j.force << " "
-               << scalar_j.type << std::endl;
+            writer << i << " " << j << " "
+                   << scalar_j.force << " "
+                   << scalar_j.type << '\n';
+        }
+    }
+}
+
+void DistributedForces::write_scalar_stddev(std::ostream& os) const
+{
+    TextWriter writer(os);
+
+    for (size_t i = 0; i != scalar.size(); ++i) {
+        auto const& scalar_i = scalar[i];
+        auto const& scalar_average_i = scalar_average[i];
+        auto const& scalar_indices_i = scalar_indices[i];
+        for (size_t p = 0; p != scalar_i.size(); ++p) {
+            writer << i << " " << scalar_indices_i[p] << " "
+                   << static_cast<real>(scalar_average_i[p].stddev()) << " "
+                   << scalar_i[p].type << '\n';
         }
     }
 }
@@ -190,30 +334,33 @@ void DistributedForces::write_total_forces(std::ostream& os, gmx::HostVector<gmx
     }
 
     // j holds the index of first zero item or the length of force
+    TextWriter writer(os);
     bool first_on_line = true;
     for (int i = 0; i < j; ++i) {
         if (first_on_line) {
-            os << total_forces[i];
+            writer << total_forces[i];
             first_on_line = false;
         } else {
-            os << " " << total_forces[i];
+            writer << " " << total_forces[i];
         }
     }
-    os << std::endl;
+    writer << '\n';
 }
 
 void DistributedForces::write_scalar_compat_ascii(std::ostream& os) const
 {
+    TextWriter writer(os);
+
     // Print total number of interactions
     int nb_interactions = 0;
     for (auto const& s : scalar) nb_interactions += s.size();
-    os << nb_interactions << std::endl;
+    writer << nb_interactions << '\n';
 
     // Print atom indices which have interactions
     for (size_t i = 0; i != scalar.size(); ++i) {
-        if (!scalar[i].empty()) os << i << " ";
+        if (!scalar[i].empty()) writer << i << " ";
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print indices
     for (size_t i = 0; i != scalar.size(); ++i) {
@@ -221,44 +368,46 @@ void DistributedForces::write_scalar_compat_ascii(std::ostream& os) const
         auto const& scalar_indices_i = scalar_indices[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             size_t j = scalar_indices_i[p];
-            os << (i > j ? j * syslen + i : i * syslen + j) << " ";
+            writer << (i > j ? j * syslen + i : i * syslen + j) << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print forces
     for (size_t i = 0; i != scalar.size(); ++i) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
-            os << scalar_j.force << " ";
+            writer << scalar_j.force << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print types
     for (size_t i = 0; i != scalar.size(); ++i) {
         auto const& scalar_i = scalar[i];
         for (size_t p = 0; p != scalar_i.size(); ++p) {
             auto const& scalar_j = scalar_i[p];
-            os << to_index(to_compat(scalar_j.type)) << " ";
+            writer << to_index(to_compat(scalar_j.type)) << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 }
 
 void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const
 {
+    TextWriter writer(os);
+
     // Print total number of interactions
     int nb_interactions = 0;
     for (auto const& s : summed) nb_interactions += s.size();
-    os << nb_interactions << std::endl;
+    writer << nb_interactions << '\n';
 
     // Print atom indices which have interactions
     for (size_t i = 0; i != summed.size(); ++i) {
-        if (!summed[i].empty()) os << i << " ";
+        if (!summed[i].empty()) writer << i << " ";
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print indices
     for (size_t i = 0; i != summed.size(); ++i) {
@@ -266,10 +415,10 @@ void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::HostVec
         auto const& summed_indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
             size_t j = summed_indices_i[p];
-            os << (i > j ? j * syslen + i : i * syslen + j) << " ";
+            writer << (i > j ? j * syslen + i : i * syslen + j) << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print forces
     for (size_t i = 0; i != summed.size(); ++i) {
@@ -278,20 +427,20 @@ void DistributedForces::write_summed_compat_ascii(std::ostream& os, gmx::HostVec
         for (size_t p = 0; p != summed_i.size(); ++p) {
             size_t j = summed_indices_i[p];
             auto const& summed_j = summed_i[p];
-            os << vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s) << " ";
+            writer << vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s) << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 
     // Print types
     for (size_t i = 0; i != summed.size(); ++i) {
         auto const& summed_i = summed[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
             auto const& summed_j = summed_i[p];
-            os << to_index(to_compat(summed_j.type)) << " ";
+            writer << to_index(to_compat(summed_j.type)) << " ";
         }
     }
-    os << std::endl;
+    writer << '\n';
 }
 
 void DistributedForces::write_scalar_compat_bin(std::ostream& os) const
@@ -385,32 +534,235 @@ void DistributedForces::write_summed_compat_bin(std::ostream& os, gmx::HostVecto
     }
 }
 
-void DistributedForces::scalar_real_divide(real divisor)
+void DistributedForces::summed_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces, gmx::HostVector<gmx::RVec> const& x) const
 {
-    real inv = 1.0 / divisor;
-    for (auto& scalar_i : scalar)
-        for (auto& scalar_j : scalar_i) scalar_j.force *= inv;
+    for (size_t i = 0; i != summed.size(); ++i) {
+        auto const& summed_i = summed[i];
+        auto const& indices_i = indices[i];
+        for (size_t p = 0; p != summed_i.size(); ++p) {
+            int j = indices_i[p];
+            auto const& summed_j = summed_i[p];
+            pairwise_forces.push_back(BinaryPairwiseForce(i, j,
+                vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s), summed_j.type));
+        }
+    }
+}
+
+void DistributedForces::detailed_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces, gmx::HostVector<gmx::RVec> const& x) const
+{
+    for (size_t i = 0; i != detailed.size(); ++i) {
+        auto const& detailed_i = detailed[i];
+        auto const& indices_i = indices[i];
+        for (size_t p = 0; p != detailed_i.size(); ++p) {
+            int j = indices_i[p];
+            detailed_i.for_each(p, [&](PureInteractionType type, Vector const& force){
+                pairwise_forces.push_back(BinaryPairwiseForce(i, j,
+                    vector2signedscalar(force.get_pointer(), x[i], x[j], fda_settings.v2s), from_pure(type)));
+            });
+        }
+    }
+}
+
+void DistributedForces::scalar_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces) const
+{
+    for (size_t i = 0; i != scalar.size(); ++i) {
+        auto const& scalar_i = scalar[i];
+        auto const& scalar_indices_i = scalar_indices[i];
+        for (size_t p = 0; p != scalar_i.size(); ++p) {
+            pairwise_forces.push_back(BinaryPairwiseForce(i, scalar_indices_i[p], scalar_i[p].force, scalar_i[p].type));
+        }
+    }
+}
+
+void DistributedForces::scalar_stddev_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces) const
+{
+    for (size_t i = 0; i != scalar.size(); ++i) {
+        auto const& scalar_i = scalar[i];
+        auto const& scalar_average_i = scalar_average[i];
+        auto const& scalar_indices_i = scalar_indices[i];
+        for (size_t p = 0; p != scalar_i.size(); ++p) {
+            pairwise_forces.push_back(BinaryPairwiseForce(i, scalar_indices_i[p], scalar_average_i[p].stddev(), scalar_i[p].type));
+        }
+    }
+}
+
+void DistributedForces::scalar_finalize_averages()
+{
+    for (size_t i = 0; i != scalar.size(); ++i) {
+        auto & scalar_i = scalar[i];
+        auto & scalar_average_i = scalar_average[i];
+        for (size_t p = 0; p != scalar_i.size(); ++p) {
+            // Pairs missing in the last steps
+            scalar_average_i[p].add_zeros(scalar_steps);
+            scalar_i[p].force = scalar_average_i[p].mean;
+        }
+    }
 }
 
 void DistributedForces::summed_merge_to_scalar(gmx::HostVector<gmx::RVec> const& x)
 {
+    ++scalar_steps;
     for (size_t i = 0; i != summed.size(); ++i) {
         auto & scalar_i = scalar[i];
+        auto & scalar_average_i = scalar_average[i];
         auto & scalar_indices_i = scalar_indices[i];
+        auto & scalar_pair_index_i = scalar_pair_index[i];
         auto const& summed_i = summed[i];
         auto const& indices_i = indices[i];
         for (size_t p = 0; p != summed_i.size(); ++p) {
-            size_t j = indices_i[p];
+            int j = indices_i[p];
             auto const& summed_j = summed_i[p];
-            auto iter = std::find(scalar_indices_i.begin(), scalar_indices_i.end(), j);
-            Force<real> scalar_force(vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s), summed_j.type);
-            if (iter == scalar_indices_i.end()) {
+            int q = scalar_pair_index_i.find(j);
+            real scalar_force = vector2signedscalar(summed_j.force.get_pointer(), x[i], x[j], fda_settings.v2s);
+            if (q == -1) {
+                q = scalar_indices_i.size();
+                scalar_pair_index_i.insert(j, q);
                 scalar_indices_i.push_back(j);
-                scalar_i.push_back(scalar_force);
+                scalar_i.push_back(Force<real>(0.0, summed_j.type));
+                scalar_average_i.push_back(RunningAverage());
             } else {
-                scalar_i[std::distance(scalar_indices_i.begin(), iter)] += scalar_force;
+                scalar_i[q].type |= summed_j.type;
+            }
+            scalar_average_i[q].add(scalar_force, scalar_steps);
+        }
+    }
+}
+
+namespace {
+
+/// Returns the permutation sorting the row by the second index j
+std::vector<size_t> sorting_permutation(std::vector<int> const& indices_i)
+{
+    std::vector<size_t> permutation(indices_i.size());
+    for (size_t p = 0; p != permutation.size(); ++p) permutation[p] = p;
+    std::sort(permutation.begin(), permutation.end(),
+        [&indices_i](size_t p1, size_t p2){ return indices_i[p1] < indices_i[p2]; });
+    return permutation;
+}
+
+/// Apply permutation to the row
+template <class T>
+void permute(std::vector<T>& row, std::vector<size_t> const& permutation)
+{
+    std::vector<T> permuted;
+    permuted.reserve(row.size());
+    for (auto p : permutation) permuted.push_back(row[p]);
+    row.swap(permuted);
+}
+
+/// Rebuild lookup table of the row after the positions have been changed
+void rebuild(PairIndex& pair_index_i, std::vector<int> const& indices_i)
+{
+    pair_index_i.clear();
+    for (size_t p = 0; p != indices_i.size(); ++p) pair_index_i.insert(indices_i[p], p);
+}
+
+/**
+ * Returns the positions of the pairs of each row which pass the force threshold and
+ * which are among the top_k strongest pairs of atom/residue i or j (0 for all).
+ * Pairs with the same magnitude as the k-th strongest one are kept as well.
+ */
+std::vector<std::vector<size_t>> kept_pairs(std::vector<std::vector<int>> const& indices,
+    std::vector<std::vector<real>> const& magnitudes, real threshold, int top_k)
+{
+    std::vector<real> limits(indices.size(), 0.0);
+    if (top_k) {
+        std::vector<std::vector<real>> per_particle(indices.size());
+        for (size_t i = 0; i != indices.size(); ++i) {
+            for (size_t p = 0; p != indices[i].size(); ++p) {
+                per_particle[i].push_back(magnitudes[i][p]);
+                per_particle[indices[i][p]].push_back(magnitudes[i][p]);
             }
         }
+        for (size_t i = 0; i != indices.size(); ++i) {
+            auto & m = per_particle[i];
+            if (m.size() <= static_cast<size_t>(top_k)) continue;
+            std::nth_element(m.begin(), m.begin() + top_k - 1, m.end(), std::greater<real>());
+            limits[i] = m[top_k - 1];
+        }
+    }
+
+    std::vector<std::vector<size_t>> kept(indices.size());
+    for (size_t i = 0; i != indices.size(); ++i) {
+        for (size_t p = 0; p != indices[i].size(); ++p) {
+            real m = magnitudes[i][p];
+            if (m >= threshold and (m >= limits[i] or m >= limits[indices[i][p]])) kept[i].push_back(p);
+        }
+    }
+    return kept;
+}
+
+} // namespace
+
+void DistributedForces::sort_pairs()
+{
+    for (size_t i = 0; i != indices.size(); ++i) {
+        auto & indices_i = indices[i];
+        if (std::is_sorted(indices_i.begin(), indices_i.end())) continue;
+        std::vector<size_t> permutation = sorting_permutation(indices_i);
+        if (!summed[i].empty()) permute(summed[i], permutation);
+        if (!detailed[i].empty()) detailed[i].permute(permutation);
+        permute(indices_i, permutation);
+        rebuild(pair_index[i], indices_i);
+    }
+}
+
+void DistributedForces::sort_scalar_pairs()
+{
+    for (size_t i = 0; i != scalar_indices.size(); ++i) {
+        auto & scalar_indices_i = scalar_indices[i];
+        if (std::is_sorted(scalar_indices_i.begin(), scalar_indices_i.end())) continue;
+        std::vector<size_t> permutation = sorting_permutation(scalar_indices_i);
+        permute(scalar[i], permutation);
+        permute(scalar_average[i], permutation);
+        permute(scalar_indices_i, permutation);
+        rebuild(scalar_pair_index[i], scalar_indices_i);
+    }
+}
+
+void DistributedForces::filter_pairs(gmx::HostVector<gmx::RVec> const& x, bool vector)
+{
+    if (fda_settings.force_threshold == 0.0 and fda_settings.top_k_pairs == 0) return;
+
+    bool is_summed = fda_settings.one_pair == OnePair::SUMMED;
+    std::vector<std::vector<real>> magnitudes(syslen);
+    for (int i = 0; i != syslen; ++i) {
+        auto const& indices_i = indices[i];
+        for (size_t p = 0; p != indices_i.size(); ++p) {
+            Vector force;
+            if (is_summed) force = summed[i][p].force;
+            else detailed[i].for_each(p, [&force](PureInteractionType, Vector const& f){ force += f; });
+            magnitudes[i].push_back(vector ? norm(force.get_pointer())
+                : std::abs(vector2signedscalar(force.get_pointer(), x[i], x[indices_i[p]], fda_settings.v2s)));
+        }
+    }
+
+    std::vector<std::vector<size_t>> kept = kept_pairs(indices, magnitudes, fda_settings.force_threshold, fda_settings.top_k_pairs);
+    for (int i = 0; i != syslen; ++i) {
+        if (kept[i].size() == indices[i].size()) continue;
+        if (is_summed) permute(summed[i], kept[i]);
+        else detailed[i].permute(kept[i]);
+        permute(indices[i], kept[i]);
+        rebuild(pair_index[i], indices[i]);
+    }
+}
+
+void DistributedForces::filter_scalar_pairs()
+{
+    if (fda_settings.force_threshold == 0.0 and fda_settings.top_k_pairs == 0) return;
+
+    std::vector<std::vector<real>> magnitudes(syslen);
+    for (int i = 0; i != syslen; ++i) {
+        for (auto const& scalar_j : scalar[i]) magnitudes[i].push_back(std::abs(scalar_j.force));
+    }
+
+    std::vector<std::vector<size_t>> kept = kept_pairs(scalar_indices, magnitudes, fda_settings.force_threshold, fda_settings.top_k_pairs);
+    for (int i = 0; i != syslen; ++i) {
+        if (kept[i].size() == scalar_indices[i].size()) continue;
+        permute(scalar[i], kept[i]);
+        permute(scalar_average[i], kept[i]);
+        permute(scalar_indices[i], kept[i]);
+        rebuild(scalar_pair_index[i], scalar_indices[i]);
     }
 }
 
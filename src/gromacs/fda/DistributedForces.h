@@ -12,9 +12,12 @@
 #include "gromacs/gpu_utils/hostallocator.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/utility/real.h"
+#include "BinaryPairwiseForces.h"
 #include "DetailedForce.h"
 #include "FDASettings.h"
 #include "Force.h"
+#include "PairIndex.h"
+#include "RunningAverage.h"
 #include "Vector.h"
 #include "Vector2Scalar.h"
 
@@ -49,10 +52,22 @@ public:
     /// Clear scalar array
     void clear_scalar();
 
+    /// Exchange all pairs with other, which must have the same settings
+    void swap(DistributedForces& other);
+
     void add_summed(int i, int j, Vector const& force, InteractionType type);
 
     void add_detailed(int i, int j, Vector const& force, PureInteractionType type);
 
+    /// Add all summed/detailed pairs of other, e.g. of a thread-local buffer
+    void add(DistributedForces const& other);
+
+    /// Append all summed/detailed pairs as raw bytes to buffer, used for the communication between ranks
+    void serialize(std::vector<char>& buffer) const;
+
+    /// Add all summed/detailed pairs of a buffer written by serialize
+    void add_serialized(char const* buffer, size_t size);
+
     void write_detailed_vector(std::ostream& os) const;
 
     void write_detailed_scalar(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const;
@@ -63,6 +78,9 @@ public:
 
     void write_scalar(std::ostream& os) const;
 
+    /// Write the standard deviations of the scalar time averages in the same format as write_scalar
+    void write_scalar_stddev(std::ostream& os) const;
+
     void write_total_forces(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const;
 
     void write_scalar_compat_ascii(std::ostream& os) const;
@@ -71,13 +89,42 @@ public:
 
     void write_scalar_compat_bin(std::ostream& os) const;
 
+    /// Append all summed pairs as signed scalars to pairwise_forces
+    void summed_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces, gmx::HostVector<gmx::RVec> const& x) const;
+
+    /// Append all detailed pairs as signed scalars to pairwise_forces, one entry for each interaction type
+    void detailed_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces, gmx::HostVector<gmx::RVec> const& x) const;
+
+    /// Append all scalar pairs to pairwise_forces
+    void scalar_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces) const;
+
+    /// Append the standard deviations of all scalar pairs to pairwise_forces
+    void scalar_stddev_to_binary(std::vector<BinaryPairwiseForce>& pairwise_forces) const;
+
     void write_summed_compat_bin(std::ostream& os, gmx::HostVector<gmx::RVec> const& x) const;
 
-    /// Divide all scalar forces by the divisor
-    void scalar_real_divide(real divisor);
+    /// Set the scalar forces to the running averages over all merged steps
+    void scalar_finalize_averages();
 
+    /// Add the summed pairs of the current step as signed scalars to the running averages
     void summed_merge_to_scalar(gmx::HostVector<gmx::RVec> const& x);
 
+    /// Sort the summed/detailed pairs of each row by the second index j
+    void sort_pairs();
+
+    /// Sort the scalar pairs of each row by the second index j
+    void sort_scalar_pairs();
+
+    /**
+     * Remove the summed/detailed pairs whose total force is below force_threshold or
+     * which are not among the top_k_pairs strongest pairs of any of their two atoms/residues.
+     * The force is measured as norm if vector is true, otherwise as absolute signed scalar.
+     */
+    void filter_pairs(gmx::HostVector<gmx::RVec> const& x, bool vector);
+
+    /// Remove the scalar pairs with the same criteria as filter_pairs
+    void filter_scalar_pairs();
+
 private:
 
     friend class ::FDA;
@@ -89,17 +136,29 @@ private:
     /// Indices of second atom (j)
     std::vector<std::vector<int>> indices;
 
+    /// Lookup of the position of j in indices
+    std::vector<PairIndex> pair_index;
+
     /// Indices of second atom (j)
     std::vector<std::vector<int>> scalar_indices;
 
+    /// Lookup of the position of j in scalar_indices
+    std::vector<PairIndex> scalar_pair_index;
+
     /// Scalar force pairs
     std::vector<std::vector<Force<real>>> scalar;
 
+    /// Running averages of the scalar force pairs
+    std::vector<std::vector<RunningAverage>> scalar_average;
+
+    /// Number of steps merged into scalar since the last clear_scalar
+    int scalar_steps;
+
     /// Summed vector force pairs
     std::vector<std::vector<Force<Vector>>> summed;
 
     /// Detailed force pairs
-    std::vector<std::vector<DetailedForce>> detailed;
+    std::vector<DetailedForceList> detailed;
 
     /// FDA settings
     FDASettings const& fda_settings;
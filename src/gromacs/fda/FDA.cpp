@@ -5,14 +5,18 @@
  *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
  */
 
+#include <exception>
 #include <limits>
 #include <sstream>
 #include "FDA.h"
+#include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/fileio/readinp.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/topology/symtab.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 #include "Utilities.h"
@@ -37,16 +41,21 @@ static int FDA_egp_flags[FDA_GROUP_DIM2] = {
     1, 1, 1, 1
 };
 
-FDA::FDA(fda::FDASettings const& fda_settings)
+FDA::FDA(fda::FDASettings const& fda_settings, bool master)
  : fda_settings(fda_settings),
    atom_based(fda_settings.atom_based_result_type,
               fda_settings.syslen_atoms,
-              fda_settings.atom_based_result_filename,
+              master ? fda_settings.atom_based_result_filename : "",
               fda_settings),
    residue_based(fda_settings.residue_based_result_type,
                  fda_settings.syslen_residues,
-                 fda_settings.residue_based_result_filename,
+                 master ? fda_settings.residue_based_result_filename : "",
                  fda_settings),
+   nonbonded_pair_buffers(1, fda::NonbondedPairBuffer(fda_settings)),
+   cr(nullptr),
+   domain_decomposition(false),
+   wcycle(nullptr),
+   fda_step(true),
    time_averaging_steps(0),
    time_averaging_com(nullptr),
    nsteps(0)
@@ -61,15 +70,30 @@ FDA::FDA(fda::FDASettings const& fda_settings)
 
 FDA::~FDA()
 {
-    atom_based.write_compat_header(nsteps);
-    residue_based.write_compat_header(nsteps);
+    // The errors of the background writer are rethrown when it is joined, they must not leave the destructor
+    try {
+        atom_based.write_compat_header(nsteps);
+        residue_based.write_compat_header(nsteps);
+        atom_based.write_binary_index();
+        residue_based.write_binary_index();
+    } catch (std::exception const& e) {
+        gmx_fatal(FARGS, "Error writing the FDA results: %s", e.what());
+    }
+}
+
+inline int FDA::global_atom(int i) const
+{
+    return domain_decomposition ? cr->dd->gatindex[i] : i;
 }
 
 void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force)
 {
+    int thread = gmx_omp_get_thread_num();
+
     // the calling functions will not have i == j, but there is not such guarantee for ri and rj;
     // and it makes no sense to look at the interaction of a residue to itself
     if (residue_based.PF_or_PS_mode()) {
+        DistributedForces& residue_distributed_forces = residue_based.local_distributed_forces(thread);
         int ri = fda_settings.get_atom2residue(i);
         int rj = fda_settings.get_atom2residue(j);
         rvec force_residue;
@@ -80,9 +104,9 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
                         int_swap(&ri, &rj);
                         clear_rvec(force_residue);
                         rvec_dec(force_residue, force);
-                        residue_based.distributed_forces.add_detailed(ri, rj, force_residue, to_pure(type));
+                        residue_distributed_forces.add_detailed(ri, rj, force_residue, to_pure(type));
                     } else {
-                        residue_based.distributed_forces.add_detailed(ri, rj, force, to_pure(type));
+                        residue_distributed_forces.add_detailed(ri, rj, force, to_pure(type));
                     }
                     break;
                 case fda::OnePair::SUMMED:
@@ -90,9 +114,9 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
                         int_swap(&ri, &rj);
                         clear_rvec(force_residue);
                         rvec_dec(force_residue, force);
-                        residue_based.distributed_forces.add_summed(ri, rj, force_residue, type);
+                        residue_distributed_forces.add_summed(ri, rj, force_residue, type);
                     } else {
-                        residue_based.distributed_forces.add_summed(ri, rj, force, type);
+                        residue_distributed_forces.add_summed(ri, rj, force, type);
                     }
                     break;
             }
@@ -100,16 +124,17 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
     }
 
     if (atom_based.PF_or_PS_mode()) {
+        DistributedForces& atom_distributed_forces = atom_based.local_distributed_forces(thread);
         if (i > j) {
             int_swap(&i, &j);
             rvec_opp(force);
         }
         switch(fda_settings.one_pair) {
             case fda::OnePair::DETAILED:
-                atom_based.distributed_forces.add_detailed(i, j, force, to_pure(type));
+                atom_distributed_forces.add_detailed(i, j, force, to_pure(type));
                 break;
             case fda::OnePair::SUMMED:
-                atom_based.distributed_forces.add_summed(i, j, force, type);
+                atom_distributed_forces.add_summed(i, j, force, type);
                 break;
         }
     }
@@ -118,7 +143,9 @@ void FDA::add_bonded_nocheck(int i, int j, fda::InteractionType type, rvec force
 void FDA::add_bonded(int i, int j, fda::InteractionType type, rvec force)
 {
     // leave early if the interaction is not interesting
-    if (!(fda_settings.type & type)) return;
+    if (!fda_step or !(fda_settings.type & type)) return;
+    i = global_atom(i);
+    j = global_atom(j);
     if (!fda_settings.atoms_in_groups(i, j)) return;
 
     add_bonded_nocheck(i, j, type, force);
@@ -127,7 +154,9 @@ void FDA::add_bonded(int i, int j, fda::InteractionType type, rvec force)
 void FDA::add_nonbonded_single(int i, int j, fda::InteractionType type, real force, real dx, real dy, real dz)
 {
     // leave early if the interaction is not interesting
-    if (!(fda_settings.type & type)) return;
+    if (!fda_step or !(fda_settings.type & type)) return;
+    i = global_atom(i);
+    j = global_atom(j);
     if (!fda_settings.atoms_in_groups(i, j)) return;
 
     rvec force_v;
@@ -142,6 +171,8 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
     real pf_lj_residue, pf_coul_residue, pf_lj_coul;
     rvec pf_lj_atom_v, pf_lj_residue_v, pf_coul_atom_v, pf_coul_residue_v;
 
+    if (!fda_step) return;
+
     /* first check that the interaction is interesting before doing expensive calculations and atom lookup*/
     if (!(fda_settings.type & fda::InteractionType_COULOMB))
         if (!(fda_settings.type & fda::InteractionType_LJ))
@@ -156,8 +187,12 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
             return;
         }
 
+    i = global_atom(i);
+    j = global_atom(j);
     if (!fda_settings.atoms_in_groups(i, j)) return;
 
+    int thread = gmx_omp_get_thread_num();
+
     /* checking is symmetrical for atoms i and j; one of them has to be from g1, the other one from g2
      * however, if only residue_based_result_type is non-zero, atoms won't be initialized... so the conversion to residue numebers needs to be done here already;
      * the check below makes the atoms equivalent, make them always have the same order (i,j) and not (j,i) where i < j;
@@ -168,6 +203,7 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
         /* the calling functions will not have i == j, but there is not such guarantee for ri and rj;
          * and it makes no sense to look at the interaction of a residue to itself
          */
+        DistributedForces& residue_distributed_forces = residue_based.local_distributed_forces(thread);
         int ri = fda_settings.get_atom2residue(i);
         int rj = fda_settings.get_atom2residue(j);
         if (ri != rj) {
@@ -185,18 +221,18 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
                     pf_coul_residue_v[0] = pf_coul_residue * dx;
                     pf_coul_residue_v[1] = pf_coul_residue * dy;
                     pf_coul_residue_v[2] = pf_coul_residue * dz;
-                    residue_based.distributed_forces.add_detailed(ri, rj, pf_coul_residue_v, fda::PureInteractionType::COULOMB);
+                    residue_distributed_forces.add_detailed(ri, rj, pf_coul_residue_v, fda::PureInteractionType::COULOMB);
                     pf_lj_residue_v[0] = pf_lj_residue * dx;
                     pf_lj_residue_v[1] = pf_lj_residue * dy;
                     pf_lj_residue_v[2] = pf_lj_residue * dz;
-                    residue_based.distributed_forces.add_detailed(ri, rj, pf_lj_residue_v, fda::PureInteractionType::LJ);
+                    residue_distributed_forces.add_detailed(ri, rj, pf_lj_residue_v, fda::PureInteractionType::LJ);
                     break;
                 case fda::OnePair::SUMMED:
                     pf_lj_coul = pf_lj_residue + pf_coul_residue;
                     pf_coul_residue_v[0] = pf_lj_coul * dx;
                     pf_coul_residue_v[1] = pf_lj_coul * dy;
                     pf_coul_residue_v[2] = pf_lj_coul * dz;
-                    residue_based.distributed_forces.add_summed(ri, rj, pf_coul_residue_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+                    residue_distributed_forces.add_summed(ri, rj, pf_coul_residue_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
                     break;
             }
         }
@@ -204,6 +240,7 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
 
     /* i & j as well as pf_lj & pf_coul are not used after this point, so it's safe to operate on their values directly */
     if (atom_based.PF_or_PS_mode()) {
+        DistributedForces& atom_distributed_forces = atom_based.local_distributed_forces(thread);
         if (i > j) {
             int tmp = j; j = i; i = tmp; // swap
             pf_lj = -pf_lj;
@@ -214,18 +251,18 @@ void FDA::add_nonbonded(int i, int j, real pf_coul, real pf_lj, real dx, real dy
                 pf_coul_atom_v[0] = pf_coul * dx;
                 pf_coul_atom_v[1] = pf_coul * dy;
                 pf_coul_atom_v[2] = pf_coul * dz;
-                atom_based.distributed_forces.add_detailed(i, j, pf_coul_atom_v, fda::PureInteractionType::COULOMB);
+                atom_distributed_forces.add_detailed(i, j, pf_coul_atom_v, fda::PureInteractionType::COULOMB);
                 pf_lj_atom_v[0] = pf_lj * dx;
                 pf_lj_atom_v[1] = pf_lj * dy;
                 pf_lj_atom_v[2] = pf_lj * dz;
-                atom_based.distributed_forces.add_detailed(i, j, pf_lj_atom_v, fda::PureInteractionType::LJ);
+                atom_distributed_forces.add_detailed(i, j, pf_lj_atom_v, fda::PureInteractionType::LJ);
                 break;
             case fda::OnePair::SUMMED:
                 pf_lj_coul = pf_lj + pf_coul;
                 pf_coul_atom_v[0] = pf_lj_coul * dx;
                 pf_coul_atom_v[1] = pf_lj_coul * dy;
                 pf_coul_atom_v[2] = pf_lj_coul * dz;
-                atom_based.distributed_forces.add_summed(i, j, pf_coul_atom_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
+                atom_distributed_forces.add_summed(i, j, pf_coul_atom_v, fda::InteractionType_COULOMB | fda::InteractionType_LJ);
                 break;
         }
     }
@@ -236,6 +273,8 @@ void FDA::add_angle(int ai, int aj, int ak, rvec f_i, rvec f_j, rvec f_k)
     rvec uf_i, uf_j, uf_k, f_j_i, f_j_k, f_i_k;
     real nf_j_i, nf_j_k;
 
+    if (!fda_step) return;
+
     // below computation can sometimes return before finishing to avoid division with very small numbers;
     // this situation can occur f.e. when all f_i, f_j, f_k and f_l are (almost) zero;
     // in this case there is no call to fda_add_bonded, no pairwise forces are recorded (which is different from recording zero forces!)
@@ -264,6 +303,8 @@ void FDA::add_dihedral(int i, int j, int k, int l, rvec f_i, rvec f_j, rvec f_k,
     real cos_a, sin_a, cos_b, sin_b, sinacosbpsinbcosa;
     real nf_ipl, nf_jpk, nf_j, nf_k, nf_j_i, nf_j_l, nf_k_i, nf_k_l, nf_jpkxnf_j, nf_jpkxnf_k, nf_jpk_i, nf_jpk_l;
 
+    if (!fda_step) return;
+
     // below computation can sometimes return before finishing to avoid division with very small numbers;
     // this situation can occur f.e. when all f_i, f_j, f_k and f_l are (almost) zero;
     // in this case there is no call to fda_add_bonded, no pairwise forces are recorded (which is different from recording zero forces!)
@@ -346,17 +387,18 @@ void FDA::add_virial(int ai, tensor v, real s)
     // Only symmetric tensor is used, therefore full multiplication is not as efficient
     // atom_vir[ai] += s * v;
 
-    atom_based.virial_stress[ai](XX, XX) += s * v[XX][XX];
-    atom_based.virial_stress[ai](YY, YY) += s * v[YY][YY];
-    atom_based.virial_stress[ai](ZZ, ZZ) += s * v[ZZ][ZZ];
-    atom_based.virial_stress[ai](XX, YY) += s * v[XX][YY];
-    atom_based.virial_stress[ai](XX, ZZ) += s * v[XX][ZZ];
-    atom_based.virial_stress[ai](YY, ZZ) += s * v[YY][ZZ];
+    Tensor& virial_stress = atom_based.local_virial_stress(gmx_omp_get_thread_num())[global_atom(ai)];
+    virial_stress(XX, XX) += s * v[XX][XX];
+    virial_stress(YY, YY) += s * v[YY][YY];
+    virial_stress(ZZ, ZZ) += s * v[ZZ][ZZ];
+    virial_stress(XX, YY) += s * v[XX][YY];
+    virial_stress(XX, ZZ) += s * v[XX][ZZ];
+    virial_stress(YY, ZZ) += s * v[YY][ZZ];
 }
 
 void FDA::add_virial_bond(int ai, int aj, real f, real dx, real dy, real dz)
 {
-    if (!atom_based.VS_mode()) return;
+    if (!fda_step or !atom_based.VS_mode()) return;
 
     tensor v;
     v[XX][XX] = dx * dx * f;
@@ -372,7 +414,7 @@ void FDA::add_virial_bond(int ai, int aj, real f, real dx, real dy, real dz)
 void FDA::add_virial_angle(int ai, int aj, int ak,
     rvec r_ij, rvec r_kj, rvec f_i, rvec f_k)
 {
-    if (!atom_based.VS_mode()) return;
+    if (!fda_step or !atom_based.VS_mode()) return;
 
     tensor v;
     v[XX][XX] = r_ij[XX] * f_i[XX] + r_kj[XX] * f_k[XX];
@@ -389,7 +431,7 @@ void FDA::add_virial_angle(int ai, int aj, int ak,
 void FDA::add_virial_dihedral(int i, int j, int k, int l,
     rvec f_i, rvec f_k, rvec f_l, rvec r_ij, rvec r_kj, rvec r_kl)
 {
-    if (!atom_based.VS_mode()) return;
+    if (!fda_step or !atom_based.VS_mode()) return;
 
     rvec r_lj;
     tensor v;
@@ -406,27 +448,110 @@ void FDA::add_virial_dihedral(int i, int j, int k, int l,
     add_virial(l, v, QUARTER);
 }
 
-void FDA::save_and_write_scalar_time_averages(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop)
+void FDA::set_nthreads(int nthreads)
+{
+    atom_based.set_nthreads(nthreads);
+    residue_based.set_nthreads(nthreads);
+    for (int i = nonbonded_pair_buffers.size(); i < nthreads; ++i)
+        nonbonded_pair_buffers.emplace_back(fda_settings);
+}
+
+void FDA::set_commrec(t_commrec const* cr)
+{
+    this->cr = cr;
+    domain_decomposition = DOMAINDECOMP(cr);
+    if (domain_decomposition and MASTER(cr))
+        printf("Note: FDA gathers the pairwise forces and the coordinates of all ranks on the master rank\n"
+               "      in every FDA step, i.e. every nstfda = %d steps, also when they are time averaged.\n", fda_settings.nstfda);
+}
+
+void FDA::set_nbnxn_atom_order(int const* cellInv, int natoms)
+{
+    nbnxn_group_masks.resize(natoms);
+    for (int i = 0; i < natoms; ++i) {
+        unsigned char mask = 0;
+        if (cellInv[i] >= 0) {
+            int gi = global_atom(cellInv[i]);
+            if (fda_settings.sys_in_group1[gi]) mask |= fda::NonbondedPairBuffer::group1_bit;
+            if (fda_settings.sys_in_group2[gi]) mask |= fda::NonbondedPairBuffer::group2_bit;
+        }
+        nbnxn_group_masks[i] = mask;
+    }
+}
+
+fda::NonbondedPairBuffer& FDA::nonbonded_pair_buffer(int thread)
+{
+    fda::NonbondedPairBuffer& buffer = nonbonded_pair_buffers[thread];
+    // gatindex is reallocated at repartitioning
+    buffer.set_global_atom_index(domain_decomposition ? cr->dd->gatindex : nullptr);
+    buffer.set_group_masks(nbnxn_group_masks.empty() ? nullptr : nbnxn_group_masks.data());
+    return buffer;
+}
+
+void FDA::flush_nonbonded_pair_buffer(int thread)
 {
+    fda::NonbondedPairBuffer& buffer = nonbonded_pair_buffers[thread];
+    for (size_t k = 0; k < buffer.size(); ++k) {
+        bool coul = std::abs(buffer.fcoul[k]) > fda::NonbondedPairBuffer::tiny_real_number;
+        bool vdw = std::abs(buffer.fvdw[k]) > fda::NonbondedPairBuffer::tiny_real_number;
+        if (coul and vdw)
+            add_nonbonded(buffer.i[k], buffer.j[k], buffer.fcoul[k], buffer.fvdw[k], buffer.dx[k], buffer.dy[k], buffer.dz[k]);
+        else if (coul)
+            add_nonbonded_single(buffer.i[k], buffer.j[k], fda::InteractionType_COULOMB, buffer.fcoul[k], buffer.dx[k], buffer.dy[k], buffer.dz[k]);
+        else
+            add_nonbonded_single(buffer.i[k], buffer.j[k], fda::InteractionType_LJ, buffer.fvdw[k], buffer.dx[k], buffer.dy[k], buffer.dz[k]);
+    }
+    buffer.clear();
+}
+
+void FDA::save_and_write_scalar_time_averages(gmx::HostVector<gmx::RVec> const& x)
+{
+    wallcycle_sub_start(wcycle, ewcsFDA_ACCUMULATE);
+
+    // Collect the contributions of all OpenMP threads
+    atom_based.reduce_threads();
+    residue_based.reduce_threads();
+
+    // Collect the contributions of all domain decomposition ranks, only the master rank writes.
+    // This is needed in every FDA step, also with time averaging, as the contributions to a pair
+    // can come from several ranks and the conversion into scalars is not linear.
+    if (domain_decomposition) {
+        atom_based.reduce_ranks(cr);
+        residue_based.reduce_ranks(cr);
+        if (!MASTER(cr)) {
+            wallcycle_sub_stop(wcycle, ewcsFDA_ACCUMULATE);
+            return;
+        }
+    }
+
     if (fda_settings.time_averaging_period != 1) {
         if (atom_based.PF_or_PS_mode())
             atom_based.distributed_forces.summed_merge_to_scalar(x);
         if (residue_based.PF_or_PS_mode()) {
-        	gmx::HostVector<gmx::RVec> com = get_residues_com(x, mtop);
+        	gmx::HostVector<gmx::RVec> com = get_residues_com(x);
             residue_based.distributed_forces.summed_merge_to_scalar(com);
             for (int i = 0; i != fda_settings.syslen_residues; ++i) {
                 rvec_inc(time_averaging_com[i], com[i]);
             }
         }
         ++time_averaging_steps;
-        if (fda_settings.time_averaging_period != 0 and time_averaging_steps >= fda_settings.time_averaging_period)
+        wallcycle_sub_stop(wcycle, ewcsFDA_ACCUMULATE);
+        if (fda_settings.time_averaging_period != 0 and time_averaging_steps >= fda_settings.time_averaging_period) {
+            wallcycle_sub_start(wcycle, ewcsFDA_WRITE);
             write_scalar_time_averages();
+            wallcycle_sub_stop(wcycle, ewcsFDA_WRITE);
+        }
     } else {
-        write_frame(x, mtop);
+        wallcycle_sub_stop(wcycle, ewcsFDA_ACCUMULATE);
+        wallcycle_sub_start(wcycle, ewcsFDA_WRITE);
+        write_frame(x);
+        wallcycle_sub_stop(wcycle, ewcsFDA_WRITE);
     }
     // Clear arrays for next frame
+    wallcycle_sub_start_nocount(wcycle, ewcsFDA_ACCUMULATE);
     atom_based.distributed_forces.clear();
     residue_based.distributed_forces.clear();
+    wallcycle_sub_stop(wcycle, ewcsFDA_ACCUMULATE);
 }
 
 void FDA::write_scalar_time_averages()
@@ -434,21 +559,25 @@ void FDA::write_scalar_time_averages()
     if (time_averaging_steps == 0) return;
 
     if (atom_based.PF_or_PS_mode()) {
-        atom_based.distributed_forces.scalar_real_divide(time_averaging_steps);
+        atom_based.distributed_forces.scalar_finalize_averages();
         if (atom_based.compatibility_mode())
             atom_based.write_frame_scalar_compat(nsteps);
+        else if (atom_based.result_type == fda::ResultType::PAIRWISE_FORCES_BINARY)
+            atom_based.write_frame_scalar_binary(nsteps);
         else
             atom_based.write_frame_scalar(nsteps);
         atom_based.distributed_forces.clear_scalar();
     }
 
     if (residue_based.PF_or_PS_mode()) {
-        residue_based.distributed_forces.scalar_real_divide(time_averaging_steps);
+        residue_based.distributed_forces.scalar_finalize_averages();
         //pf_x_real_div(time_averaging_com, fda_settings.syslen_residues, time_averaging_steps);
         for (size_t i = 0; i != residue_based.distributed_forces.scalar.size(); ++i)
             svdiv(time_averaging_steps, time_averaging_com[i]);
         if (residue_based.compatibility_mode())
             residue_based.write_frame_scalar_compat(nsteps);
+        else if (residue_based.result_type == fda::ResultType::PAIRWISE_FORCES_BINARY)
+            residue_based.write_frame_scalar_binary(nsteps);
         else
             residue_based.write_frame_scalar(nsteps);
         residue_based.distributed_forces.clear_scalar();
@@ -458,10 +587,10 @@ void FDA::write_scalar_time_averages()
     time_averaging_steps = 0;
 }
 
-void FDA::write_frame(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop)
+void FDA::write_frame(gmx::HostVector<gmx::RVec> const& x)
 {
     atom_based.write_frame(x, nsteps);
-    residue_based.write_frame(get_residues_com(x, mtop), nsteps);
+    if (residue_based.result_type != fda::ResultType::NO) residue_based.write_frame(get_residues_com(x), nsteps);
     ++nsteps;
 }
 
@@ -511,9 +640,9 @@ void FDA::modify_energy_group_exclusions(gmx_mtop_t *mtop, t_inputrec *inputrec)
         respect_charge_groups(mtop->groups.grpnr[egcENER],mtop);
 
         // Search FDA group names in mtop->groups (tpr-file)
-        int mtop_g1idx = add_name_to_energygrp("FDA1", &mtop->groups);
-        int mtop_g2idx = add_name_to_energygrp("FDA2", &mtop->groups);
-        int mtop_g3idx = add_name_to_energygrp("FDA12", &mtop->groups);
+        int mtop_g1idx = add_name_to_energygrp("FDA1", mtop);
+        int mtop_g2idx = add_name_to_energygrp("FDA2", mtop);
+        int mtop_g3idx = add_name_to_energygrp("FDA12", mtop);
         int mtop_rest_idx = get_index_in_energygrp("rest", &mtop->groups);
 
         #ifdef FDA_PRINT_DEBUG_ON
@@ -620,7 +749,7 @@ void FDA::modify_energy_group_exclusions(gmx_mtop_t *mtop, t_inputrec *inputrec)
         // Add additional group names
         for (int i = 0; i < inputrec->opts.ngener * (FDA_GROUP_DIM - 1); ++i) {
             sprintf(buffer, "FDA%d", i + inputrec->opts.ngener);
-            add_name_to_energygrp(buffer, &mtop->groups);
+            add_name_to_energygrp(buffer, mtop);
         }
 
         // Update lookup table energy group index to group index
@@ -685,64 +814,47 @@ void FDA::modify_energy_group_exclusions(gmx_mtop_t *mtop, t_inputrec *inputrec)
 
 }
 
-gmx::HostVector<gmx::RVec> FDA::get_residues_com(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop) const
+gmx::HostVector<gmx::RVec> FDA::get_residues_com(gmx::HostVector<gmx::RVec> const& x) const
 {
-    int moltype_index, mol_index, d;
-    int i, atom_index, atom_global_index, residue_global_index;
-    t_atoms *atoms;
-    t_atom *atom_info;
-    gmx_molblock_t *mb;
-    rvec r;
-
-    std::vector<real> mass(fda_settings.syslen_residues);
-    gmx::HostVector<gmx::RVec> com(fda_settings.syslen_residues);
+    std::vector<int> const& index = fda_settings.residue_atoms_index;
+    std::vector<int> const& atoms = fda_settings.residue_atoms;
+    std::vector<real> const& masses = fda_settings.residue_atom_masses;
 
-    for (i = 0; i < fda_settings.syslen_residues; i++) {
-        mass[i] = 0.0;
-        for (d = 0; d < DIM; d++)
-            com[i][d] = 0.0;
-    }
-
-    atom_global_index = 0;
-    for (moltype_index = 0; moltype_index < mtop->nmolblock; moltype_index++) {
-        mb = &mtop->molblock[moltype_index];
-        for (mol_index = 0; mol_index < mb->nmol; mol_index++) {
-        atoms = &mtop->moltype[mb->type].atoms;
-            for(atom_index = 0; atom_index < atoms->nr; atom_index++) {
-                if (fda_settings.atom_in_groups(atom_global_index)) {
-                    residue_global_index = fda_settings.atom_2_residue[atom_global_index];
-                    atom_info=&atoms->atom[atom_index];
-                    mass[residue_global_index] += atom_info->m;
-                    svmul(atom_info->m, x[atom_global_index], r);
-                    rvec_inc(com[residue_global_index], r);
-                }
-                atom_global_index++;
-            }
+    gmx::HostVector<gmx::RVec> com(fda_settings.syslen_residues);
+    for (int r = 0; r < fda_settings.syslen_residues; ++r) {
+        real cx = 0.0, cy = 0.0, cz = 0.0;
+        for (int k = index[r]; k < index[r + 1]; ++k) {
+            real m = masses[k];
+            gmx::RVec const& xa = x[atoms[k]];
+            cx += m * xa[XX];
+            cy += m * xa[YY];
+            cz += m * xa[ZZ];
         }
-    }
-
-    // There might be residues with no interesting atoms, so their mass would be set to the initial 0.0;
-    // float/double comparison can be tricky in general, but here it's used only to prevent division by 0
-    for (i = 0; i < fda_settings.syslen_residues; ++i) {
-        if (mass[i] != 0.0)
-            for (d = 0; d < DIM; d++)
-                com[i][d] /= mass[i];
+        // There might be residues with no interesting atoms, their center of mass stays at zero
+        real mass = fda_settings.residue_masses[r];
+        if (mass != 0.0) {
+            cx /= mass;
+            cy /= mass;
+            cz /= mass;
+        }
+        com[r][XX] = cx;
+        com[r][YY] = cy;
+        com[r][ZZ] = cz;
     }
 
     return com;
 }
 
-int FDA::add_name_to_energygrp(char const* name, gmx_groups_t* groups) const
+int FDA::add_name_to_energygrp(char const* name, gmx_mtop_t* mtop) const
 {
+    gmx_groups_t* groups = &mtop->groups;
     int index = groups->ngrpname;
     if (index == 255)
         gmx_fatal(FARGS, "FDA error: Limit of energy groups (256) exceeded.");
     groups->ngrpname += 1;
     srenew(groups->grpname, groups->ngrpname);
-    char **tmp1;
-    snew(tmp1,1);
-    tmp1[0] = strdup(&name[0]);
-    groups->grpname[index] = tmp1;
+    // The name must be in the symbol table to broadcast the topology to all ranks
+    groups->grpname[index] = put_symtab(&mtop->symtab, name);
     return index;
 }
 
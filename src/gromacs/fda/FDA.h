@@ -17,15 +17,20 @@
 #include "FDABase.h"
 #include "FDASettings.h"
 #include "gromacs/gpu_utils/hostallocator.h"
+#include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "InteractionType.h"
+#include "NonbondedPairBuffer.h"
 #include "PureInteractionType.h"
 
 class FDA {
 public:
 
     /// Default constructor
-    FDA(fda::FDASettings const& fda_settings = fda::FDASettings());
+    /// Only the master rank writes the result files
+    FDA(fda::FDASettings const& fda_settings = fda::FDASettings(), bool master = true);
 
     /// Destructor
     /// Write compat footer
@@ -94,6 +99,52 @@ public:
      */
     void add_virial_dihedral(int i, int j, int k, int l, rvec f_i, rvec f_k, rvec f_l, rvec r_ij, rvec r_kj, rvec r_kl);
 
+    /**
+     * Allocate thread-local buffers for the pairwise forces and the virial stress,
+     * such that the OpenMP threads of the nonbonded and listed-force kernels can
+     * accumulate concurrently; the buffers are reduced at each step in
+     * save_and_write_scalar_time_averages.
+     */
+    void set_nthreads(int nthreads);
+
+    /**
+     * Set the communication record of the rank. With domain decomposition the atom indices
+     * passed to the add functions are local and translated with gatindex, the pairwise forces
+     * of all ranks are gathered on the master rank in save_and_write_scalar_time_averages.
+     */
+    void set_commrec(t_commrec const* cr);
+
+    /**
+     * Set the cycle counter of mdrun. The reduction and time averaging of the pairwise forces
+     * are counted as ewcsFDA_ACCUMULATE, the output as ewcsFDA_WRITE.
+     */
+    void set_wallcycle(gmx_wallcycle_t wcycle) { this->wcycle = wcycle; }
+
+    /**
+     * Set the current MD step. Pairwise forces are only collected if the step is a multiple
+     * of nstfda, the add functions return immediately in all other steps.
+     */
+    void set_step(gmx_int64_t step) { fda_step = step % fda_settings.nstfda == 0; }
+
+    /// Returns true if the pairwise forces are collected in the current step
+    bool is_fda_step() const { return fda_step; }
+
+    /**
+     * Set the group masks of the atoms in the nbnxn ordering after each pair search.
+     * cellInv maps the natoms grid positions to the local atom indices (negative for filler particles).
+     * The SIMD kernels use the masks to skip all cluster pairs without a group1-group2 pair.
+     */
+    void set_nbnxn_atom_order(int const* cellInv, int natoms);
+
+    /// Pair buffer of an OpenMP thread, filled by the SIMD nonbonded kernels
+    fda::NonbondedPairBuffer& nonbonded_pair_buffer(int thread);
+
+    /**
+     * Add the pairs collected by the SIMD nonbonded kernels of an OpenMP thread
+     * and clear the buffer; is called after the kernel, outside of the inner loop.
+     */
+    void flush_nonbonded_pair_buffer(int thread);
+
     /**
      * Main function for scalar time averages; saves data and decides when to write it out
      *
@@ -102,7 +153,7 @@ public:
      * writing because for this fda->atoms would need to be initialized (to get the atom
      * number or to get the sys2ps mapping) which only happens when AtomBased is non-zero
      */
-    void save_and_write_scalar_time_averages(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop);
+    void save_and_write_scalar_time_averages(gmx::HostVector<gmx::RVec> const& x);
 
     /**
      * Write scalar time averages; this is similar to pf_write_frame, except that time averages are used
@@ -117,25 +168,33 @@ public:
      */
     void write_scalar_time_averages();
 
-    void write_frame(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop);
+    void write_frame(gmx::HostVector<gmx::RVec> const& x);
 
-    /// Main routine for FDA exclusions
+    /**
+     * Main routine for FDA exclusions of the group cutoff scheme.
+     * The Verlet scheme ignores energy group exclusions, the cluster pairs are
+     * restricted to the FDA groups with set_nbnxn_atom_order instead.
+     */
     void modify_energy_group_exclusions(gmx_mtop_t *mtop, t_inputrec *inputrec) const;
 
     fda::FDASettings get_settings() const { return fda_settings; }
 
 private:
 
+    /// Returns the global atom index of the local atom index i
+    inline int global_atom(int i) const;
+
     /**
      * Computes the COM for residues in system;
      * only the atoms for which sys_in_g is non-zero are considered, such that the COM might
      * not express the COM of the whole residue but the COM of the atoms of the residue which
-     * are interesting for PF
+     * are interesting for PF; the atoms and masses are taken from the residue lists of FDASettings,
+     * which are built once at setup
      */
-    gmx::HostVector<gmx::RVec> get_residues_com(gmx::HostVector<gmx::RVec> const& x, gmx_mtop_t *mtop) const;
+    gmx::HostVector<gmx::RVec> get_residues_com(gmx::HostVector<gmx::RVec> const& x) const;
 
     /// Append group to energy groups, returns the position index
-    int add_name_to_energygrp(char const* name, gmx_groups_t* groups) const;
+    int add_name_to_energygrp(char const* name, gmx_mtop_t* mtop) const;
 
     /// FDA groups must not be defined over complete charge groups.
     /// This group redefine the energy group array with respect to the charge groups.
@@ -156,6 +215,24 @@ private:
     /// Residue-based operation
     fda::FDABase<fda::Residue> residue_based;
 
+    /// Pair buffers of the SIMD nonbonded kernels, one for each OpenMP thread
+    std::vector<fda::NonbondedPairBuffer> nonbonded_pair_buffers;
+
+    /// Group masks of the atoms in the nbnxn ordering, see fda::NonbondedPairBuffer
+    std::vector<unsigned char> nbnxn_group_masks;
+
+    /// Communication record, nullptr for serial runs
+    t_commrec const* cr;
+
+    /// True if the atoms are distributed with domain decomposition
+    bool domain_decomposition;
+
+    /// Cycle counter of mdrun, nullptr if not set
+    gmx_wallcycle_t wcycle;
+
+    /// True if the current step is a multiple of nstfda
+    bool fda_step;
+
     /// Counter for current step, incremented for every call of pf_save_and_write_scalar_averages()
     /// When it reaches time_averages_steps, data is written
     int time_averaging_steps;
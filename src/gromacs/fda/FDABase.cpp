@@ -9,9 +9,12 @@
 #include <iomanip>
 #include <iostream>
 #include "FDABase.h"
+#include "gromacs/domdec/domdec_network.h"
+#include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/futil.h"
 #include "PureInteractionType.h"
+#include "TextWriter.h"
 #include "Utilities.h"
 
 namespace fda {
@@ -22,17 +25,138 @@ FDABase<Base>::FDABase(ResultType result_type, int syslen, std::string const& re
    result_type(result_type),
    syslen(syslen),
    distributed_forces(syslen, fda_settings),
-   result_file(result_filename),
-   fda_settings(fda_settings)
+   fda_settings(fda_settings),
+   writer_distributed_forces(fda_settings.async_output ? syslen : 0, fda_settings)
 {
+    if (PF_or_PS_mode() and !result_filename.empty()) make_backup(result_filename.c_str());
+    if (result_type == ResultType::PAIRWISE_FORCES_BINARY) {
+        result_file.open(result_filename, std::ios::out | std::ios::binary);
+        if (result_file) binary_writer.reset(new BinaryPairwiseForcesWriter(result_file, syslen, fda_settings.binary_precision));
+    } else {
+        result_file.open(result_filename);
+        if (fda_settings.compress_output and result_file.is_open()) {
+            result_compressor.reset(new CompressingStreamBuffer(result_file.rdbuf()));
+            static_cast<std::ostream&>(result_file).rdbuf(result_compressor.get());
+        }
+    }
     result_file << std::scientific << std::setprecision(6);
-    if (PF_or_PS_mode()) make_backup(result_filename.c_str());
     write_compat_header(1);
+
+    if (fda_settings.time_averaging_stddev and PF_or_PS_mode() and !result_filename.empty()) {
+        std::string stddev_filename = fda_settings.stddev_filename(result_filename);
+        make_backup(stddev_filename.c_str());
+        if (result_type == ResultType::PAIRWISE_FORCES_BINARY) {
+            stddev_file.open(stddev_filename, std::ios::out | std::ios::binary);
+            if (stddev_file) stddev_binary_writer.reset(new BinaryPairwiseForcesWriter(stddev_file, syslen, fda_settings.binary_precision));
+        } else {
+            stddev_file.open(stddev_filename);
+            if (fda_settings.compress_output and stddev_file.is_open()) {
+                stddev_compressor.reset(new CompressingStreamBuffer(stddev_file.rdbuf()));
+                static_cast<std::ostream&>(stddev_file).rdbuf(stddev_compressor.get());
+            }
+        }
+        stddev_file << std::scientific << std::setprecision(6);
+    }
+}
+
+template <class Base>
+void FDABase<Base>::set_nthreads(int nthreads)
+{
+    thread_distributed_forces.clear();
+    if (PF_or_PS_mode()) {
+        thread_distributed_forces.reserve(nthreads - 1);
+        for (int t = 1; t < nthreads; ++t) thread_distributed_forces.emplace_back(syslen, distributed_forces.fda_settings);
+    }
+    if (VS_mode()) Base::set_nthreads_virial_stress(nthreads);
+}
+
+template <class Base>
+void FDABase<Base>::reduce_threads()
+{
+    for (auto& thread_distributed_forces_t : thread_distributed_forces) {
+        distributed_forces.add(thread_distributed_forces_t);
+        thread_distributed_forces_t.clear();
+    }
+    // The order of first appearance depends on the distribution of the work over the threads
+    if (PF_or_PS_mode() and !thread_distributed_forces.empty()) distributed_forces.sort_pairs();
+    Base::reduce_virial_stress();
+}
+
+template <class Base>
+void FDABase<Base>::reduce_ranks(t_commrec const* cr)
+{
+    gmx_domdec_t *dd = cr->dd;
+
+    if (PF_or_PS_mode()) {
+        std::vector<char> buffer;
+        distributed_forces.serialize(buffer);
+        int size = buffer.size();
+
+        std::vector<int> sizes(DDMASTER(dd) ? dd->nnodes : 0);
+        dd_gather(dd, sizeof(int), &size, sizes.data());
+
+        std::vector<int> displacements(sizes.size());
+        std::vector<char> received;
+        if (DDMASTER(dd)) {
+            for (size_t rank = 1; rank < sizes.size(); ++rank)
+                displacements[rank] = displacements[rank - 1] + sizes[rank - 1];
+            received.resize(displacements.back() + sizes.back());
+        }
+        dd_gatherv(dd, size, buffer.data(), sizes.data(), displacements.data(), received.data());
+
+        if (DDMASTER(dd)) {
+            for (int rank = 0; rank < dd->nnodes; ++rank) {
+                if (rank == dd->masterrank) continue;
+                distributed_forces.add_serialized(received.data() + displacements[rank], sizes[rank]);
+            }
+            distributed_forces.sort_pairs();
+        } else {
+            distributed_forces.clear();
+        }
+    }
+    if (VS_mode()) Base::reduce_virial_stress_ranks(cr);
+}
+
+template <class Base>
+void FDABase<Base>::wait_for_writer()
+{
+    if (pending_write.valid()) pending_write.get();
+}
+
+template <class Base>
+template <class Function>
+void FDABase<Base>::write_in_background(Function write)
+{
+    wait_for_writer();
+    writer_distributed_forces.swap(distributed_forces);
+    pending_write = std::async(std::launch::async, [this, write]{
+        write(writer_distributed_forces);
+        writer_distributed_forces.clear();
+        writer_distributed_forces.clear_scalar();
+    });
 }
 
 template <class Base>
 void FDABase<Base>::write_frame(gmx::HostVector<gmx::RVec> const& x, int nsteps)
 {
+    if (async_output()) {
+        wait_for_writer();
+        writer_x = x;
+        write_in_background([this, nsteps](DistributedForces& forces){ write_frame(forces, writer_x, nsteps); });
+    } else {
+        write_frame(distributed_forces, x, nsteps);
+    }
+}
+
+template <class Base>
+void FDABase<Base>::write_frame(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, int nsteps)
+{
+    if (result_type == ResultType::PAIRWISE_FORCES_VECTOR)
+        forces.filter_pairs(x, true);
+    else if (result_type == ResultType::PAIRWISE_FORCES_SCALAR or result_type == ResultType::PAIRWISE_FORCES_BINARY)
+        forces.filter_pairs(x, false);
+    if (fda_settings.sort_pairs) forces.sort_pairs();
+
     switch (fda_settings.one_pair) {
         case OnePair::DETAILED:
             switch (result_type) {
@@ -40,10 +164,13 @@ void FDABase<Base>::write_frame(gmx::HostVector<gmx::RVec> const& x, int nsteps)
                     // do nothing
                     break;
                 case ResultType::PAIRWISE_FORCES_VECTOR:
-                    write_frame_detailed(x, true, nsteps);
+                    write_frame_detailed(forces, x, true, nsteps);
                     break;
                 case ResultType::PAIRWISE_FORCES_SCALAR:
-                    write_frame_detailed(x, false, nsteps);
+                    write_frame_detailed(forces, x, false, nsteps);
+                    break;
+                case ResultType::PAIRWISE_FORCES_BINARY:
+                    write_frame_binary(forces, x, nsteps);
                     break;
                 case ResultType::PUNCTUAL_STRESS:
                     gmx_fatal(FARGS, "Punctual stress is not supported for detailed output.\n");
@@ -68,13 +195,16 @@ void FDABase<Base>::write_frame(gmx::HostVector<gmx::RVec> const& x, int nsteps)
                     // do nothing
                     break;
                 case ResultType::PAIRWISE_FORCES_VECTOR:
-                    write_frame_summed(x, true, nsteps);
+                    write_frame_summed(forces, x, true, nsteps);
                     break;
                 case ResultType::PAIRWISE_FORCES_SCALAR:
-                    write_frame_summed(x, false, nsteps);
+                    write_frame_summed(forces, x, false, nsteps);
+                    break;
+                case ResultType::PAIRWISE_FORCES_BINARY:
+                    write_frame_binary(forces, x, nsteps);
                     break;
                 case ResultType::PUNCTUAL_STRESS:
-                    write_total_forces(x);
+                    write_total_forces(forces, x);
                     break;
                 case ResultType::VIRIAL_STRESS:
                     write_virial_sum();
@@ -94,36 +224,95 @@ void FDABase<Base>::write_frame(gmx::HostVector<gmx::RVec> const& x, int nsteps)
 }
 
 template <class Base>
-void FDABase<Base>::write_frame_detailed(gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps)
+void FDABase<Base>::write_frame_detailed(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps)
 {
-    result_file << "frame " << nsteps << std::endl;
+    result_file << "frame " << nsteps << '\n';
     if (print_vector)
-        distributed_forces.write_detailed_vector(result_file);
+        forces.write_detailed_vector(result_file);
     else
-        distributed_forces.write_detailed_scalar(result_file, x);
+        forces.write_detailed_scalar(result_file, x);
 }
 
 template <class Base>
-void FDABase<Base>::write_frame_summed(gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps)
+void FDABase<Base>::write_frame_summed(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps)
 {
-    result_file << "frame " << nsteps << std::endl;
+    result_file << "frame " << nsteps << '\n';
     if (print_vector)
-        distributed_forces.write_summed_vector(result_file);
+        forces.write_summed_vector(result_file);
     else
-        distributed_forces.write_summed_scalar(result_file, x);
+        forces.write_summed_scalar(result_file, x);
 }
 
 template <class Base>
 void FDABase<Base>::write_frame_scalar(int nsteps)
 {
-    result_file << "frame " << nsteps << std::endl;
-    distributed_forces.write_scalar(result_file);
+    if (async_output())
+        write_in_background([this, nsteps](DistributedForces& forces){ write_frame_scalar(forces, nsteps); });
+    else
+        write_frame_scalar(distributed_forces, nsteps);
+}
+
+template <class Base>
+void FDABase<Base>::write_frame_scalar(DistributedForces& forces, int nsteps)
+{
+    forces.filter_scalar_pairs();
+    if (fda_settings.sort_pairs) forces.sort_scalar_pairs();
+    result_file << "frame " << nsteps << '\n';
+    forces.write_scalar(result_file);
+    if (stddev_file.is_open()) {
+        stddev_file << "frame " << nsteps << '\n';
+        forces.write_scalar_stddev(stddev_file);
+    }
+}
+
+template <class Base>
+void FDABase<Base>::write_frame_binary(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, int nsteps)
+{
+    if (!binary_writer) return;
+    std::vector<BinaryPairwiseForce> pairwise_forces;
+    if (fda_settings.one_pair == OnePair::SUMMED)
+        forces.summed_to_binary(pairwise_forces, x);
+    else
+        forces.detailed_to_binary(pairwise_forces, x);
+    binary_writer->write_frame(nsteps, pairwise_forces);
+}
+
+template <class Base>
+void FDABase<Base>::write_frame_scalar_binary(int nsteps)
+{
+    if (async_output())
+        write_in_background([this, nsteps](DistributedForces& forces){ write_frame_scalar_binary(forces, nsteps); });
+    else
+        write_frame_scalar_binary(distributed_forces, nsteps);
+}
+
+template <class Base>
+void FDABase<Base>::write_frame_scalar_binary(DistributedForces& forces, int nsteps)
+{
+    if (!binary_writer) return;
+    forces.filter_scalar_pairs();
+    std::vector<BinaryPairwiseForce> pairwise_forces;
+    forces.scalar_to_binary(pairwise_forces);
+    binary_writer->write_frame(nsteps, pairwise_forces);
+    if (stddev_binary_writer) {
+        pairwise_forces.clear();
+        forces.scalar_stddev_to_binary(pairwise_forces);
+        stddev_binary_writer->write_frame(nsteps, pairwise_forces);
+    }
+}
+
+template <class Base>
+void FDABase<Base>::write_binary_index()
+{
+    wait_for_writer();
+    if (binary_writer) binary_writer->write_index();
+    if (stddev_binary_writer) stddev_binary_writer->write_index();
 }
 
 template <class Base>
-void FDABase<Base>::write_total_forces(gmx::HostVector<gmx::RVec> const& x)
+void FDABase<Base>::write_total_forces(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x)
 {
-    distributed_forces.write_total_forces(result_file, x);
+    forces.write_total_forces(result_file, x);
 }
 
 template <class Base>
@@ -150,6 +339,7 @@ void FDABase<Base>::write_compat_header(int nsteps)
 template <class Base>
 void FDABase<Base>::write_frame_scalar_compat(int nsteps)
 {
+    if (fda_settings.sort_pairs) distributed_forces.sort_scalar_pairs();
     if (result_type == ResultType::COMPAT_ASCII) {
         result_file << "<begin_block>" << std::endl;
         result_file << nsteps << std::endl;
@@ -178,14 +368,15 @@ void FDABase<Base>::write_frame_summed_compat(gmx::HostVector<gmx::RVec> const&
 template <>
 void FDABase<Atom>::write_virial_sum()
 {
+    TextWriter writer(result_file);
     bool first = true;
     for (auto const& v : virial_stress) {
-        if (!first) result_file << " ";
+        if (!first) writer << " ";
         else first = false;
-        result_file << -v(XX, XX) << " " << -v(YY, YY) << " " << -v(ZZ, ZZ) << " "
-                    << -v(XX, YY) << " " << -v(XX, ZZ) << " " << -v(YY, ZZ);
+        writer << -v(XX, XX) << " " << -v(YY, YY) << " " << -v(ZZ, ZZ) << " "
+               << -v(XX, YY) << " " << -v(XX, ZZ) << " " << -v(YY, ZZ);
     }
-    result_file << std::endl;
+    writer << '\n';
 }
 
 template <>
@@ -204,13 +395,14 @@ real tensor_to_vonmises(Tensor t)
 template <>
 void FDABase<Atom>::write_virial_sum_von_mises()
 {
+    TextWriter writer(result_file);
     bool first = true;
     for (auto const& v : virial_stress) {
-        if (!first) result_file << " ";
+        if (!first) writer << " ";
         else first = false;
-        result_file << tensor_to_vonmises(v);
+        writer << tensor_to_vonmises(v);
     }
-    result_file << std::endl;
+    writer << '\n';
 }
 
 template <>
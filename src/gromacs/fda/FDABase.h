@@ -10,10 +10,16 @@
 
 #include <iostream>
 #include <fstream>
+#include <future>
+#include <memory>
 #include <vector>
+#include "BinaryPairwiseForces.h"
+#include "CompressedStream.h"
 #include "FDASettings.h"
 #include "DistributedForces.h"
 #include "gromacs/gpu_utils/hostallocator.h"
+#include "gromacs/gmxlib/network.h"
+#include "gromacs/mdtypes/commrec.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/fatalerror.h"
 #include "OnePair.h"
@@ -34,14 +40,54 @@ struct Atom
      : virial_stress(VS_mode ? syslen : 0)
     {}
 
+    /// Allocate virial stress buffers for the OpenMP threads 1..nthreads-1
+    void set_nthreads_virial_stress(int nthreads)
+    {
+        thread_virial_stress.assign(nthreads - 1, std::vector<Tensor>(virial_stress.size()));
+    }
+
+    /// Virial stress of the calling OpenMP thread
+    std::vector<Tensor>& local_virial_stress(int thread)
+    {
+        return thread == 0 ? virial_stress : thread_virial_stress[thread - 1];
+    }
+
+    /// Add virial stress of all threads in order of the thread index and clear them
+    void reduce_virial_stress()
+    {
+        for (auto& thread_virial_stress_t : thread_virial_stress) {
+            for (size_t i = 0; i != virial_stress.size(); ++i) {
+                virial_stress[i] += thread_virial_stress_t[i];
+                thread_virial_stress_t[i] = Tensor();
+            }
+        }
+    }
+
+    /// Sum the virial stress of all ranks on the master rank, the atoms are distributed over the domains
+    void reduce_virial_stress_ranks(t_commrec const* cr)
+    {
+        if (virial_stress.empty()) return;
+        gmx_sum(9 * virial_stress.size(), &virial_stress[0](XX, XX), cr);
+        if (!MASTER(cr)) virial_stress.assign(virial_stress.size(), Tensor());
+    }
+
     /// Virial stress
     std::vector<Tensor> virial_stress;
+
+    /// Virial stress of the OpenMP threads 1..nthreads-1
+    std::vector<std::vector<Tensor>> thread_virial_stress;
 };
 
 /// Type for residue-based forces
 struct Residue
 {
     Residue(bool, int) {}
+
+    void set_nthreads_virial_stress(int) {}
+
+    void reduce_virial_stress() {}
+
+    void reduce_virial_stress_ranks(t_commrec const*) {}
 };
 
 /**
@@ -71,6 +117,7 @@ public:
     bool PF_or_PS_mode() const {
         return result_type == ResultType::PAIRWISE_FORCES_VECTOR or
                result_type == ResultType::PAIRWISE_FORCES_SCALAR or
+               result_type == ResultType::PAIRWISE_FORCES_BINARY or
                result_type == ResultType::PUNCTUAL_STRESS;
     }
 
@@ -79,17 +126,65 @@ public:
                result_type == ResultType::VIRIAL_STRESS_VON_MISES;
     }
 
+    /**
+     * Allocate thread-local buffers for the OpenMP threads 1..nthreads-1;
+     * thread 0 accumulates directly into distributed_forces
+     */
+    void set_nthreads(int nthreads);
+
+    /// Distributed forces of the calling OpenMP thread
+    DistributedForces& local_distributed_forces(int thread) {
+        return thread == 0 ? distributed_forces : thread_distributed_forces[thread - 1];
+    }
+
+    /**
+     * Add the thread-local buffers into distributed_forces in order of the thread index and clear them.
+     * With more than one thread the pairs of each row are then ordered by the second index j.
+     * For a fixed number of threads the result is bit-identical between runs, and the order of the pairs
+     * is the same for any number of threads larger than one. The forces of different numbers of threads
+     * can differ in the last digits, as the summation order of the contributions to a pair depends on
+     * the distribution of the interactions over the threads. With a single thread the pairs keep the
+     * order of their first appearance.
+     */
+    void reduce_threads();
+
+    /**
+     * Gather the pairwise forces and the virial stress of all domain decomposition ranks
+     * on the master rank, where the output is written; the ranks are added in order of
+     * the rank index, the pairs are ordered by j as in reduce_threads, and the buffers
+     * of the other ranks are cleared; the result is bit-identical for a fixed number of ranks and threads
+     */
+    void reduce_ranks(t_commrec const* cr);
+
+    /**
+     * Write the pairwise forces of the current step. With async_output the forces are
+     * swapped with a spare buffer and written by a background thread, such that MD can
+     * continue; the previous frame must be written before.
+     */
     void write_frame(gmx::HostVector<gmx::RVec> const& x, int nsteps);
 
-    void write_frame_detailed(gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps);
+    void write_frame_detailed(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps);
 
-    void write_frame_summed(gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps);
+    void write_frame_summed(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, bool print_vector, int nsteps);
 
+    /// Write the time averaged scalar forces, in the background with async_output
     void write_frame_scalar(int nsteps);
 
+    /// Write the summed or detailed forces as signed scalars in binary format
+    void write_frame_binary(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, int nsteps);
+
+    /// Write the time averaged scalar forces in binary format, in the background with async_output
+    void write_frame_scalar_binary(int nsteps);
+
+    /// Append the frame index to the binary file, is called when the file is closed
+    void write_binary_index();
+
     void sum_total_forces(gmx::HostVector<gmx::RVec> const& x);
 
-    void write_total_forces(gmx::HostVector<gmx::RVec> const& x);
+    void write_total_forces(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x);
+
+    /// Wait until the writer thread has written the last frame, rethrows its exceptions
+    void wait_for_writer();
 
     /**
      * Writes a header as in original PF implementation;
@@ -115,6 +210,21 @@ private:
 
     friend class ::FDA;
 
+    /// Returns true if the frames are written by a background thread
+    bool async_output() const {
+        return fda_settings.async_output and PF_or_PS_mode();
+    }
+
+    void write_frame(DistributedForces& forces, gmx::HostVector<gmx::RVec> const& x, int nsteps);
+
+    void write_frame_scalar(DistributedForces& forces, int nsteps);
+
+    void write_frame_scalar_binary(DistributedForces& forces, int nsteps);
+
+    /// Swap distributed_forces with the spare buffer and call write(forces) in a background thread
+    template <class Function>
+    void write_in_background(Function write);
+
     /// Result type
     ResultType result_type;
 
@@ -124,12 +234,38 @@ private:
     /// Distributed forces
     DistributedForces distributed_forces;
 
+    /// Distributed forces of the OpenMP threads 1..nthreads-1
+    std::vector<DistributedForces> thread_distributed_forces;
+
     /// Result file
     std::ofstream result_file;
 
+    /// Writer for binary output, only allocated for PAIRWISE_FORCES_BINARY
+    std::unique_ptr<BinaryPairwiseForcesWriter> binary_writer;
+
+    /// Standard deviations of the time averages, only opened if time_averaging_stddev is set
+    std::ofstream stddev_file;
+
+    /// Writer for the binary standard deviations
+    std::unique_ptr<BinaryPairwiseForcesWriter> stddev_binary_writer;
+
+    /// Compressors of the text result files, only allocated with compress_output.
+    /// Declared after the files to finish the gzip streams before the files are closed.
+    std::unique_ptr<CompressingStreamBuffer> result_compressor;
+    std::unique_ptr<CompressingStreamBuffer> stddev_compressor;
+
     /// For atom/residue unrelated settings
     FDASettings fda_settings;
 
+    /// Spare buffer, holds the frame which is written by the background thread
+    DistributedForces writer_distributed_forces;
+
+    /// Coordinates of the frame which is written by the background thread
+    gmx::HostVector<gmx::RVec> writer_x;
+
+    /// Frame written by the background thread, declared last to be waited for before the files are closed
+    std::future<void> pending_write;
+
 };
 
 } // namespace fda
@@ -7,6 +7,7 @@
 
 #include <set>
 #include <sstream>
+#include "CompressedStream.h"
 #include "FDASettings.h"
 #include "gromacs/fileio/readinp.h"
 #include "gromacs/fileio/warninp.h"
@@ -22,16 +23,24 @@ const std::string FDASettings::compat_fm_version = "1.5";
 
 const int FDASettings::compat_new_entry = -280480;
 
-FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool parallel_execution)
+FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop)
  : atom_based_result_type(ResultType::NO),
    residue_based_result_type(ResultType::NO),
    one_pair(OnePair::DETAILED),
    v2s(Vector2Scalar::NORM),
    residues_renumber(ResiduesRenumber::AUTO),
    no_end_zeros(false),
+   sort_pairs(false),
+   force_threshold(0.0),
+   top_k_pairs(0),
    syslen_atoms(mtop->natoms),
    syslen_residues(0),
    time_averaging_period(1),
+   time_averaging_stddev(false),
+   nstfda(1),
+   async_output(false),
+   compress_output(false),
+   binary_precision(0.0),
    sys_in_group1(syslen_atoms, 0),
    sys_in_group2(syslen_atoms, 0),
    type(InteractionType_NONE),
@@ -42,10 +51,6 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
    groups(nullptr),
    groupnames(nullptr)
 {
-    /// Parallel execution not implemented yet
-    if (parallel_execution)
-        gmx_fatal(FARGS, "FDA parallel execution not implemented yet! Please start with '-nt 1' on the mdrun command line\n");
-
     // check for the pf configuration file (specified with -pfi option);
     // if it doesn't exist, return NULL to specify that no pf handling is done;
     // otherwise, check also for specification of the index file (-pfn)
@@ -99,6 +104,19 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
 
     no_end_zeros = strcasecmp(get_estr(&ninp, &inp, "no_end_zeros", "no"), "no");
 
+    sort_pairs = strcasecmp(get_estr(&ninp, &inp, "sort_pairs", "no"), "no");
+
+    // Read filter for the written pairs
+    force_threshold = get_ereal(&ninp, &inp, "force_threshold", 0.0, wi);
+    if (force_threshold < 0.0)
+        gmx_fatal(FARGS, "Invalid value for force_threshold: %g\n", force_threshold);
+    top_k_pairs = get_eint(&ninp, &inp, "top_k_pairs", 0, wi);
+    if (top_k_pairs < 0)
+        gmx_fatal(FARGS, "Invalid value for top_k_pairs: %d\n", top_k_pairs);
+    if ((force_threshold != 0.0 or top_k_pairs != 0) and
+        (compatibility_mode(atom_based_result_type) or compatibility_mode(residue_based_result_type)))
+        gmx_fatal(FARGS, "force_threshold and top_k_pairs are not supported in compatibility mode.\n");
+
     if ((compatibility_mode(atom_based_result_type) or compatibility_mode(residue_based_result_type)) and v2s != Vector2Scalar::NORM)
         gmx_fatal(FARGS, "When using compat mode, pf_vector2scalar should be set to norm.\n");
 
@@ -142,6 +160,9 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
     fill_atom2residue(mtop);
 
     // Set sys_in_group arrays
+    if (PF_or_PS_mode(atom_based_result_type)) sys2pf_atoms.assign(syslen_atoms, -1);
+    if (PF_or_PS_mode(residue_based_result_type)) sys2pf_residues.assign(syslen_residues, -1);
+    int pf_atoms = 0, pf_residues = 0;
     for (int i = 0; i != groups->nr; ++i) {
         std::vector<int> group_atoms;
         if (group_names[i] == name_group1) {
@@ -153,14 +174,40 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
             for (auto g : group_atoms) sys_in_group2[g] = 1;
         }
         if (PF_or_PS_mode(atom_based_result_type)) {
-            for (auto g : group_atoms) sys2pf_atoms[g] = sys2pf_atoms.size();
+            for (auto g : group_atoms) if (sys2pf_atoms[g] == -1) sys2pf_atoms[g] = pf_atoms++;
         }
         if (PF_or_PS_mode(residue_based_result_type)) {
             std::vector<int> group_residues = groupatoms2residues(group_atoms);
-            for (auto g : group_residues) sys2pf_residues[g] = sys2pf_residues.size();
+            for (auto g : group_residues) if (sys2pf_residues[g] == -1) sys2pf_residues[g] = pf_residues++;
         }
     }
 
+    // Atoms of the residues for the centers of mass
+    fill_residue_atoms(mtop);
+
+    // Read output stride
+    nstfda = get_eint(&ninp, &inp, "nstfda", 1, wi);
+    if (nstfda < 1)
+        gmx_fatal(FARGS, "Invalid value for nstfda: %d\n", nstfda);
+
+    // Write the frames in a background thread
+    async_output = strcasecmp(get_estr(&ninp, &inp, "async_output", "no"), "no");
+
+    // Compress the text result files
+    compress_output = strcasecmp(get_estr(&ninp, &inp, "compress_output", "no"), "no");
+    if (compress_output) {
+        if (!compression_available())
+            gmx_fatal(FARGS, "Compressed FDA output needs zlib, which was not found when GROMACS was configured.\n");
+        if (compatibility_mode(atom_based_result_type) or compatibility_mode(residue_based_result_type) or
+            atom_based_result_type == ResultType::PAIRWISE_FORCES_BINARY or residue_based_result_type == ResultType::PAIRWISE_FORCES_BINARY)
+            gmx_fatal(FARGS, "Compressed FDA output is only supported for text result files.\n");
+    }
+
+    // Read precision of compressed binary output
+    binary_precision = get_ereal(&ninp, &inp, "binary_precision", 0.0, wi);
+    if (binary_precision < 0.0)
+        gmx_fatal(FARGS, "Invalid value for binary_precision: %g\n", binary_precision);
+
     // Read time averaging period
     time_averaging_period = get_eint(&ninp, &inp, "time_averages_period", 1, wi);
     if (time_averaging_period < 0)
@@ -171,15 +218,25 @@ FDASettings::FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool
         if (one_pair != OnePair::SUMMED)
             gmx_fatal(FARGS, "Can only save scalar time averages from summed interactions.\n");
         if (PF_or_PS_mode(atom_based_result_type)) {
-            if (!(compatibility_mode(atom_based_result_type) or atom_based_result_type == ResultType::PAIRWISE_FORCES_SCALAR))
+            if (!(compatibility_mode(atom_based_result_type) or atom_based_result_type == ResultType::PAIRWISE_FORCES_SCALAR or
+                  atom_based_result_type == ResultType::PAIRWISE_FORCES_BINARY))
                 gmx_fatal(FARGS, "Can only use time averages with scalar or compatibility output.\n");
         }
         if (PF_or_PS_mode(residue_based_result_type)) {
-            if (!(compatibility_mode(residue_based_result_type) or residue_based_result_type == ResultType::PAIRWISE_FORCES_SCALAR))
+            if (!(compatibility_mode(residue_based_result_type) or residue_based_result_type == ResultType::PAIRWISE_FORCES_SCALAR or
+                  residue_based_result_type == ResultType::PAIRWISE_FORCES_BINARY))
                 gmx_fatal(FARGS, "Can only use time averages with scalar or compatibility output.\n");
         }
     }
 
+    time_averaging_stddev = strcasecmp(get_estr(&ninp, &inp, "time_averages_stddev", "no"), "no");
+    if (time_averaging_stddev) {
+        if (time_averaging_period == 1)
+            gmx_fatal(FARGS, "Standard deviations of the time averages need time_averages_period != 1.\n");
+        if (compatibility_mode(atom_based_result_type) or compatibility_mode(residue_based_result_type))
+            gmx_fatal(FARGS, "Standard deviations of the time averages are not supported in compatibility mode.\n");
+    }
+
     // Check if groups are defined for PF/PF mode
     if (PF_or_PS_mode(atom_based_result_type) or PF_or_PS_mode(residue_based_result_type)) {
         if (sys_in_group1.empty() or sys_in_group2.empty())
@@ -254,6 +311,7 @@ void FDASettings::fill_atom2residue(gmx_mtop_t *mtop)
 
     int atom_global_index = 0;
     int renum = 0; //< renumbered residue nr.; increased monotonically, so could theoretically be as large as the nr. of atoms => type int
+    int residue_offset = 0; //< number of residues of the previous molecules, same as in get_global_residue_number
     bool bResnrCollision = false;
     for (int moltype_index = 0; moltype_index < mtop->nmolblock; ++moltype_index) {
         mb = &mtop->molblock[moltype_index];
@@ -262,7 +320,7 @@ void FDASettings::fill_atom2residue(gmx_mtop_t *mtop)
             for (int atom_index = 0; atom_index < atoms->nr; ++atom_index) {
                 atom_info = &atoms->atom[atom_index];
                 int resnr = atoms->resinfo[atom_info->resind].nr;
-                renum = get_global_residue_number(mtop, atom_global_index);
+                renum = residue_offset + atom_info->resind;
                 if ((resnr2renum[resnr] != renum) && (resnr2renum[resnr] != -1)) {
                     bResnrCollision = true;
                 }
@@ -271,6 +329,7 @@ void FDASettings::fill_atom2residue(gmx_mtop_t *mtop)
                 a2r_renum[atom_global_index] = renum;
                 atom_global_index++;
             }
+            residue_offset += atoms->nres;
         }
     }
 
@@ -305,6 +364,45 @@ void FDASettings::fill_atom2residue(gmx_mtop_t *mtop)
     }
 }
 
+void FDASettings::fill_residue_atoms(gmx_mtop_t *mtop)
+{
+    residue_atoms_index.assign(syslen_residues + 1, 0);
+    residue_atoms.clear();
+    residue_atom_masses.clear();
+    residue_masses.assign(syslen_residues, 0.0);
+    if (atom_2_residue.empty()) return;
+
+    std::vector<real> atom_masses(syslen_atoms);
+    int atom_global_index = 0;
+    for (int moltype_index = 0; moltype_index < mtop->nmolblock; ++moltype_index) {
+        gmx_molblock_t *mb = &mtop->molblock[moltype_index];
+        t_atoms *atoms = &mtop->moltype[mb->type].atoms;
+        for (int mol_index = 0; mol_index < mb->nmol; ++mol_index) {
+            for (int atom_index = 0; atom_index < atoms->nr; ++atom_index) {
+                atom_masses[atom_global_index++] = atoms->atom[atom_index].m;
+            }
+        }
+    }
+
+    // Counting sort of the group atoms by residue, keeping the ascending atom order within each residue
+    for (int i = 0; i != syslen_atoms; ++i) {
+        if (atom_in_groups(i)) ++residue_atoms_index[atom_2_residue[i] + 1];
+    }
+    for (int r = 0; r != syslen_residues; ++r) residue_atoms_index[r + 1] += residue_atoms_index[r];
+
+    residue_atoms.resize(residue_atoms_index[syslen_residues]);
+    residue_atom_masses.resize(residue_atoms.size());
+    std::vector<int> position(residue_atoms_index.begin(), residue_atoms_index.end() - 1);
+    for (int i = 0; i != syslen_atoms; ++i) {
+        if (!atom_in_groups(i)) continue;
+        int r = atom_2_residue[i];
+        int k = position[r]++;
+        residue_atoms[k] = i;
+        residue_atom_masses[k] = atom_masses[i];
+        residue_masses[r] += atom_masses[i];
+    }
+}
+
 int FDASettings::get_global_residue_number(gmx_mtop_t *mtop, int atnr_global) const
 {
     int mb;
@@ -338,3 +436,11 @@ int FDASettings::get_global_residue_number(gmx_mtop_t *mtop, int atnr_global) co
     // original function had maxresnr + 1 + (...), to make residue numbering start from 1
     return maxresnr + (atnr_global - a_start)/atoms->nr*atoms->nres + atoms->atom[at_loc].resind;
 }
+
+std::string FDASettings::stddev_filename(std::string const& result_filename)
+{
+    size_t dot = result_filename.find_last_of('.');
+    size_t slash = result_filename.find_last_of('/');
+    if (dot == std::string::npos or (slash != std::string::npos and dot < slash)) return result_filename + "_stddev";
+    return result_filename.substr(0, dot) + "_stddev" + result_filename.substr(dot);
+}
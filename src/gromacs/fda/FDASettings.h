@@ -8,7 +8,6 @@
 #ifndef SRC_GROMACS_FDA_FDASETTINGS_H_
 #define SRC_GROMACS_FDA_FDASETTINGS_H_
 
-#include <map>
 #include <vector>
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/topology/topology.h"
@@ -31,9 +30,17 @@ struct FDASettings
        v2s(Vector2Scalar::NORM),
        residues_renumber(ResiduesRenumber::AUTO),
        no_end_zeros(false),
+       sort_pairs(false),
+       force_threshold(0.0),
+       top_k_pairs(0),
        syslen_atoms(0),
        syslen_residues(0),
        time_averaging_period(1),
+       time_averaging_stddev(false),
+       nstfda(1),
+       async_output(false),
+       compress_output(false),
+       binary_precision(0.0),
        type(InteractionType_NONE),
        nonbonded_exclusion_on(true),
        bonded_exclusion_on(true),
@@ -44,7 +51,7 @@ struct FDASettings
     {}
 
     /// Construction by input file
-    FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop, bool parallel_execution);
+    FDASettings(int nfile, const t_filenm fnm[], gmx_mtop_t *mtop);
 
     /// Returns true if atom i is in fda groups
     bool atom_in_groups(int i) const {
@@ -64,12 +71,18 @@ struct FDASettings
     /// Adapted from the code fragment in Data_Structures page on GROMACS website
     void fill_atom2residue(gmx_mtop_t *mtop);
 
+    /// Fill the group atoms of each residue with their masses, needs atom_2_residue and the group arrays
+    void fill_residue_atoms(gmx_mtop_t *mtop);
+
     /// Returns the global residue number - based on mtop_util.c::gmx_mtop_atominfo_global(),
     /// equivalent to a call to it with mtop->maxres_renum = INT_MAX
     int get_global_residue_number(gmx_mtop_t *mtop, int atnr_global) const;
 
     int get_atom2residue(int i) const { return atom_2_residue[i]; }
 
+    /// Returns the file name for the standard deviations of the time averages, e.g. fda_stddev.pfa for fda.pfa
+    static std::string stddev_filename(std::string const& result_filename);
+
     bool compatibility_mode(ResultType const& r) const {
         return r == ResultType::COMPAT_BIN or r == ResultType::COMPAT_ASCII;
     }
@@ -79,7 +92,8 @@ struct FDASettings
     }
 
     bool PF_or_PS_mode(ResultType const& r) const {
-        return r == ResultType::PAIRWISE_FORCES_VECTOR or r == ResultType::PAIRWISE_FORCES_SCALAR or r == ResultType::PUNCTUAL_STRESS;
+        return r == ResultType::PAIRWISE_FORCES_VECTOR or r == ResultType::PAIRWISE_FORCES_SCALAR or
+               r == ResultType::PAIRWISE_FORCES_BINARY or r == ResultType::PUNCTUAL_STRESS;
     }
 
     bool VS_mode(ResultType const& r) const {
@@ -105,6 +119,21 @@ struct FDASettings
     /// if False (default), all per atom/residue data is written.
     bool no_end_zeros;
 
+    /// If True, the pairs of each atom/residue i are written in ascending order of j.
+    /// If False (default), the pairs are written in the order of their first appearance.
+    /// With more than one OpenMP thread or with domain decomposition the pairs are always sorted.
+    bool sort_pairs;
+
+    /// Pairs whose total force is smaller are not written. The force is the norm for vector output
+    /// and the absolute value for scalar output, taken after the summation over all interactions
+    /// and over the time averaging period. If 0 (default), all pairs are written.
+    real force_threshold;
+
+    /// If larger than zero, a pair is only written if it belongs to the top_k_pairs strongest
+    /// pairs of one of its two atoms/residues, measured as for force_threshold.
+    /// If 0 (default), all pairs are written.
+    int top_k_pairs;
+
     /// Total number of atoms in the system.
     /// This is a local copy to avoid passing too many variables down the function call stack
     int syslen_atoms;
@@ -112,17 +141,43 @@ struct FDASettings
     /// Maximum of residue nr. + 1; residue nr. doesn't have to be continuous, there can be gaps
     int syslen_residues;
 
-    /// Mapping of real atom number to index in the pf array
-    std::map<int, int> sys2pf_atoms;
+    /// Mapping of real atom number to index in the pf array, -1 if the atom is not in the groups
+    std::vector<int> sys2pf_atoms;
 
-    /// Mapping of real residue number to index in the pf array
-    std::map<int, int> sys2pf_residues;
+    /// Mapping of real residue number to index in the pf array, -1 if the residue is not in the groups
+    std::vector<int> sys2pf_residues;
 
     /// Number of steps to average before writing.
     /// If 1 (default), no averaging is done.
     /// If 0 averaging is done over all steps so only one frame is written at the end.
     int time_averaging_period;
 
+    /// If True, the standard deviations of the time averages are written into a second file,
+    /// whose name is given by stddev_filename.
+    bool time_averaging_stddev;
+
+    /// FDA is only done every nstfda steps, such that the nonbonded kernels without energies
+    /// can be used for the other steps. The time averages are taken over the FDA steps.
+    /// If 1 (default), FDA is done in every step.
+    /// With domain decomposition the pairwise forces of all ranks and the coordinates are gathered
+    /// on the master rank in each FDA step, also if the step is only added to a time average,
+    /// because the contributions to a pair can come from several ranks. A larger nstfda reduces
+    /// this communication.
+    int nstfda;
+
+    /// If True, the frames are written by a background thread while MD continues.
+    /// The pairwise forces are double-buffered, which needs twice the memory.
+    bool async_output;
+
+    /// If True, the text result files are written gzip-compressed.
+    /// The FDA readers and gmx fda tools decompress them transparently.
+    bool compress_output;
+
+    /// If larger than zero, the binary result files are written compressed with delta-encoded
+    /// frames and the forces are stored with a resolution of 1/binary_precision, like xtc-precision.
+    /// If 0 (default), the binary frames are written uncompressed with full precision.
+    double binary_precision;
+
     /// Output file name for atoms if AtomBased is non-zero
     std::string atom_based_result_filename;
 
@@ -144,6 +199,19 @@ struct FDASettings
     /// Stores the residue number for each atom; array of length syslen; only initialized if ResidueBased is non-zero
     std::vector<int> atom_2_residue;
 
+    /// Atoms of the fda groups sorted by residue in compressed sparse row format, i.e. the atoms of residue r are
+    /// residue_atoms[residue_atoms_index[r]] to residue_atoms[residue_atoms_index[r + 1] - 1]; length syslen_residues + 1
+    std::vector<int> residue_atoms_index;
+
+    /// Atom indices of the residues, see residue_atoms_index
+    std::vector<int> residue_atoms;
+
+    /// Masses of residue_atoms
+    std::vector<real> residue_atom_masses;
+
+    /// Total mass of the group atoms of each residue, zero for residues without group atoms
+    std::vector<real> residue_masses;
+
     /// Version of force matrix implementation (compat mode)
     static const std::string compat_fm_version;
 
@@ -0,0 +1,140 @@
+/*
+ * NonbondedPairBuffer.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_NONBONDEDPAIRBUFFER_H_
+#define SRC_GROMACS_FDA_NONBONDEDPAIRBUFFER_H_
+
+#include <cmath>
+#include <vector>
+#include "FDASettings.h"
+#include "gromacs/utility/real.h"
+
+namespace fda {
+
+/**
+ * Compact per-thread storage of the nonbonded pair forces computed by the SIMD kernels.
+ *
+ * The SIMD kernels store the Coulomb and LJ force of all lanes of a cluster pair at once.
+ * Only the pairs between the FDA groups with a non-negligible force are kept,
+ * all others are masked out. The buffer is drained into FDA after the kernel
+ * has finished, such that the inner loop is not interrupted by the force accumulation.
+ */
+class NonbondedPairBuffer
+{
+public:
+
+    /// Forces below this threshold are ignored, same as in the reference kernel
+#if GMX_DOUBLE
+    static constexpr real tiny_real_number = 1.0e-14;
+#else
+    static constexpr real tiny_real_number = 1.0e-7f;
+#endif
+
+    /// Bits of the group masks
+    static constexpr unsigned char group1_bit = 1;
+    static constexpr unsigned char group2_bit = 2;
+
+    /// Constructor
+    NonbondedPairBuffer(FDASettings const& fda_settings)
+     : fda_settings(fda_settings),
+       gatindex(nullptr),
+       group_masks(nullptr)
+    {}
+
+    /// Set the mapping of local to global atom indices, nullptr if the indices are global
+    void set_global_atom_index(int const* gatindex) { this->gatindex = gatindex; }
+
+    /// Set the group masks of the atoms in the nbnxn ordering, nullptr if they are not available
+    void set_group_masks(unsigned char const* group_masks) { this->group_masks = group_masks; }
+
+    /**
+     * Returns true if the cluster pair may contain a pair between group1 and group2.
+     * The SIMD kernels only store the lanes of these cluster pairs, such that FDA runs
+     * over a sub-list of the pair list. Without group masks all cluster pairs are accepted.
+     */
+    bool cluster_pair_in_groups(int ai, int ni, int aj, int nj) const
+    {
+        if (group_masks == nullptr) return true;
+        unsigned char mask_i = 0, mask_j = 0;
+        for (int i = 0; i < ni; ++i) mask_i |= group_masks[ai + i];
+        for (int j = 0; j < nj; ++j) mask_j |= group_masks[aj + j];
+        return ((mask_i & group1_bit) and (mask_j & group2_bit)) or ((mask_i & group2_bit) and (mask_j & group1_bit));
+    }
+
+    /**
+     * Append the pairs of a cluster pair.
+     * The forces and distances are stored row-major for ni i-atoms and nj j-atoms,
+     * ai and aj are the first atoms of the clusters in the nbnxn ordering,
+     * cellInv maps them back to the atom index (negative for filler particles).
+     * The group masks are checked with the global atom indices, but the local indices are stored.
+     */
+    void add_cluster_pair(int const* cellInv, int ai, int aj, int ni, int nj,
+        real const* fcoul, real const* fvdw, real const* dx, real const* dy, real const* dz)
+    {
+        for (int i = 0; i < ni; ++i) {
+            int li = cellInv[ai + i];
+            if (li < 0) continue;
+            int gi = global_atom(li);
+            if (!fda_settings.atom_in_groups(gi)) continue;
+            for (int j = 0; j < nj; ++j) {
+                int k = i * nj + j;
+                if (std::abs(fcoul[k]) <= tiny_real_number and std::abs(fvdw[k]) <= tiny_real_number) continue;
+                int lj = cellInv[aj + j];
+                if (lj < 0 or !fda_settings.atoms_in_groups(gi, global_atom(lj))) continue;
+                this->i.push_back(li);
+                this->j.push_back(lj);
+                this->fcoul.push_back(fcoul[k]);
+                this->fvdw.push_back(fvdw[k]);
+                this->dx.push_back(dx[k]);
+                this->dy.push_back(dy[k]);
+                this->dz.push_back(dz[k]);
+            }
+        }
+    }
+
+    /// Number of stored pairs
+    size_t size() const { return i.size(); }
+
+    /// Remove all pairs, but keep the capacity
+    void clear()
+    {
+        i.clear();
+        j.clear();
+        fcoul.clear();
+        fvdw.clear();
+        dx.clear();
+        dy.clear();
+        dz.clear();
+    }
+
+    /// Atom indices of the pairs
+    std::vector<int> i, j;
+
+    /// Scalar Coulomb and LJ forces of the pairs (force divided by distance)
+    std::vector<real> fcoul, fvdw;
+
+    /// Distance vectors of the pairs
+    std::vector<real> dx, dy, dz;
+
+private:
+
+    int global_atom(int i) const { return gatindex ? gatindex[i] : i; }
+
+    /// Settings, used for the group masks
+    FDASettings const& fda_settings;
+
+    /// Local to global atom index mapping of the domain decomposition, not owned
+    int const* gatindex;
+
+    /// Group masks of the atoms in the nbnxn ordering, owned by FDA
+    unsigned char const* group_masks;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_NONBONDEDPAIRBUFFER_H_ */
@@ -0,0 +1,119 @@
+/*
+ * PairIndex.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_PAIRINDEX_H_
+#define SRC_GROMACS_FDA_PAIRINDEX_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace fda {
+
+/**
+ * Open-addressing hash table mapping the second atom/residue index j of a pair
+ * to the position of the pair in the storage arrays of row i.
+ *
+ * Replaces the linear search over the j-indices of a row, which was the dominant
+ * cost for residues with hundreds of interaction partners.
+ * Lookup and insertion are O(1) amortized, the table grows by doubling
+ * when the load factor exceeds 1/2. Clearing keeps the capacity,
+ * so that no reallocation is needed in the following frames.
+ */
+class PairIndex
+{
+public:
+
+    /// Default constructor
+    PairIndex()
+     : nb_entries(0),
+       shift(32)
+    {}
+
+    /// Returns the position of j or -1 if j is not stored
+    int find(int j) const
+    {
+        if (nb_entries == 0) return -1;
+        size_t mask = slots.size() - 1;
+        for (size_t h = hash(j);; h = (h + 1) & mask) {
+            Slot const& slot = slots[h];
+            if (slot.key == j) return slot.position;
+            if (slot.key == empty) return -1;
+        }
+    }
+
+    /// Insert j with position, j must not be stored already
+    void insert(int j, int position)
+    {
+        if (2 * (nb_entries + 1) > slots.size()) grow();
+        insert_nocheck(j, position);
+        ++nb_entries;
+    }
+
+    /// Remove all entries, but keep the capacity
+    void clear()
+    {
+        if (nb_entries == 0) return;
+        for (auto& slot : slots) slot.key = empty;
+        nb_entries = 0;
+    }
+
+    /// Number of stored entries
+    size_t size() const { return nb_entries; }
+
+private:
+
+    struct Slot
+    {
+        int key;
+        int position;
+    };
+
+    /// Marker for unused slots, atom/residue indices are never negative
+    static const int empty = -1;
+
+    /// Minimal number of slots allocated at first insertion
+    static const size_t min_capacity = 8;
+
+    /// Fibonacci hashing, uses the upper bits of the product
+    size_t hash(int j) const
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint32_t>(j) * 2654435769u) >> shift;
+    }
+
+    void insert_nocheck(int j, int position)
+    {
+        size_t mask = slots.size() - 1;
+        size_t h = hash(j);
+        while (slots[h].key != empty) h = (h + 1) & mask;
+        slots[h].key = j;
+        slots[h].position = position;
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old_slots(slots.size() ? 2 * slots.size() : min_capacity, Slot{empty, 0});
+        old_slots.swap(slots);
+        for (shift = 32; (size_t(1) << (32 - shift)) < slots.size(); --shift) {}
+        for (auto const& slot : old_slots) {
+            if (slot.key != empty) insert_nocheck(slot.key, slot.position);
+        }
+    }
+
+    /// Hash table, size is always a power of two
+    std::vector<Slot> slots;
+
+    /// Number of stored entries
+    size_t nb_entries;
+
+    /// Right shift of the hash product, 32 - log2(slots.size())
+    int shift;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_PAIRINDEX_H_ */
@@ -9,17 +9,43 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include "BinaryPairwiseForces.h"
+#include "CompressedStream.h"
 #include "PairwiseForces.h"
 
 namespace fda {
 
+template <>
+void PairwiseForces<Force<real>>::read_binary(std::string const& filename)
+{
+    BinaryPairwiseForcesReader reader(filename);
+    all_pairwise_forces.resize(reader.number_of_frames());
+    for (size_t frame = 0; frame != reader.number_of_frames(); ++frame) {
+        auto & pairwise_forces = all_pairwise_forces[frame];
+        pairwise_forces.reserve(reader.size(frame));
+        for (auto pf = reader.begin(frame); pf != reader.end(frame); ++pf)
+            pairwise_forces.push_back(PairwiseForce(pf->i, pf->j, Force<real>(pf->force, pf->type)));
+    }
+}
+
+template <>
+void PairwiseForces<Force<Vector>>::read_binary(std::string const& filename)
+{
+    throw std::runtime_error(filename + ": binary pairwise forces contain only scalar forces");
+}
+
 template <typename ForceType>
 PairwiseForces<ForceType>::PairwiseForces(std::string const& filename)
 {
+    if (BinaryPairwiseForcesReader::is_binary(filename)) {
+        read_binary(filename);
+        return;
+    }
+
     int i, j;
     ForceType force;
     PairwiseForceList pairwise_forces;
-    std::ifstream is(filename);
+    InputFileStream is(filename);
     std::string token;
     while (is >> token)
     {
@@ -27,7 +27,7 @@ public:
     /// Default constructor
     PairwiseForces() {}
 
-    /// Constructor reading files
+    /// Constructor reading files, ascii or binary format is detected automatically
     PairwiseForces(std::string const& filename);
 
     template <class Comparer>
@@ -102,6 +102,9 @@ private:
 
     typedef typename std::vector<PairwiseForce> PairwiseForceList;
 
+    /// Read all frames of a binary pairwise forces file, only supported for scalar forces
+    void read_binary(std::string const& filename);
+
     std::vector<PairwiseForceList> all_pairwise_forces;
 };
 
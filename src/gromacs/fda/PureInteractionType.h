@@ -13,7 +13,7 @@
 
 namespace fda {
 
-/// Used for indexing detailed forces array!
+/// Defines the order of the detailed forces of a pair!
 /// Don't change the numbers!
 enum class PureInteractionType : int
 {
@@ -31,6 +31,8 @@ std::ostream& operator << (std::ostream& os, ResultType r)
             return os << "compat_bin";
         case ResultType::COMPAT_ASCII:
             return os << "compat_ascii";
+        case ResultType::PAIRWISE_FORCES_BINARY:
+            return os << "pairwise_forces_binary";
         default:
             return os << "invalid";
     }
@@ -57,6 +59,8 @@ std::istream& operator >> (std::istream& is, ResultType& r)
         r = ResultType::COMPAT_BIN;
     else if (s == "compat_ascii")
         r = ResultType::COMPAT_ASCII;
+    else if (s == "pairwise_forces_binary")
+        r = ResultType::PAIRWISE_FORCES_BINARY;
     else
         throw std::runtime_error("Unknown option " + s);
     return is;
@@ -23,7 +23,8 @@ enum class ResultType : std::int8_t
     VIRIAL_STRESS,
     VIRIAL_STRESS_VON_MISES,
     COMPAT_BIN,               // DEPRICATED! compatibility mode (signed scalars) in binary
-    COMPAT_ASCII              // DEPRICATED! compatibility mode (signed scalars) in ascii
+    COMPAT_ASCII,             // DEPRICATED! compatibility mode (signed scalars) in ascii
+    PAIRWISE_FORCES_BINARY    // signed scalars in binary format with frame index (see BinaryPairwiseForces.h)
 };
 
 /// Output stream for ResultType
@@ -0,0 +1,65 @@
+/*
+ * RunningAverage.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_RUNNINGAVERAGE_H_
+#define SRC_GROMACS_FDA_RUNNINGAVERAGE_H_
+
+#include <cmath>
+
+namespace fda {
+
+/**
+ * Welford accumulator of mean and variance, updated in place for each step.
+ *
+ * A pair does not interact in every step. The steps since the last update are
+ * counted as zero values and merged as a block (Chan et al.), such that no pass over
+ * all pairs is needed for steps where a pair is missing.
+ */
+struct RunningAverage
+{
+    RunningAverage()
+     : mean(0.0), m2(0.0), count(0)
+    {}
+
+    /// Add the value of step n, counted from 1 in the averaging period
+    void add(double value, int n)
+    {
+        add_zeros(n - 1);
+        ++count;
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    /// Extend the average to n steps, where the missing steps have a value of zero
+    void add_zeros(int n)
+    {
+        if (n <= count) return;
+        double delta = -mean;
+        double nb_zeros = n - count;
+        mean += delta * nb_zeros / n;
+        m2 += delta * delta * count * nb_zeros / n;
+        count = n;
+    }
+
+    /// Population variance over the counted steps
+    double variance() const { return count ? m2 / count : 0.0; }
+
+    double stddev() const { return std::sqrt(variance()); }
+
+    double mean;
+
+    /// Sum of squared differences from the mean
+    double m2;
+
+    /// Number of steps included
+    int count;
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_RUNNINGAVERAGE_H_ */
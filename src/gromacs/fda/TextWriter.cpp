@@ -0,0 +1,142 @@
+/*
+ * TextWriter.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <cstdio>
+#include "TextWriter.h"
+
+namespace fda {
+
+namespace {
+
+/// Powers of ten which are exactly representable as double
+const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const int max_exact_power_of_ten = 22;
+
+/// Maximal number of characters of an integer or a real
+const size_t max_number_length = 32;
+
+/// Returns value * 10^shift with a single rounding, shift must be in [-22, 22]
+double scale(double value, int shift)
+{
+    return shift >= 0 ? value * exact_powers_of_ten[shift] : value / exact_powers_of_ten[-shift];
+}
+
+} // namespace
+
+TextWriter::TextWriter(std::ostream& os, size_t capacity)
+ : os(os),
+   buffer(capacity < max_number_length ? max_number_length : capacity),
+   position(buffer.data())
+{}
+
+void TextWriter::flush()
+{
+    os.write(buffer.data(), position - buffer.data());
+    position = buffer.data();
+}
+
+TextWriter& TextWriter::write(char const* s, size_t size)
+{
+    if (size > buffer.size()) {
+        flush();
+        os.write(s, size);
+    } else {
+        reserve(size);
+        std::memcpy(position, s, size);
+        position += size;
+    }
+    return *this;
+}
+
+TextWriter& TextWriter::put_signed(long long value)
+{
+    if (value >= 0) return put_unsigned(value);
+    reserve(max_number_length);
+    *position++ = '-';
+    return put_unsigned(0ull - static_cast<unsigned long long>(value));
+}
+
+TextWriter& TextWriter::put_unsigned(unsigned long long value)
+{
+    reserve(max_number_length);
+    char digits[max_number_length];
+    char *d = digits;
+    do {
+        *d++ = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (d != digits) *position++ = *--d;
+    return *this;
+}
+
+TextWriter& TextWriter::put_real(double value)
+{
+    reserve(max_number_length);
+
+    if (value == 0.0) {
+        if (std::signbit(value)) *position++ = '-';
+        std::memcpy(position, "0.000000e+00", 12);
+        position += 12;
+        return *this;
+    }
+
+    // The seven significant digits are determined as integer value * 10^(6 - exponent).
+    // The scaling is exact up to a single rounding, which can only change the result
+    // if the discarded part is close to one half. This case, as well as non-finite values
+    // and exponents outside of the exactly representable powers of ten, is left to printf.
+    double abs_value = std::abs(value);
+    int exponent = std::isfinite(abs_value) ? static_cast<int>(std::floor(std::log10(abs_value))) : 0;
+    int shift = 6 - exponent;
+    double mantissa = 0.0;
+    bool fast = std::isfinite(abs_value) and std::abs(shift) < max_exact_power_of_ten;
+    if (fast) {
+        mantissa = scale(abs_value, shift);
+        // log10 may be off by one near powers of ten
+        if (mantissa < 1e6) mantissa = scale(abs_value, ++shift);
+        else if (mantissa >= 1e7) mantissa = scale(abs_value, --shift);
+        exponent = 6 - shift;
+    }
+    double integral = std::floor(mantissa);
+    if (!fast or mantissa < 1e6 or mantissa >= 1e7 or std::abs(mantissa - integral - 0.5) < 1e-6) {
+        position += std::snprintf(position, max_number_length, "%.6e", value);
+        return *this;
+    }
+
+    unsigned int digits = static_cast<unsigned int>(integral) + (mantissa - integral > 0.5 ? 1 : 0);
+    if (digits == 10000000) {
+        digits = 1000000;
+        ++exponent;
+    }
+
+    if (value < 0.0) *position++ = '-';
+    char *first = position;
+    for (int k = 7; k != 0; --k) {
+        first[k] = '0' + digits % 10;
+        digits /= 10;
+    }
+    first[0] = first[1];
+    first[1] = '.';
+    position += 8;
+
+    *position++ = 'e';
+    *position++ = exponent < 0 ? '-' : '+';
+    unsigned int abs_exponent = std::abs(exponent);
+    if (abs_exponent >= 100) {
+        *position++ = '0' + abs_exponent / 100;
+        abs_exponent %= 100;
+    }
+    *position++ = '0' + abs_exponent / 10;
+    *position++ = '0' + abs_exponent % 10;
+    return *this;
+}
+
+} // namespace fda
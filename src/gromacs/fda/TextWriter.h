@@ -0,0 +1,88 @@
+/*
+ * TextWriter.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SRC_GROMACS_FDA_TEXTWRITER_H_
+#define SRC_GROMACS_FDA_TEXTWRITER_H_
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fda {
+
+/**
+ * Buffered formatter for the text result files.
+ *
+ * Integers and reals are formatted directly into a large buffer, which is written
+ * to the stream when it is full and at destruction, i.e. once per frame.
+ * Reals are formatted as std::scientific with precision 6 (printf "%.6e") in the
+ * classic locale, such that the output is identical to the stream operators used before.
+ */
+class TextWriter
+{
+public:
+
+    explicit TextWriter(std::ostream& os, size_t capacity = 1 << 20);
+
+    ~TextWriter() { flush(); }
+
+    TextWriter(TextWriter const&) = delete;
+    TextWriter& operator = (TextWriter const&) = delete;
+
+    TextWriter& operator << (char c)
+    {
+        reserve(1);
+        *position++ = c;
+        return *this;
+    }
+
+    TextWriter& operator << (char const* s) { return write(s, std::strlen(s)); }
+
+    TextWriter& operator << (std::string const& s) { return write(s.data(), s.size()); }
+
+    TextWriter& operator << (int value) { return put_signed(value); }
+    TextWriter& operator << (long value) { return put_signed(value); }
+    TextWriter& operator << (long long value) { return put_signed(value); }
+    TextWriter& operator << (unsigned int value) { return put_unsigned(value); }
+    TextWriter& operator << (unsigned long value) { return put_unsigned(value); }
+    TextWriter& operator << (unsigned long long value) { return put_unsigned(value); }
+
+    TextWriter& operator << (float value) { return put_real(value); }
+    TextWriter& operator << (double value) { return put_real(value); }
+
+    /// Write the buffer to the stream
+    void flush();
+
+private:
+
+    TextWriter& write(char const* s, size_t size);
+
+    TextWriter& put_signed(long long value);
+
+    TextWriter& put_unsigned(unsigned long long value);
+
+    TextWriter& put_real(double value);
+
+    /// Make room for n characters
+    void reserve(size_t n)
+    {
+        if (position + n > buffer.data() + buffer.size()) flush();
+    }
+
+    std::ostream& os;
+
+    std::vector<char> buffer;
+
+    /// Current end of the formatted text in buffer
+    char *position;
+
+};
+
+} // namespace fda
+
+#endif /* SRC_GROMACS_FDA_TEXTWRITER_H_ */
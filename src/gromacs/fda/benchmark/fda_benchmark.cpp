@@ -0,0 +1,186 @@
+/*
+ * fda_benchmark.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ *
+ * Replays synthetic streams of nonbonded and bonded pairs into FDA and
+ * reports the cost per interaction and the size of the result file.
+ *
+ * Usage: fda-benchmark [-atoms n] [-nonbonded n] [-bonded n] [-steps n]
+ *                      [-result pairwise_forces_scalar] [-onepair summed] [-average n] [-async 0|1] [-seed n]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gromacs/fda/FDA.h"
+
+namespace {
+
+struct Parameters
+{
+    Parameters()
+     : nb_atoms(10000),
+       nb_nonbonded(1000000),
+       nb_bonded(20000),
+       nb_steps(10),
+       result_type(fda::ResultType::PAIRWISE_FORCES_SCALAR),
+       one_pair(fda::OnePair::SUMMED),
+       time_averaging_period(1),
+       async_output(false),
+       binary_precision(0.0),
+       seed(42)
+    {}
+
+    int nb_atoms;
+    int nb_nonbonded;
+    int nb_bonded;
+    int nb_steps;
+    fda::ResultType result_type;
+    fda::OnePair one_pair;
+    int time_averaging_period;
+    bool async_output;
+    double binary_precision;
+    int seed;
+};
+
+Parameters parse(int argc, char *argv[])
+{
+    Parameters p;
+    for (int n = 1; n < argc; ++n) {
+        std::string key = argv[n];
+        if (n + 1 == argc) throw std::runtime_error("Missing value for option " + key);
+        std::istringstream value(argv[++n]);
+        if (key == "-atoms") value >> p.nb_atoms;
+        else if (key == "-nonbonded") value >> p.nb_nonbonded;
+        else if (key == "-bonded") value >> p.nb_bonded;
+        else if (key == "-steps") value >> p.nb_steps;
+        else if (key == "-result") value >> p.result_type;
+        else if (key == "-onepair") value >> p.one_pair;
+        else if (key == "-average") value >> p.time_averaging_period;
+        else if (key == "-async") value >> p.async_output;
+        else if (key == "-precision") value >> p.binary_precision;
+        else if (key == "-seed") value >> p.seed;
+        else throw std::runtime_error("Unknown option " + key);
+        if (!value) throw std::runtime_error("Invalid value for option " + key);
+    }
+    if (p.nb_atoms < 2) throw std::runtime_error("At least two atoms are needed");
+    if (p.nb_steps < 1) throw std::runtime_error("At least one step is needed");
+    return p;
+}
+
+/// Synthetic interaction of the pair stream
+struct Interaction
+{
+    int i;
+    int j;
+    real f1;
+    real f2;
+    rvec d;
+};
+
+std::vector<Interaction> make_stream(int size, int nb_atoms, std::mt19937& gen)
+{
+    std::uniform_int_distribution<int> atom(0, nb_atoms - 1);
+    std::uniform_real_distribution<real> force(-100.0, 100.0);
+    std::uniform_real_distribution<real> distance(-1.0, 1.0);
+
+    std::vector<Interaction> stream(size);
+    for (auto& interaction : stream) {
+        interaction.i = atom(gen);
+        do interaction.j = atom(gen); while (interaction.j == interaction.i);
+        interaction.f1 = force(gen);
+        interaction.f2 = force(gen);
+        for (int d = 0; d < DIM; ++d) interaction.d[d] = distance(gen);
+    }
+    return stream;
+}
+
+long file_size(std::string const& filename)
+{
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    return is ? static_cast<long>(is.tellg()) : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Parameters p;
+    try {
+        p = parse(argc, argv);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string result_filename = "fda-benchmark.out";
+
+    fda::FDASettings fda_settings;
+    fda_settings.atom_based_result_type = p.result_type;
+    fda_settings.one_pair = p.one_pair;
+    fda_settings.syslen_atoms = p.nb_atoms;
+    fda_settings.time_averaging_period = p.time_averaging_period;
+    fda_settings.async_output = p.async_output;
+    fda_settings.binary_precision = p.binary_precision;
+    fda_settings.type = fda::InteractionType_ALL;
+    fda_settings.sys_in_group1.assign(p.nb_atoms, 1);
+    fda_settings.sys_in_group2.assign(p.nb_atoms, 1);
+    fda_settings.atom_based_result_filename = result_filename;
+
+    std::mt19937 gen(p.seed);
+    std::vector<Interaction> nonbonded = make_stream(p.nb_nonbonded, p.nb_atoms, gen);
+    std::vector<Interaction> bonded = make_stream(p.nb_bonded, p.nb_atoms, gen);
+
+    gmx::HostVector<gmx::RVec> x(p.nb_atoms);
+    std::uniform_real_distribution<real> position(0.0, 10.0);
+    for (auto& xi : x) xi = gmx::RVec(position(gen), position(gen), position(gen));
+
+    typedef std::chrono::steady_clock Clock;
+    std::chrono::duration<double> time_accumulate(0.0), time_write(0.0);
+    {
+        FDA fda(fda_settings);
+        for (int step = 0; step < p.nb_steps; ++step) {
+            auto start = Clock::now();
+            for (auto& nb : nonbonded) fda.add_nonbonded(nb.i, nb.j, nb.f1, nb.f2, nb.d[XX], nb.d[YY], nb.d[ZZ]);
+            for (auto& b : bonded) fda.add_bonded(b.i, b.j, fda::InteractionType_BOND, b.d);
+            auto middle = Clock::now();
+            fda.save_and_write_scalar_time_averages(x);
+            auto end = Clock::now();
+            time_accumulate += middle - start;
+            time_write += end - middle;
+        }
+        auto start = Clock::now();
+        fda.write_scalar_time_averages();
+        time_write += Clock::now() - start;
+    }
+
+    double nb_interactions = static_cast<double>(p.nb_nonbonded + p.nb_bonded) * p.nb_steps;
+    long bytes = file_size(result_filename);
+    std::remove(result_filename.c_str());
+
+    std::cout << "atoms                 " << p.nb_atoms << std::endl
+              << "nonbonded pairs/step  " << p.nb_nonbonded << std::endl
+              << "bonded pairs/step     " << p.nb_bonded << std::endl
+              << "steps                 " << p.nb_steps << std::endl
+              << "result type           " << p.result_type << std::endl
+              << "one pair              " << p.one_pair << std::endl
+              << "time averages period  " << p.time_averaging_period << std::endl
+              << "async output          " << p.async_output << std::endl
+              << "binary precision      " << p.binary_precision << std::endl
+              << "accumulate [ns/int]   " << 1e9 * time_accumulate.count() / nb_interactions << std::endl
+              << "reduce+write [ns/int] " << 1e9 * time_write.count() / nb_interactions << std::endl
+              << "total [s]             " << time_accumulate.count() + time_write.count() << std::endl
+              << "bytes written         " << bytes << std::endl
+              << "bytes/step            " << bytes / p.nb_steps << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*
+ * BinaryPairwiseForcesTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "gromacs/fda/BinaryPairwiseForces.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+namespace fda
+{
+
+//! Test fixture for BinaryPairwiseForces
+class BinaryPairwiseForcesTest : public gmx::test::CommandLineTestBase
+{};
+
+TEST_F(BinaryPairwiseForcesTest, WriteAndSeek)
+{
+    std::string filename = fileManager().getTemporaryFilePath("test.pfb");
+    {
+        std::ofstream os(filename, std::ios::binary);
+        BinaryPairwiseForcesWriter writer(os, 20);
+        std::vector<BinaryPairwiseForce> frame0 = {{3, 7, 1.5, 16}, {0, 14, -2.0, 32}, {0, 9, 0.5, 1}};
+        std::vector<BinaryPairwiseForce> frame1;
+        std::vector<BinaryPairwiseForce> frame2 = {{11, 14, 8.0, 64}};
+        writer.write_frame(0, frame0);
+        writer.write_frame(1, frame1);
+        writer.write_frame(2, frame2);
+        writer.write_index();
+    }
+
+    EXPECT_TRUE(BinaryPairwiseForcesReader::is_binary(filename));
+
+    BinaryPairwiseForcesReader reader(filename);
+    EXPECT_EQ(20, reader.get_syslen());
+    ASSERT_EQ(3, reader.number_of_frames());
+
+    // Frames can be accessed in any order, pairs are sorted by i and j
+    EXPECT_EQ(2, reader.frame_number(2));
+    ASSERT_EQ(1, reader.size(2));
+    EXPECT_EQ(11, reader.begin(2)->i);
+    EXPECT_FLOAT_EQ(8.0, reader.begin(2)->force);
+
+    EXPECT_EQ(0, reader.size(1));
+
+    ASSERT_EQ(3, reader.size(0));
+    BinaryPairwiseForce const* pf = reader.begin(0);
+    EXPECT_EQ(0, pf[0].i);
+    EXPECT_EQ(9, pf[0].j);
+    EXPECT_EQ(0, pf[1].i);
+    EXPECT_EQ(14, pf[1].j);
+    EXPECT_FLOAT_EQ(-2.0, pf[1].force);
+    EXPECT_EQ(32, pf[1].type);
+    EXPECT_EQ(3, pf[2].i);
+
+    EXPECT_THROW(reader.begin(3), std::runtime_error);
+}
+
+TEST_F(BinaryPairwiseForcesTest, IncompleteFile)
+{
+    std::string filename = fileManager().getTemporaryFilePath("incomplete.pfb");
+    {
+        std::ofstream os(filename, std::ios::binary);
+        BinaryPairwiseForcesWriter writer(os, 20);
+        std::vector<BinaryPairwiseForce> frame0 = {{0, 1, 1.0, 1}};
+        writer.write_frame(0, frame0);
+    }
+
+    EXPECT_TRUE(BinaryPairwiseForcesReader::is_binary(filename));
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+}
+
+namespace {
+
+/// Overwrite the 64-bit value at offset of the file, a negative offset counts from the end
+void patch_file(std::string const& filename, std::streamoff offset, std::int64_t value)
+{
+    std::fstream fs(filename, std::ios::binary | std::ios::in | std::ios::out);
+    fs.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+    fs.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+/// Write two frames of two pairs, returns the offset of the second frame
+std::streamoff write_two_frames(std::string const& filename, double precision = 0.0)
+{
+    std::ofstream os(filename, std::ios::binary);
+    BinaryPairwiseForcesWriter writer(os, 20, precision);
+    std::vector<BinaryPairwiseForce> frame0 = {{0, 1, 1.0, 1}, {2, 3, 2.0, 1}};
+    std::vector<BinaryPairwiseForce> frame1 = {{0, 1, 3.0, 1}, {4, 5, 4.0, 1}};
+    writer.write_frame(0, frame0);
+    std::streamoff offset = os.tellp();
+    writer.write_frame(1, frame1);
+    writer.write_index();
+    return offset;
+}
+
+} // namespace
+
+TEST_F(BinaryPairwiseForcesTest, CorruptedFile)
+{
+    // Index entries and trailer: two offsets, number of frames, magic
+    const std::streamoff second_offset_entry = -4 * static_cast<std::streamoff>(sizeof(std::int64_t));
+    const std::streamoff nb_frames_entry = -2 * static_cast<std::streamoff>(sizeof(std::int64_t));
+
+    std::string filename = fileManager().getTemporaryFilePath("corrupted.pfb");
+    std::streamoff offset = write_two_frames(filename);
+    EXPECT_NO_THROW(BinaryPairwiseForcesReader reader(filename));
+
+    // Frame offset behind the end of the frames
+    patch_file(filename, second_offset_entry, 1 << 20);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+
+    // Frame offset before the end of the previous frame
+    write_two_frames(filename);
+    patch_file(filename, second_offset_entry, offset - 8);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+
+    // Number of frames larger than the file
+    write_two_frames(filename);
+    patch_file(filename, nb_frames_entry, std::int64_t(1) << 60);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+    patch_file(filename, nb_frames_entry, -1);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+
+    // Number of pairs beyond the index
+    write_two_frames(filename);
+    patch_file(filename, offset + 8, 3);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+    patch_file(filename, offset + 8, -1);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+
+    // Size of the encoded frame beyond the index
+    offset = write_two_frames(filename, 1000.0);
+    EXPECT_NO_THROW(BinaryPairwiseForcesReader reader(filename));
+    patch_file(filename, offset + 16, 1 << 20);
+    EXPECT_THROW(BinaryPairwiseForcesReader reader(filename), std::runtime_error);
+}
+
+TEST_F(BinaryPairwiseForcesTest, CorruptedCompressedFrame)
+{
+    std::string filename = fileManager().getTemporaryFilePath("corrupted_frame.pfb");
+    std::streamoff offset = write_two_frames(filename, 1000.0);
+
+    // Unterminated variable-length integers in the second frame
+    patch_file(filename, offset + 24, -1);
+
+    BinaryPairwiseForcesReader reader(filename);
+    EXPECT_FLOAT_EQ(1.0, reader.begin(0)->force);
+    EXPECT_THROW(reader.begin(1), std::runtime_error);
+
+    // After the error nothing is decoded and the frames are decoded again from the key frame
+    EXPECT_EQ(2, reader.size(0));
+    EXPECT_FLOAT_EQ(2.0, reader.begin(0)[1].force);
+    EXPECT_THROW(reader.begin(1), std::runtime_error);
+}
+
+TEST_F(BinaryPairwiseForcesTest, CompressedFrames)
+{
+    // Pairs and forces changing slowly from frame to frame
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> index(0, 99);
+    std::normal_distribution<double> noise(0.0, 0.1);
+    std::vector<std::vector<BinaryPairwiseForce>> frames;
+    std::vector<BinaryPairwiseForce> pairwise_forces;
+    for (int i = 0; i != 1000; ++i) pairwise_forces.push_back(BinaryPairwiseForce(index(gen), index(gen), noise(gen) * 100, 1 << (i % 3)));
+    for (int frame = 0; frame != 250; ++frame) {
+        for (auto& pf : pairwise_forces) pf.force += noise(gen);
+        for (int k = 0; k != 20; ++k) pairwise_forces[index(gen) * 10] = BinaryPairwiseForce(index(gen), index(gen), noise(gen) * 100, 2);
+        frames.push_back(pairwise_forces);
+    }
+
+    double precision = 1000.0;
+    std::string plain_filename = fileManager().getTemporaryFilePath("plain.pfb");
+    std::string compressed_filename = fileManager().getTemporaryFilePath("compressed.pfb");
+    {
+        std::ofstream plain_os(plain_filename, std::ios::binary);
+        std::ofstream compressed_os(compressed_filename, std::ios::binary);
+        BinaryPairwiseForcesWriter plain_writer(plain_os, 100);
+        BinaryPairwiseForcesWriter compressed_writer(compressed_os, 100, precision);
+        for (size_t frame = 0; frame != frames.size(); ++frame) {
+            plain_writer.write_frame(frame, frames[frame]);
+            compressed_writer.write_frame(frame, frames[frame]);
+        }
+        plain_writer.write_index();
+        compressed_writer.write_index();
+    }
+
+    EXPECT_TRUE(BinaryPairwiseForcesReader::is_binary(compressed_filename));
+    EXPECT_LT(std::ifstream(compressed_filename, std::ios::binary | std::ios::ate).tellg() * 3,
+              std::ifstream(plain_filename, std::ios::binary | std::ios::ate).tellg());
+
+    BinaryPairwiseForcesReader reader(compressed_filename);
+    ASSERT_EQ(frames.size(), reader.number_of_frames());
+
+    // Sequential access and random access across key frames
+    std::vector<size_t> order(frames.size());
+    for (size_t frame = 0; frame != frames.size(); ++frame) order[frame] = frame;
+    order.insert(order.end(), {249, 3, 150, 99, 100, 0, 101});
+
+    for (auto frame : order) {
+        EXPECT_EQ(static_cast<std::int64_t>(frame), reader.frame_number(frame));
+        ASSERT_EQ(frames[frame].size(), reader.size(frame));
+        BinaryPairwiseForce const* pf = reader.begin(frame);
+        for (auto const& expected : frames[frame]) {
+            EXPECT_EQ(expected.i, pf->i);
+            EXPECT_EQ(expected.j, pf->j);
+            EXPECT_EQ(expected.type, pf->type);
+            EXPECT_NEAR(expected.force, pf->force, 0.5 / precision + std::abs(expected.force) * 1e-6);
+            ++pf;
+        }
+    }
+}
+
+} // namespace fda
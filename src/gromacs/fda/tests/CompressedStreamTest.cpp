@@ -0,0 +1,85 @@
+/*
+ * CompressedStreamTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "config.h"
+#include "gromacs/fda/CompressedStream.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+namespace fda
+{
+
+namespace {
+
+std::string write_text(std::string const& filename, bool compress)
+{
+    std::ostringstream text;
+    for (int frame = 0; frame != 100; ++frame) {
+        text << "frame " << frame << '\n';
+        for (int i = 0; i != 1000; ++i) text << i << " " << i + 1 << " " << 0.5 * i << '\n';
+    }
+
+    std::ofstream os(filename);
+    std::unique_ptr<CompressingStreamBuffer> compressor;
+    if (compress) {
+        compressor.reset(new CompressingStreamBuffer(os.rdbuf(), 1 << 12));
+        static_cast<std::ostream&>(os).rdbuf(compressor.get());
+    }
+    os << text.str();
+    return text.str();
+}
+
+std::string read_text(std::string const& filename)
+{
+    InputFileStream is(filename);
+    EXPECT_TRUE(is.is_open());
+    std::ostringstream text;
+    text << is.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+//! Test fixture for CompressedStream
+class CompressedStreamTest : public gmx::test::CommandLineTestBase
+{};
+
+#if GMX_FDA_ZLIB
+TEST_F(CompressedStreamTest, RoundTrip)
+{
+    EXPECT_TRUE(compression_available());
+
+    std::string filename = fileManager().getTemporaryFilePath("test.pfa.gz");
+    std::string text = write_text(filename, true);
+
+    EXPECT_TRUE(is_compressed(filename));
+    EXPECT_LT(static_cast<size_t>(std::ifstream(filename, std::ios::binary | std::ios::ate).tellg()), text.size() / 2);
+    EXPECT_EQ(text, read_text(filename));
+}
+#endif
+
+TEST_F(CompressedStreamTest, Uncompressed)
+{
+    std::string filename = fileManager().getTemporaryFilePath("test.pfa");
+    std::string text = write_text(filename, false);
+
+    EXPECT_FALSE(is_compressed(filename));
+    EXPECT_EQ(text, read_text(filename));
+}
+
+TEST_F(CompressedStreamTest, MissingFile)
+{
+    InputFileStream is(fileManager().getTemporaryFilePath("missing.pfa"));
+    EXPECT_FALSE(is.is_open());
+    EXPECT_FALSE(is);
+}
+
+} // namespace fda
@@ -0,0 +1,53 @@
+/*
+ * DetailedForceTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/fda/DetailedForce.h"
+
+namespace fda
+{
+
+namespace {
+
+std::vector<std::pair<PureInteractionType, real>> get_pair(DetailedForceList const& list, size_t p)
+{
+    std::vector<std::pair<PureInteractionType, real>> result;
+    list.for_each(p, [&result](PureInteractionType type, Vector const& force){ result.push_back({type, force[0]}); });
+    return result;
+}
+
+} // namespace
+
+TEST(DetailedForceTest, TypesAreOrderedAndSummed)
+{
+    DetailedForceList list;
+    list.add(0, Vector(1.0), PureInteractionType::LJ);
+    list.add(1, Vector(2.0), PureInteractionType::ANGLE);
+    list.add(0, Vector(3.0), PureInteractionType::BOND);
+    list.add(0, Vector(4.0), PureInteractionType::LJ);
+    list.add(0, Vector(5.0), PureInteractionType::COULOMB);
+
+    DetailedForceList other;
+    other.add(0, Vector(6.0), PureInteractionType::ANGLE);
+    list.add(1, other, 0);
+    list.add(2, other, 0);
+
+    EXPECT_EQ(3u, list.size());
+    std::vector<std::pair<PureInteractionType, real>> ref0 =
+        {{PureInteractionType::BOND, 3.0}, {PureInteractionType::COULOMB, 5.0}, {PureInteractionType::LJ, 5.0}};
+    EXPECT_EQ(ref0, get_pair(list, 0));
+    std::vector<std::pair<PureInteractionType, real>> ref1 = {{PureInteractionType::ANGLE, 8.0}};
+    EXPECT_EQ(ref1, get_pair(list, 1));
+
+    list.permute({2, 0, 1});
+    EXPECT_EQ(ref0, get_pair(list, 1));
+    EXPECT_EQ(ref1, get_pair(list, 2));
+}
+
+} // namespace fda
@@ -0,0 +1,76 @@
+/*
+ * DistributedForcesTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <sstream>
+#include <gtest/gtest.h>
+#include "gromacs/fda/DistributedForces.h"
+
+namespace fda
+{
+
+namespace {
+
+/// Returns the written pairs "i j" of the summed forces
+std::string summed_pairs(DistributedForces const& forces)
+{
+    std::ostringstream os;
+    forces.write_summed_vector(os);
+    std::istringstream is(os.str());
+    std::string pairs, line;
+    while (std::getline(is, line)) {
+        std::istringstream ls(line);
+        int i, j;
+        ls >> i >> j;
+        pairs += std::to_string(i) + "-" + std::to_string(j) + " ";
+    }
+    return pairs;
+}
+
+} // namespace
+
+TEST(DistributedForcesTest, FilterPairsAfterSummation)
+{
+    FDASettings fda_settings;
+    fda_settings.one_pair = OnePair::SUMMED;
+    fda_settings.force_threshold = 2.0;
+    DistributedForces forces(4, fda_settings);
+    gmx::HostVector<gmx::RVec> x(4);
+
+    // The single interactions of pair 0-1 are below the threshold, but not their sum
+    forces.add_summed(0, 1, Vector(1.0), InteractionType_LJ);
+    forces.add_summed(0, 1, Vector(1.0), InteractionType_COULOMB);
+    forces.add_summed(0, 2, Vector(0.5), InteractionType_LJ);
+    forces.add_summed(1, 3, Vector(3.0), InteractionType_LJ);
+    forces.add_summed(2, 3, Vector(-1.0), InteractionType_LJ);
+
+    forces.filter_pairs(x, true);
+    EXPECT_EQ("0-1 1-3 ", summed_pairs(forces));
+
+    // Pair index is rebuilt
+    forces.add_summed(0, 2, Vector(4.0), InteractionType_LJ);
+    EXPECT_EQ("0-1 0-2 1-3 ", summed_pairs(forces));
+}
+
+TEST(DistributedForcesTest, TopKPairs)
+{
+    FDASettings fda_settings;
+    fda_settings.one_pair = OnePair::SUMMED;
+    fda_settings.top_k_pairs = 1;
+    DistributedForces forces(4, fda_settings);
+    gmx::HostVector<gmx::RVec> x(4);
+
+    forces.add_summed(0, 1, Vector(4.0), InteractionType_LJ);
+    forces.add_summed(0, 2, Vector(2.0), InteractionType_LJ);
+    forces.add_summed(0, 3, Vector(1.0), InteractionType_LJ);
+    forces.add_summed(2, 3, Vector(0.5), InteractionType_LJ);
+
+    // 0-1 is the strongest pair of 0 and 1, 0-2 of 2, and 0-3 of 3
+    forces.filter_pairs(x, true);
+    EXPECT_EQ("0-1 0-2 0-3 ", summed_pairs(forces));
+}
+
+} // namespace fda
@@ -5,8 +5,14 @@
  *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
  */
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <gtest/gtest.h>
 #include "gromacs/fda/FDA.h"
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
 
 namespace fda {
 
@@ -37,4 +43,55 @@ TEST(FDATest, add_angle)
     fda.add_angle(0, 1, 2, f_i, f_j, f_k);
 }
 
+namespace {
+
+/// Write three frames of pairwise forces into filename and return the content of the result file
+std::string write_frames(std::string const& filename, bool async_output, int time_averaging_period)
+{
+    const int nb_atoms = 4;
+
+    FDASettings fda_settings;
+    fda_settings.atom_based_result_type = ResultType::PAIRWISE_FORCES_SCALAR;
+    fda_settings.one_pair = OnePair::SUMMED;
+    fda_settings.syslen_atoms = nb_atoms;
+    fda_settings.time_averaging_period = time_averaging_period;
+    fda_settings.async_output = async_output;
+    fda_settings.type = InteractionType_ALL;
+    fda_settings.sys_in_group1.assign(nb_atoms, 1);
+    fda_settings.sys_in_group2.assign(nb_atoms, 1);
+    fda_settings.atom_based_result_filename = filename;
+
+    gmx::HostVector<gmx::RVec> x(nb_atoms);
+    for (int i = 0; i != nb_atoms; ++i) x[i] = gmx::RVec(i, 0.5 * i, 0.0);
+    {
+        FDA fda(fda_settings);
+        for (int step = 0; step != 3; ++step) {
+            fda.add_nonbonded(0, 1 + step, 1.0 + step, -2.0, 1.0, 0.5, 0.0);
+            fda.add_nonbonded(1, 3, 3.0, 0.5 * step, 1.0, 0.5, 0.0);
+            fda.save_and_write_scalar_time_averages(x);
+        }
+        fda.write_scalar_time_averages();
+    }
+
+    std::ifstream is(filename);
+    std::stringstream content;
+    content << is.rdbuf();
+    return content.str();
+}
+
+} // namespace
+
+//! Test fixture for the output of FDA
+class FDAOutputTest : public gmx::test::CommandLineTestBase
+{};
+
+TEST_F(FDAOutputTest, AsyncOutputIsIdentical)
+{
+    for (int time_averaging_period : {1, 2}) {
+        std::string sync = write_frames(fileManager().getTemporaryFilePath("sync.pfa"), false, time_averaging_period);
+        EXPECT_FALSE(sync.empty());
+        EXPECT_EQ(sync, write_frames(fileManager().getTemporaryFilePath("async.pfa"), true, time_averaging_period));
+    }
+}
+
 } // namespace fda
@@ -0,0 +1,93 @@
+/*
+ * NonbondedPairBufferTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <gtest/gtest.h>
+#include "gromacs/fda/NonbondedPairBuffer.h"
+
+namespace fda
+{
+
+TEST(NonbondedPairBufferTest, MaskGroupsAndTinyForces)
+{
+    FDASettings settings;
+    settings.sys_in_group1 = {1, 1, 0, 0};
+    settings.sys_in_group2 = {0, 0, 1, 1};
+
+    // i-cluster: atoms 0, 1; j-cluster: atom 2 and a filler particle
+    std::vector<int> cellInv = {0, 1, 2, -1};
+    std::vector<real> fcoul = {1.0, 2.0, 0.0, 3.0};
+    std::vector<real> fvdw  = {0.5, 0.0, 0.0, 4.0};
+    std::vector<real> dx = {0.1, 0.2, 0.3, 0.4};
+    std::vector<real> dy = {0.0, 0.0, 0.0, 0.0};
+    std::vector<real> dz = {0.0, 0.0, 0.0, 0.0};
+
+    NonbondedPairBuffer buffer(settings);
+    buffer.add_cluster_pair(cellInv.data(), 0, 2, 2, 2,
+        fcoul.data(), fvdw.data(), dx.data(), dy.data(), dz.data());
+
+    // (0,2) is kept, (0,-1) is a filler, (1,2) has no force, (1,-1) is a filler
+    ASSERT_EQ(1, buffer.size());
+    EXPECT_EQ(0, buffer.i[0]);
+    EXPECT_EQ(2, buffer.j[0]);
+    EXPECT_FLOAT_EQ(1.0, buffer.fcoul[0]);
+    EXPECT_FLOAT_EQ(0.5, buffer.fvdw[0]);
+    EXPECT_FLOAT_EQ(0.1, buffer.dx[0]);
+
+    // Same group is masked out
+    std::vector<int> cellInvSameGroup = {0, 1, 0, 1};
+    buffer.add_cluster_pair(cellInvSameGroup.data(), 0, 2, 2, 2,
+        fcoul.data(), fvdw.data(), dx.data(), dy.data(), dz.data());
+    EXPECT_EQ(1, buffer.size());
+
+    buffer.clear();
+    EXPECT_EQ(0, buffer.size());
+}
+
+TEST(NonbondedPairBufferTest, GlobalAtomIndex)
+{
+    FDASettings settings;
+    settings.sys_in_group1 = {1, 0, 0, 0};
+    settings.sys_in_group2 = {0, 0, 0, 1};
+
+    // local atoms 0, 1 are the global atoms 3, 0
+    std::vector<int> gatindex = {3, 0};
+    std::vector<int> cellInv = {0, 1};
+    std::vector<real> fcoul = {1.0, 2.0};
+    std::vector<real> fvdw  = {0.0, 0.0};
+    std::vector<real> d = {0.0, 0.0};
+
+    NonbondedPairBuffer buffer(settings);
+    buffer.set_global_atom_index(gatindex.data());
+    buffer.add_cluster_pair(cellInv.data(), 0, 1, 1, 1,
+        fcoul.data(), fvdw.data(), d.data(), d.data(), d.data());
+
+    // group masks are checked with global indices, local indices are stored
+    ASSERT_EQ(1, buffer.size());
+    EXPECT_EQ(0, buffer.i[0]);
+    EXPECT_EQ(1, buffer.j[0]);
+}
+
+TEST(NonbondedPairBufferTest, ClusterPairInGroups)
+{
+    FDASettings settings;
+    NonbondedPairBuffer buffer(settings);
+
+    // Without group masks all cluster pairs are accepted
+    EXPECT_TRUE(buffer.cluster_pair_in_groups(0, 2, 2, 2));
+
+    // Clusters of two atoms: {group1, none}, {none, none}, {group2, filler}, {group1 and group2, none}
+    std::vector<unsigned char> masks = {1, 0, 0, 0, 2, 0, 3, 0};
+    buffer.set_group_masks(masks.data());
+
+    EXPECT_TRUE(buffer.cluster_pair_in_groups(0, 2, 4, 2));
+    EXPECT_TRUE(buffer.cluster_pair_in_groups(4, 2, 0, 2));
+    EXPECT_FALSE(buffer.cluster_pair_in_groups(0, 2, 2, 2));
+    EXPECT_FALSE(buffer.cluster_pair_in_groups(0, 2, 0, 2));
+    EXPECT_TRUE(buffer.cluster_pair_in_groups(6, 2, 6, 2));
+}
+
+} // namespace fda
@@ -0,0 +1,48 @@
+/*
+ * PairIndexTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <gtest/gtest.h>
+#include "gromacs/fda/PairIndex.h"
+
+namespace fda
+{
+
+TEST(PairIndexTest, Empty)
+{
+    PairIndex pair_index;
+    EXPECT_EQ(0, pair_index.size());
+    EXPECT_EQ(-1, pair_index.find(0));
+    EXPECT_EQ(-1, pair_index.find(42));
+}
+
+TEST(PairIndexTest, InsertAndFind)
+{
+    PairIndex pair_index;
+    for (int p = 0; p != 1000; ++p) pair_index.insert(7 * p + 3, p);
+
+    EXPECT_EQ(1000, pair_index.size());
+    for (int p = 0; p != 1000; ++p) EXPECT_EQ(p, pair_index.find(7 * p + 3));
+    EXPECT_EQ(-1, pair_index.find(0));
+    EXPECT_EQ(-1, pair_index.find(7 * 1000 + 3));
+}
+
+TEST(PairIndexTest, Clear)
+{
+    PairIndex pair_index;
+    pair_index.insert(5, 0);
+    pair_index.insert(1, 1);
+    pair_index.clear();
+
+    EXPECT_EQ(0, pair_index.size());
+    EXPECT_EQ(-1, pair_index.find(5));
+
+    pair_index.insert(1, 0);
+    EXPECT_EQ(0, pair_index.find(1));
+    EXPECT_EQ(-1, pair_index.find(5));
+}
+
+} // namespace fda
@@ -0,0 +1,40 @@
+/*
+ * RunningAverageTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gromacs/fda/RunningAverage.h"
+
+namespace fda
+{
+
+TEST(RunningAverageTest, MissingStepsAreZero)
+{
+    // The pair is missing in steps 1, 4, and 6
+    std::vector<double> values = {0.0, 2.0, -1.0, 0.0, 4.0, 0.0};
+
+    RunningAverage average;
+    for (size_t n = 0; n != values.size(); ++n) {
+        if (values[n] != 0.0) average.add(values[n], n + 1);
+    }
+    average.add_zeros(values.size());
+
+    double mean = 0.0;
+    for (auto v : values) mean += v;
+    mean /= values.size();
+    double variance = 0.0;
+    for (auto v : values) variance += (v - mean) * (v - mean);
+    variance /= values.size();
+
+    EXPECT_EQ(6, average.count);
+    EXPECT_DOUBLE_EQ(mean, average.mean);
+    EXPECT_DOUBLE_EQ(variance, average.variance());
+    EXPECT_DOUBLE_EQ(std::sqrt(variance), average.stddev());
+}
+
+} // namespace fda
@@ -0,0 +1,120 @@
+/*
+ * TextWriterTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <gtest/gtest.h>
+#include "gromacs/fda/TextWriter.h"
+
+namespace fda
+{
+
+namespace {
+
+template <class T>
+std::string with_ostream(T value)
+{
+    std::ostringstream os;
+    os << std::scientific << std::setprecision(6) << value;
+    return os.str();
+}
+
+template <class T>
+std::string with_text_writer(T value)
+{
+    std::ostringstream os;
+    {
+        TextWriter writer(os);
+        writer << value;
+    }
+    return os.str();
+}
+
+} // namespace
+
+TEST(TextWriterTest, SameAsOstreamForRandomFloats)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::uint32_t> bits;
+    for (int n = 0; n != 100000; ++n) {
+        // All bit patterns, including denormals, infinities, and NaNs
+        std::uint32_t b = bits(gen);
+        float value;
+        std::memcpy(&value, &b, sizeof(value));
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+    }
+}
+
+TEST(TextWriterTest, SameAsOstreamForSpecialValues)
+{
+    for (double value : {0.0, -0.0, 1.0, -1.0, 0.5, 9.9999995, 123456.75, 1e-22, 1e22, 1e300, 5e-324,
+                         std::numeric_limits<double>::infinity()}) {
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+    }
+    for (long long value : {0ll, 1ll, -1ll, std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max()}) {
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+    }
+}
+
+TEST(TextWriterTest, SameAsOstreamForTies)
+{
+    // Floats with eight significant digits ending in 5 lie exactly between two outputs
+    for (std::int32_t n = 10000005; n < (1 << 24); n += 990) {
+        float value = static_cast<float>(n);
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+        EXPECT_EQ(with_ostream(-value), with_text_writer(-value));
+    }
+    // Doubles with the tie digit followed by zeros at all exactly representable magnitudes
+    for (double value = 12345675.0; value < 1e22; value *= 10.0) {
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+        EXPECT_EQ(with_ostream(value * 0.5), with_text_writer(value * 0.5));
+        EXPECT_EQ(with_ostream(value * 0.25), with_text_writer(value * 0.25));
+    }
+}
+
+TEST(TextWriterTest, SameAsOstreamAtPowersOfTen)
+{
+    // Rounding to the next power of ten changes the exponent
+    for (int e = -45; e <= 38; ++e) {
+        float value = std::pow(10.0f, static_cast<float>(e));
+        for (float v : {value, std::nextafter(value, 0.0f), std::nextafter(value, std::numeric_limits<float>::infinity()),
+                        value * 0.99999995f, value * 9.9999995f}) {
+            EXPECT_EQ(with_ostream(v), with_text_writer(v));
+        }
+    }
+    for (int e = -323; e <= 308; ++e) {
+        double value = std::pow(10.0, e);
+        for (double v : {value, std::nextafter(value, 0.0), std::nextafter(value, std::numeric_limits<double>::infinity()),
+                         value * 0.99999995, value * 9.9999995}) {
+            EXPECT_EQ(with_ostream(v), with_text_writer(v));
+        }
+    }
+    for (float value : {std::numeric_limits<float>::min(), std::numeric_limits<float>::denorm_min(),
+                        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()}) {
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+    }
+    for (double value : {std::numeric_limits<double>::min(), std::numeric_limits<double>::max()}) {
+        EXPECT_EQ(with_ostream(value), with_text_writer(value));
+    }
+}
+
+TEST(TextWriterTest, SmallBuffer)
+{
+    std::ostringstream os;
+    {
+        TextWriter writer(os, 1);
+        writer << "frame " << 12 << '\n' << std::string(100, 'x') << ' ' << 1.5f;
+    }
+    EXPECT_EQ("frame 12\n" + std::string(100, 'x') + " 1.500000e+00", os.str());
+}
+
+} // namespace fda
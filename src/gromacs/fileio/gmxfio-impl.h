@@ -58,6 +58,8 @@
 
 #include "gromacs/fileio/xdrf.h"
 
+struct t_xtc_index;
+
 struct t_fileio
 {
     FILE           *fp;                /* the file pointer */
@@ -68,6 +70,8 @@ struct t_fileio
     XDR         *xdr;                  /* the xdr data pointer */
     enum xdr_op  xdrmode;              /* the xdr mode */
     int          iFTP;                 /* the file type identifier */
+    t_xtc_index *xtcIndex;             /* frame index for seeking in xtc files,
+                                          loaded on the first seek */
 
     t_fileio    *next, *prev;          /* next and previous file pointers in the
                                           linked list */
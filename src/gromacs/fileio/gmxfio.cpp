@@ -55,6 +55,7 @@
 
 #include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/md5.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/mutex.h"
@@ -385,6 +386,7 @@ int gmx_fio_close(t_fileio *fio)
     rc = gmx_fio_close_locked(fio);
     gmx_fio_unlock(fio);
 
+    delete fio->xtcIndex;
     sfree(fio->fn);
     sfree(fio);
 
@@ -797,7 +799,18 @@ int xtc_seek_time(t_fileio *fio, real time, int natoms, gmx_bool bSeekForwardOnl
     int ret;
 
     gmx_fio_lock(fio);
-    ret = xdr_xtc_seek_time(time, fio->fp, fio->xdr, natoms, bSeekForwardOnly);
+    if (fio->bRead && fio->iFTP == efXTC && fio->xtcIndex == nullptr)
+    {
+        fio->xtcIndex = xtc_index_load(fio->fn);
+    }
+    if (fio->xtcIndex != nullptr && !fio->xtcIndex->offset.empty())
+    {
+        ret = xtc_index_seek_time(*fio->xtcIndex, fio->fp, time, bSeekForwardOnly);
+    }
+    else
+    {
+        ret = xdr_xtc_seek_time(time, fio->fp, fio->xdr, natoms, bSeekForwardOnly);
+    }
     gmx_fio_unlock(fio);
 
     return ret;
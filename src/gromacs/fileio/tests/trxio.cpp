@@ -0,0 +1,143 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2026, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading trajectories ahead with trx_prefetch()
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trxio.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+const int c_natoms  = 5;
+const int c_nframes = 10;
+
+class TrxPrefetchTest : public ::testing::Test
+{
+    public:
+        TrxPrefetchTest()
+            : filename_(fileManager_.getTemporaryFilePath(".xtc")), oenv_(nullptr)
+        {
+            output_env_init_default(&oenv_);
+            matrix box = {{3, 0, 0}, {0, 3, 0}, {0, 0, 3}};
+            rvec   x[c_natoms];
+            t_fileio *fio = open_xtc(filename_.c_str(), "w");
+            for (int frame = 0; frame < c_nframes; ++frame)
+            {
+                for (int i = 0; i < c_natoms; ++i)
+                {
+                    x[i][XX] = frame;
+                    x[i][YY] = 0.1*i;
+                    x[i][ZZ] = 0.5;
+                }
+                write_xtc(fio, c_natoms, frame, frame, box, x, 1000);
+            }
+            close_xtc(fio);
+        }
+        ~TrxPrefetchTest()
+        {
+            output_env_done(oenv_);
+        }
+
+        //! Checks that fr is the frame written as number frame
+        void checkFrame(const t_trxframe &fr, int frame)
+        {
+            EXPECT_EQ(frame, fr.step);
+            EXPECT_EQ(frame, fr.time);
+            ASSERT_TRUE(fr.bX);
+            for (int i = 0; i < c_natoms; ++i)
+            {
+                EXPECT_NEAR(frame, fr.x[i][XX], 1e-3);
+                EXPECT_NEAR(0.1*i, fr.x[i][YY], 1e-3);
+            }
+        }
+
+        gmx::test::TestFileManager  fileManager_;
+        std::string                 filename_;
+        gmx_output_env_t           *oenv_;
+};
+
+TEST_F(TrxPrefetchTest, ReadsAllFrames)
+{
+    t_trxstatus *status;
+    t_trxframe   fr;
+    ASSERT_TRUE(read_first_frame(oenv_, &status, filename_.c_str(), &fr, TRX_NEED_X));
+    trx_prefetch(oenv_, status, &fr, 3);
+    int frame = 0;
+    do
+    {
+        checkFrame(fr, frame++);
+    }
+    while (read_next_frame(oenv_, status, &fr));
+    EXPECT_EQ(c_nframes, frame);
+    close_trx(status);
+    sfree(fr.x);
+}
+
+TEST_F(TrxPrefetchTest, RepositionsFileWhenStopped)
+{
+    t_trxstatus *status;
+    t_trxframe   fr;
+    ASSERT_TRUE(read_first_frame(oenv_, &status, filename_.c_str(), &fr, TRX_NEED_X));
+    trx_prefetch(oenv_, status, &fr, 3);
+    for (int frame = 1; frame < 4; ++frame)
+    {
+        ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    }
+    // Accessing the file stops the reading ahead.
+    ASSERT_NE(nullptr, trx_get_fileio(status));
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    checkFrame(fr, 4);
+    close_trx(status);
+    sfree(fr.x);
+}
+
+} // namespace
@@ -0,0 +1,182 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2026, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the xtc frame index
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcindex.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+const int c_nframes = 6;
+
+class XtcIndexTest : public ::testing::Test
+{
+    public:
+        XtcIndexTest()
+            : filename_(fileManager_.getTemporaryFilePath(".xtc"))
+        {
+            // Registers the index file for removal
+            fileManager_.getTemporaryFilePath(".xtc.idx");
+            matrix    box = {{3, 0, 0}, {0, 3, 0}, {0, 0, 3}};
+            // More than nine atoms to get compressed coordinates
+            rvec      x[20];
+            t_fileio *fio = open_xtc(filename_.c_str(), "w");
+            for (int frame = 0; frame < c_nframes; ++frame)
+            {
+                for (int i = 0; i < 20; ++i)
+                {
+                    x[i][XX] = 0.1*i*frame;
+                    x[i][YY] = 0.2*i;
+                    x[i][ZZ] = 0.3;
+                }
+                offsets_.push_back(gmx_fio_ftell(fio));
+                write_xtc(fio, 20, 10*frame, 0.5*frame, box, x, 1000);
+            }
+            close_xtc(fio);
+        }
+
+        gmx::test::TestFileManager  fileManager_;
+        std::string                 filename_;
+        std::vector<gmx_off_t>      offsets_;
+};
+
+TEST_F(XtcIndexTest, BuildsIndexFromHeaders)
+{
+    t_xtc_index index;
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    ASSERT_EQ(static_cast<size_t>(c_nframes), index.offset.size());
+    for (int frame = 0; frame < c_nframes; ++frame)
+    {
+        EXPECT_EQ(offsets_[frame], index.offset[frame]);
+        EXPECT_EQ(10*frame, index.step[frame]);
+        EXPECT_EQ(0.5*frame, index.time[frame]);
+    }
+}
+
+TEST_F(XtcIndexTest, ReadsIndexFileOnlyForUnchangedTrajectory)
+{
+    t_xtc_index index, readIndex;
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    ASSERT_TRUE(xtc_index_write(filename_.c_str(), index));
+    ASSERT_TRUE(xtc_index_read(filename_.c_str(), &readIndex));
+    EXPECT_EQ(index.offset, readIndex.offset);
+    EXPECT_EQ(index.step, readIndex.step);
+    EXPECT_EQ(index.time, readIndex.time);
+
+    // Appending a frame changes the size of the trajectory
+    matrix    box = {{3, 0, 0}, {0, 3, 0}, {0, 0, 3}};
+    rvec      x[20];
+    clear_rvecs(20, x);
+    t_fileio *fio = open_xtc(filename_.c_str(), "a");
+    write_xtc(fio, 20, 10*c_nframes, 0.5*c_nframes, box, x, 1000);
+    close_xtc(fio);
+    EXPECT_FALSE(xtc_index_read(filename_.c_str(), &readIndex));
+}
+
+TEST_F(XtcIndexTest, RejectsIndexWhoseLastFrameDoesNotMatch)
+{
+    // Size and modification time match, but the last frame was rewritten
+    t_xtc_index index, readIndex;
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    index.time.back() += 1;
+    ASSERT_TRUE(xtc_index_write(filename_.c_str(), index));
+    EXPECT_FALSE(xtc_index_read(filename_.c_str(), &readIndex));
+
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    index.offset.pop_back();
+    index.step.pop_back();
+    index.time.pop_back();
+    ASSERT_TRUE(xtc_index_write(filename_.c_str(), index));
+    EXPECT_FALSE(xtc_index_read(filename_.c_str(), &readIndex));
+}
+
+TEST_F(XtcIndexTest, SeeksToTime)
+{
+    t_xtc_index index;
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    FILE       *fp = std::fopen(filename_.c_str(), "rb");
+    ASSERT_EQ(0, xtc_index_seek_time(index, fp, 1.2, FALSE));
+    EXPECT_EQ(offsets_[3], gmx_ftell(fp));
+    EXPECT_EQ(0, xtc_index_seek_time(index, fp, 0, TRUE));
+    EXPECT_EQ(offsets_[3], gmx_ftell(fp));
+    EXPECT_EQ(-1, xtc_index_seek_time(index, fp, 10, FALSE));
+    std::fclose(fp);
+}
+
+TEST_F(XtcIndexTest, ReadsFramesConcurrently)
+{
+    t_xtc_index index;
+    ASSERT_TRUE(xtc_index_build(filename_.c_str(), &index));
+    const int   frames[] = {1, 2, 4, 5};
+    t_trxframe  fr[4];
+    t_trxframe *frp[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        clear_trxframe(&fr[i], TRUE);
+        fr[i].natoms = 20;
+        snew(fr[i].x, 20);
+        frp[i] = &fr[i];
+    }
+    ASSERT_TRUE(xtc_read_frames(filename_.c_str(), index, 4, frames, frp, 2));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(10*frames[i], fr[i].step);
+        EXPECT_EQ(0.5*frames[i], fr[i].time);
+        EXPECT_TRUE(fr[i].bX);
+        EXPECT_NEAR(0.1*19*frames[i], fr[i].x[19][XX], 1e-3);
+        sfree(fr[i].x);
+    }
+}
+
+} // namespace
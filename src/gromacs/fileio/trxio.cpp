@@ -42,8 +42,15 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/filetypes.h"
@@ -58,6 +65,7 @@
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xdrf.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/md_enums.h"
@@ -79,6 +87,8 @@
 #define SKIP2  100
 #define SKIP3 1000
 
+struct TrxPrefetch;
+
 struct t_trxstatus
 {
     int                     flags;            /* flags for read_first/next_frame  */
@@ -96,8 +106,53 @@ struct t_trxstatus
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t        *vmdplugin;
 #endif
+    TrxPrefetch            *prefetch;        /* Background reader, NULL if not prefetching */
+};
+
+/* A frame decoded by the prefetch thread, together with the reader state
+ * before it was read, such that the file can be put back at this frame.
+ */
+struct TrxPrefetchSlot
+{
+    t_trxframe              fr;
+    bool                    bRet;
+    gmx_off_t               fpos;
+    real                    tf;
+    int                     frame;
+    int                     frameAfter;
+};
+
+/* Ring of frames which are read ahead on a background thread.
+ * While the thread runs, it is the only user of the t_trxstatus.
+ */
+struct TrxPrefetch
+{
+    std::thread                  thread;
+    std::mutex                   mutex;
+    std::condition_variable      cond;
+    std::vector<TrxPrefetchSlot> slots;
+    const gmx_output_env_t      *oenv;
+    /* Number of frames read and consumed, slot i % slots.size() holds frame i */
+    long                         nread;
+    long                         nconsumed;
+    /* Frame counter after the last consumed frame, for nframes_read() */
+    int                          frame;
+    bool                         bEnd;
+    bool                         bStop;
+    /* Frame index of an xtc file for decoding frames concurrently, can be NULL */
+    t_xtc_index                 *xtcIndex;
+    /* Entry in xtcIndex of the next frame to read */
+    long                         xtcFrame;
+    /* File position after the last frame in xtcIndex */
+    gmx_off_t                    xtcEnd;
+    /* Number of threads for decoding xtc frames */
+    int                          nthreads;
 };
 
+static bool read_next_frame_direct(const gmx_output_env_t *oenv, t_trxstatus *status,
+                                   t_trxframe *fr);
+static void trx_stop_prefetch(t_trxstatus *status);
+
 /* utility functions */
 
 gmx_bool bRmod_fd(double a, double b, double c, gmx_bool bDouble)
@@ -175,11 +230,16 @@ static void status_init(t_trxstatus *status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->prefetch        = nullptr;
 }
 
 
 int nframes_read(t_trxstatus *status)
 {
+    if (status->prefetch)
+    {
+        return status->prefetch->frame;
+    }
     return status->__frame;
 }
 
@@ -243,6 +303,8 @@ real ndec2prec(int ndec)
 
 t_fileio *trx_get_fileio(t_trxstatus *status)
 {
+    /* The caller can access the file directly */
+    trx_stop_prefetch(status);
     return status->fio;
 }
 
@@ -624,6 +686,7 @@ void close_trx(t_trxstatus *status)
     {
         return;
     }
+    trx_stop_prefetch(status);
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
@@ -810,7 +873,345 @@ static int pdb_first_x(t_trxstatus *status, FILE *fp, t_trxframe *fr)
     return fr->natoms;
 }
 
+/* Reads up to n frames of an xtc file into the slots starting at first,
+ * using the frame index of the file. The frames are selected as in
+ * read_next_frame_direct, but the skipped frames are not decoded and the
+ * selected frames are decoded concurrently.
+ * Returns the number of slots filled, bRet is false when the last filled
+ * slot marks the end of the trajectory.
+ */
+static int prefetch_xtc_frames(t_trxstatus *status, long first, int n, bool *bRet)
+{
+    TrxPrefetch                  *pf     = status->prefetch;
+    const t_xtc_index            &index  = *pf->xtcIndex;
+    const long                    nindex = index.offset.size();
+    std::vector<int>              frames;
+    std::vector<t_trxframe *>     frs;
+    std::vector<TrxPrefetchSlot *> slots;
+
+    *bRet = true;
+    while (*bRet && static_cast<int>(slots.size()) < n)
+    {
+        TrxPrefetchSlot *slot = &pf->slots[(first + slots.size()) % pf->slots.size()];
+        slot->fpos  = (pf->xtcFrame < nindex ? index.offset[pf->xtcFrame] : pf->xtcEnd);
+        slot->tf    = status->tf;
+        slot->frame = status->__frame;
+        real pt     = status->tf;
+        bool bFound = false;
+        while (!bFound && pf->xtcFrame < nindex)
+        {
+            if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+            {
+                /* As xtc_seek_time, but the frame times are known */
+                while (pf->xtcFrame < nindex && index.time[pf->xtcFrame] < rTimeValue(TBEGIN))
+                {
+                    pf->xtcFrame++;
+                }
+                if (pf->xtcFrame == nindex)
+                {
+                    gmx_fatal(FARGS, "Specified frame (time %f) doesn't exist or file corrupt/inconsistent.",
+                              rTimeValue(TBEGIN));
+                }
+                initcount(status);
+            }
+            real t     = index.time[pf->xtcFrame];
+            status->tf = t;
+            int  ct    = check_times2(t, status->t0, slot->fr.bDouble);
+            if (ct == 0 || ((status->flags & TRX_DONT_SKIP) && ct < 0))
+            {
+                printcount(status, pf->oenv, t, FALSE);
+                frames.push_back(pf->xtcFrame);
+                bFound = true;
+            }
+            else if (ct > 0)
+            {
+                pf->xtcFrame++;
+                break;
+            }
+            else
+            {
+                printcount(status, pf->oenv, t, TRUE);
+            }
+            pf->xtcFrame++;
+        }
+        slot->bRet       = bFound;
+        slot->frameAfter = status->__frame;
+        slot->fr.not_ok  = 0;
+        slots.push_back(slot);
+        if (bFound)
+        {
+            slot->fr.step = index.step[frames.back()];
+            frs.push_back(&slot->fr);
+        }
+        else
+        {
+            printlast(status, pf->oenv, pt);
+            *bRet = false;
+        }
+    }
+
+    if (!xtc_read_frames(gmx_fio_getname(status->fio), index, frames.size(),
+                         frames.data(), frs.data(), pf->nthreads))
+    {
+        /* End at the first frame that could not be decoded */
+        size_t i = 0;
+        while (frs[i]->not_ok == 0)
+        {
+            i++;
+        }
+        slots[i]->bRet = false;
+        slots.resize(i + 1);
+        printlast(status, pf->oenv, index.time[frames[i]]);
+        printincomp(status, frs[i]);
+        *bRet = false;
+    }
+
+    /* Keep the file at the next frame, as if the frames were read */
+    gmx_fio_seek(status->fio, pf->xtcFrame < nindex ? index.offset[pf->xtcFrame] : pf->xtcEnd);
+    return slots.size();
+}
+
+static void prefetch_thread(t_trxstatus *status)
+{
+    TrxPrefetch *pf     = status->prefetch;
+    const long   nslots = pf->slots.size();
+    /* Decode half of the frames while the other half is processed */
+    const long   nbatch = (pf->xtcIndex ? std::max(1L, nslots/2) : 1);
+    bool         bRet;
+    do
+    {
+        long first;
+        {
+            std::unique_lock<std::mutex> lock(pf->mutex);
+            pf->cond.wait(lock, [pf, nslots, nbatch] {
+                              return pf->bStop || nslots - (pf->nread - pf->nconsumed) >= nbatch;
+                          });
+            if (pf->bStop)
+            {
+                return;
+            }
+            first = pf->nread;
+        }
+        int count;
+        if (pf->xtcIndex)
+        {
+            count = prefetch_xtc_frames(status, first, nbatch, &bRet);
+        }
+        else
+        {
+            TrxPrefetchSlot *slot = &pf->slots[first % nslots];
+            slot->fpos       = status->fio ? gmx_fio_ftell(status->fio) : 0;
+            slot->tf         = status->tf;
+            slot->frame      = status->__frame;
+            bRet             = read_next_frame_direct(pf->oenv, status, &slot->fr);
+            slot->bRet       = bRet;
+            slot->frameAfter = status->__frame;
+            count            = 1;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pf->mutex);
+            pf->nread += count;
+            pf->bEnd   = !bRet;
+        }
+        pf->cond.notify_all();
+    }
+    while (bRet);
+}
+
+void trx_prefetch(const gmx_output_env_t *oenv, t_trxstatus *status,
+                  const t_trxframe *fr, int nframes)
+{
+    if (nframes <= 0 || status->prefetch)
+    {
+        return;
+    }
+    int ftp = status->tng ? efTNG : gmx_fio_getftp(status->fio);
+    if (ftp != efXTC && ftp != efTRR && ftp != efTNG)
+    {
+        return;
+    }
+
+    TrxPrefetch *pf = new TrxPrefetch;
+    pf->slots.resize(nframes);
+    for (TrxPrefetchSlot &slot : pf->slots)
+    {
+        slot.fr   = *fr;
+        slot.fr.x = nullptr;
+        slot.fr.v = nullptr;
+        slot.fr.f = nullptr;
+        if (fr->x)
+        {
+            snew(slot.fr.x, fr->natoms);
+        }
+        if (fr->v)
+        {
+            snew(slot.fr.v, fr->natoms);
+        }
+        if (fr->f)
+        {
+            snew(slot.fr.f, fr->natoms);
+        }
+    }
+    pf->oenv          = oenv;
+    pf->nread         = 0;
+    pf->nconsumed     = 0;
+    pf->frame         = status->__frame;
+    pf->bEnd          = false;
+    pf->bStop         = false;
+    pf->xtcIndex      = nullptr;
+    pf->xtcFrame      = 0;
+    pf->xtcEnd        = 0;
+    pf->nthreads      = std::max(1, std::min(nframes, static_cast<int>(std::thread::hardware_concurrency())));
+    if (ftp == efXTC && pf->nthreads > 1 && fr->x &&
+        !(status->flags & (TRX_NEED_V | TRX_NEED_F)))
+    {
+        /* With an index file, frames are decoded concurrently */
+        t_xtc_index *index = new t_xtc_index;
+        if (xtc_index_read(gmx_fio_getname(status->fio), index))
+        {
+            gmx_off_t position = gmx_fio_ftell(status->fio);
+            auto      next     = std::lower_bound(index->offset.begin(), index->offset.end(), position);
+            if (next == index->offset.end() || *next == position)
+            {
+                FILE *fp     = gmx_fio_getfp(status->fio);
+                pf->xtcIndex = index;
+                pf->xtcFrame = next - index->offset.begin();
+                gmx_fseek(fp, 0, SEEK_END);
+                pf->xtcEnd   = gmx_ftell(fp);
+                gmx_fio_seek(status->fio, position);
+            }
+        }
+        if (!pf->xtcIndex)
+        {
+            delete index;
+        }
+    }
+    status->prefetch  = pf;
+    pf->thread        = std::thread(prefetch_thread, status);
+}
+
+/* Stops the prefetch thread and puts the file back at the first frame
+ * that was read ahead but not yet returned by read_next_frame.
+ */
+static void trx_stop_prefetch(t_trxstatus *status)
+{
+    TrxPrefetch *pf = status->prefetch;
+    if (!pf)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pf->mutex);
+        pf->bStop = true;
+    }
+    pf->cond.notify_all();
+    pf->thread.join();
+    status->prefetch = nullptr;
+
+    if (pf->nconsumed < pf->nread)
+    {
+        TrxPrefetchSlot &slot = pf->slots[pf->nconsumed % pf->slots.size()];
+        if (status->fio && gmx_fio_seek(status->fio, slot.fpos))
+        {
+            gmx_fatal(FARGS, "Could not reposition trajectory file %s after reading ahead",
+                      gmx_fio_getname(status->fio));
+        }
+        status->tf      = slot.tf;
+        status->__frame = slot.frame;
+    }
+    for (TrxPrefetchSlot &slot : pf->slots)
+    {
+        sfree(slot.fr.x);
+        sfree(slot.fr.v);
+        sfree(slot.fr.f);
+    }
+    delete pf->xtcIndex;
+    delete pf;
+}
+
+/* Returns the next frame decoded by the prefetch thread in fr */
+static bool read_next_prefetched_frame(t_trxstatus *status, t_trxframe *fr)
+{
+    TrxPrefetch     *pf = status->prefetch;
+    TrxPrefetchSlot *slot;
+    {
+        std::unique_lock<std::mutex> lock(pf->mutex);
+        pf->cond.wait(lock, [pf] { return pf->nconsumed < pf->nread; });
+        slot = &pf->slots[pf->nconsumed % pf->slots.size()];
+    }
+
+    const t_trxframe &src = slot->fr;
+    clear_trxframe(fr, FALSE);
+    fr->not_ok    = src.not_ok;
+    fr->bDouble   = src.bDouble;
+    fr->natoms    = src.natoms;
+    fr->bStep     = src.bStep;
+    fr->step      = src.step;
+    fr->bTime     = src.bTime;
+    fr->time      = src.time;
+    fr->bLambda   = src.bLambda;
+    fr->lambda    = src.lambda;
+    fr->bFepState = src.bFepState;
+    fr->fep_state = src.fep_state;
+    fr->bPrec     = src.bPrec;
+    fr->prec      = src.prec;
+    fr->bBox      = src.bBox;
+    copy_mat(src.box, fr->box);
+    fr->bX        = src.bX;
+    fr->bV        = src.bV;
+    fr->bF        = src.bF;
+    if (src.bX)
+    {
+        if (fr->x == nullptr)
+        {
+            snew(fr->x, src.natoms);
+        }
+        std::memcpy(fr->x, src.x, src.natoms*sizeof(*fr->x));
+    }
+    if (src.bV)
+    {
+        if (fr->v == nullptr)
+        {
+            snew(fr->v, src.natoms);
+        }
+        std::memcpy(fr->v, src.v, src.natoms*sizeof(*fr->v));
+    }
+    if (src.bF)
+    {
+        if (fr->f == nullptr)
+        {
+            snew(fr->f, src.natoms);
+        }
+        std::memcpy(fr->f, src.f, src.natoms*sizeof(*fr->f));
+    }
+    bool bRet = slot->bRet;
+    pf->frame = slot->frameAfter;
+
+    {
+        std::lock_guard<std::mutex> lock(pf->mutex);
+        pf->nconsumed++;
+    }
+    pf->cond.notify_all();
+
+    if (!bRet)
+    {
+        /* The reader is at the end, the thread has finished */
+        trx_stop_prefetch(status);
+    }
+    return bRet;
+}
+
 bool read_next_frame(const gmx_output_env_t *oenv, t_trxstatus *status, t_trxframe *fr)
+{
+    if (status->prefetch)
+    {
+        return read_next_prefetched_frame(status, fr);
+    }
+    return read_next_frame_direct(oenv, status, fr);
+}
+
+static bool read_next_frame_direct(const gmx_output_env_t *oenv, t_trxstatus *status,
+                                   t_trxframe *fr)
 {
     real     pt;
     int      ct;
@@ -1085,6 +1486,11 @@ bool read_first_frame(const gmx_output_env_t *oenv, t_trxstatus **status,
      */
     (*status)->natoms = fr->natoms;
 
+    if (fr->natoms > 0 && std::getenv("GMX_TRX_PREFETCH") != nullptr)
+    {
+        trx_prefetch(oenv, *status, fr, std::atoi(std::getenv("GMX_TRX_PREFETCH")));
+    }
+
     return (fr->natoms > 0);
 }
 
@@ -1122,6 +1528,7 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
 
 void rewind_trj(t_trxstatus *status)
 {
+    trx_stop_prefetch(status);
     initcount(status);
 
     gmx_fio_rewind(status->fio);
@@ -227,6 +227,19 @@ gmx_bool read_next_x(const gmx_output_env_t *oenv, t_trxstatus *status, real *t,
  * status is the integer set in read_first_x.
  */
 
+void trx_prefetch(const gmx_output_env_t *oenv, t_trxstatus *status,
+                  const struct t_trxframe *fr, int nframes);
+/* Start decoding up to nframes frames ahead of read_next_frame on a
+ * background thread, fr should be the frame from read_first_frame.
+ * read_next_frame then copies the decoded frames into its argument,
+ * such that decoding overlaps with the processing of the previous frames.
+ * Only xtc, trr and tng files are read ahead, for other files and for
+ * nframes <= 0 nothing is done.  The reading ahead stops when the file
+ * is accessed otherwise (trx_get_fileio, rewind_trj) and in close_trx.
+ * read_first_frame calls this when the environment variable
+ * GMX_TRX_PREFETCH is set to the number of frames.
+ */
+
 void rewind_trj(t_trxstatus *status);
 /* Rewind trajectory file as opened with read_first_x */
 
@@ -0,0 +1,386 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2026, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the frame index of xtc files.
+ *
+ * The index file contains a header with a magic string, a byte order mark,
+ * the size and modification time of the xtc file and the number of frames,
+ * followed by the offsets, steps and times of the frames in native format.
+ * As the modification time has a resolution of one second, an index is
+ * only used if also its last frame ends at the end of the xtc file.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "xtcindex.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <thread>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+
+namespace
+{
+
+//! Magic number of xtc frames, must match XTC_MAGIC in xtcio.cpp.
+const int         c_xtcMagic        = 1995;
+//! Magic string of the index file, with the format version.
+const char        c_indexMagic[8]   = { 'G', 'M', 'X', 'X', 'I', 'D', 'X', '1' };
+//! Byte order mark of the index file.
+const gmx_int32_t c_indexByteOrder  = 0x01020304;
+
+/*! \brief
+ * Returns the size and modification time of \p fn.
+ */
+bool getFileStatus(const char *fn, gmx_int64_t *size, gmx_int64_t *mtime)
+{
+    struct stat st;
+    if (stat(fn, &st) != 0)
+    {
+        return false;
+    }
+    *size  = st.st_size;
+    *mtime = st.st_mtime;
+    return true;
+}
+
+//! Header of the index file.
+struct IndexHeader
+{
+    char        magic[8];
+    gmx_int32_t byteOrder;
+    gmx_int32_t realSize;
+    gmx_int64_t fileSize;
+    gmx_int64_t fileTime;
+    gmx_int64_t frameCount;
+};
+
+/*! \brief
+ * Reads the header and the coordinate size of a frame and skips the
+ * coordinates.
+ *
+ * Returns 1 for a complete frame, 0 at the end of the file and -1 for an
+ * invalid or incomplete frame.
+ */
+int skipFrame(XDR *xdrs, FILE *fp, gmx_off_t fileSize, gmx_int64_t *step, real *time)
+{
+    int   magic, natoms, intStep, lsize;
+    float ftime, box[9];
+    if (!xdr_int(xdrs, &magic))
+    {
+        return 0;
+    }
+    if (magic != c_xtcMagic || !xdr_int(xdrs, &natoms) || !xdr_int(xdrs, &intStep)
+        || !xdr_float(xdrs, &ftime))
+    {
+        return -1;
+    }
+    for (float &b : box)
+    {
+        if (!xdr_float(xdrs, &b))
+        {
+            return -1;
+        }
+    }
+    if (!xdr_int(xdrs, &lsize) || lsize != natoms)
+    {
+        return -1;
+    }
+    gmx_off_t dataSize;
+    if (lsize <= 9)
+    {
+        dataSize = 3*lsize*sizeof(float);
+    }
+    else
+    {
+        // Precision, minint[3], maxint[3] and smallidx precede the byte count
+        int byteCount;
+        if (gmx_fseek(fp, 8*sizeof(int), SEEK_CUR) != 0 || !xdr_int(xdrs, &byteCount)
+            || byteCount < 0)
+        {
+            return -1;
+        }
+        dataSize = ((byteCount + 3)/4)*4;
+    }
+    const gmx_off_t end = gmx_ftell(fp) + dataSize;
+    if (end > fileSize || gmx_fseek(fp, end, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+    *step = intStep;
+    *time = ftime;
+    return 1;
+}
+
+/*! \brief
+ * Returns whether the last frame of \p index is a complete frame of \p fn
+ * that ends at the end of the file.
+ */
+bool lastFrameMatches(const char *fn, const t_xtc_index &index, gmx_off_t fileSize)
+{
+    if (index.offset.empty())
+    {
+        return fileSize == 0;
+    }
+    FILE *fp = std::fopen(fn, "rb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    XDR xdr;
+    xdrstdio_create(&xdr, fp, XDR_DECODE);
+    gmx_int64_t step;
+    real        time;
+    bool        bOK = (gmx_fseek(fp, index.offset.back(), SEEK_SET) == 0
+                       && skipFrame(&xdr, fp, fileSize, &step, &time) == 1
+                       && gmx_ftell(fp) == fileSize
+                       && step == index.step.back()
+                       && time == index.time.back());
+    xdr_destroy(&xdr);
+    std::fclose(fp);
+    return bOK;
+}
+
+}   // namespace
+
+std::string xtc_index_filename(const char *fn)
+{
+    return std::string(fn) + ".idx";
+}
+
+bool xtc_index_read(const char *fn, t_xtc_index *index)
+{
+    gmx_int64_t fileSize, fileTime;
+    if (!getFileStatus(fn, &fileSize, &fileTime))
+    {
+        return false;
+    }
+    FILE *fp = std::fopen(xtc_index_filename(fn).c_str(), "rb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    IndexHeader header;
+    bool        bOK = (std::fread(&header, sizeof(header), 1, fp) == 1
+                       && std::memcmp(header.magic, c_indexMagic, sizeof(c_indexMagic)) == 0
+                       && header.byteOrder == c_indexByteOrder
+                       && header.realSize == sizeof(real)
+                       && header.fileSize == fileSize
+                       && header.fileTime == fileTime
+                       && header.frameCount >= 0);
+    if (bOK)
+    {
+        const size_t n = header.frameCount;
+        index->offset.resize(n);
+        index->step.resize(n);
+        index->time.resize(n);
+        bOK = (std::fread(index->offset.data(), sizeof(gmx_off_t), n, fp) == n
+               && std::fread(index->step.data(), sizeof(gmx_int64_t), n, fp) == n
+               && std::fread(index->time.data(), sizeof(real), n, fp) == n);
+    }
+    std::fclose(fp);
+    bOK = bOK && lastFrameMatches(fn, *index, fileSize);
+    if (!bOK)
+    {
+        *index = t_xtc_index();
+    }
+    return bOK;
+}
+
+bool xtc_index_build(const char *fn, t_xtc_index *index)
+{
+    gmx_int64_t fileSize, fileTime;
+    *index = t_xtc_index();
+    if (!getFileStatus(fn, &fileSize, &fileTime))
+    {
+        return false;
+    }
+    FILE *fp = std::fopen(fn, "rb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    XDR xdr;
+    xdrstdio_create(&xdr, fp, XDR_DECODE);
+    int result;
+    do
+    {
+        const gmx_off_t offset = gmx_ftell(fp);
+        gmx_int64_t     step;
+        real            time;
+        result = skipFrame(&xdr, fp, fileSize, &step, &time);
+        if (result > 0)
+        {
+            index->offset.push_back(offset);
+            index->step.push_back(step);
+            index->time.push_back(time);
+        }
+    }
+    while (result > 0);
+    xdr_destroy(&xdr);
+    std::fclose(fp);
+    return (result == 0);
+}
+
+bool xtc_index_write(const char *fn, const t_xtc_index &index)
+{
+    IndexHeader header;
+    std::memcpy(header.magic, c_indexMagic, sizeof(c_indexMagic));
+    header.byteOrder  = c_indexByteOrder;
+    header.realSize   = sizeof(real);
+    header.frameCount = index.offset.size();
+    if (!getFileStatus(fn, &header.fileSize, &header.fileTime))
+    {
+        return false;
+    }
+    const std::string indexFilename = xtc_index_filename(fn);
+    FILE             *fp            = std::fopen(indexFilename.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    const size_t n   = index.offset.size();
+    bool         bOK = (std::fwrite(&header, sizeof(header), 1, fp) == 1
+                        && std::fwrite(index.offset.data(), sizeof(gmx_off_t), n, fp) == n
+                        && std::fwrite(index.step.data(), sizeof(gmx_int64_t), n, fp) == n
+                        && std::fwrite(index.time.data(), sizeof(real), n, fp) == n);
+    bOK = (std::fclose(fp) == 0) && bOK;
+    if (!bOK)
+    {
+        // Do not leave an incomplete index behind
+        std::remove(indexFilename.c_str());
+    }
+    return bOK;
+}
+
+t_xtc_index *xtc_index_load(const char *fn)
+{
+    t_xtc_index *index = new t_xtc_index;
+    if (!xtc_index_read(fn, index))
+    {
+        if (xtc_index_build(fn, index))
+        {
+            const std::string indexFilename = xtc_index_filename(fn);
+            if (xtc_index_write(fn, *index))
+            {
+                fprintf(stderr, "\nWrote the frame index of %s to %s\n", fn, indexFilename.c_str());
+            }
+            else
+            {
+                fprintf(stderr, "\nNote: Could not write the frame index %s, the index of %s\n"
+                        "      is built again for every seek.\n", indexFilename.c_str(), fn);
+            }
+        }
+        else
+        {
+            *index = t_xtc_index();
+        }
+    }
+    return index;
+}
+
+int xtc_index_seek_time(const t_xtc_index &index, FILE *fp, real time,
+                        gmx_bool bSeekForwardOnly)
+{
+    size_t first = 0;
+    if (bSeekForwardOnly)
+    {
+        // The current position can be inside the header of a frame
+        const gmx_off_t position = gmx_ftell(fp);
+        first = std::upper_bound(index.offset.begin(), index.offset.end(), position)
+            - index.offset.begin();
+        first = (first > 0 ? first - 1 : 0);
+    }
+    auto frame = std::find_if(index.time.begin() + first, index.time.end(),
+                              [time](real t) { return t >= time; });
+    if (frame == index.time.end())
+    {
+        return -1;
+    }
+    return gmx_fseek(fp, index.offset[frame - index.time.begin()], SEEK_SET);
+}
+
+bool xtc_read_frames(const char *fn, const t_xtc_index &index, int nframes,
+                     const int frames[], t_trxframe *fr[], int nthreads)
+{
+    nthreads = std::max(1, std::min(nthreads, nframes));
+    std::vector<char> bOK(nframes, FALSE);
+    auto              decode = [&](int thread)
+    {
+        const int begin = (nframes*thread)/nthreads;
+        const int end   = (nframes*(thread + 1))/nthreads;
+        t_fileio *fio   = open_xtc(fn, "r");
+        for (int i = begin; i < end; ++i)
+        {
+            t_trxframe *f       = fr[i];
+            gmx_bool    bFrameOK = FALSE;
+            if (gmx_fio_seek(fio, index.offset[frames[i]]) == 0
+                && read_next_xtc(fio, f->natoms, &f->step, &f->time, f->box, f->x,
+                                 &f->prec, &bFrameOK))
+            {
+                bOK[i] = bFrameOK;
+            }
+            f->bPrec  = (bOK[i] && f->prec > 0);
+            f->bStep  = bOK[i];
+            f->bTime  = bOK[i];
+            f->bX     = bOK[i];
+            f->bBox   = bOK[i];
+            f->not_ok = (bOK[i] ? 0 : DATA_NOT_OK);
+        }
+        close_xtc(fio);
+    };
+    std::vector<std::thread> threads;
+    for (int thread = 1; thread < nthreads; ++thread)
+    {
+        threads.emplace_back(decode, thread);
+    }
+    decode(0);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    return std::all_of(bOK.begin(), bOK.end(), [](char b) { return b != FALSE; });
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2026, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares the frame index of xtc files, which is stored next to the
+ * trajectory in a file with the suffix .idx.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_XTCINDEX_H
+#define GMX_FILEIO_XTCINDEX_H
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/real.h"
+
+struct t_trxframe;
+
+/*! \libinternal \brief
+ * File offsets, steps and times of all frames of an xtc file.
+ */
+struct t_xtc_index
+{
+    //! Offset of the header of each frame.
+    std::vector<gmx_off_t>   offset;
+    //! Step of each frame.
+    std::vector<gmx_int64_t> step;
+    //! Time of each frame.
+    std::vector<real>        time;
+};
+
+/*! \brief
+ * Returns the name of the index file of the xtc file \p fn.
+ */
+std::string xtc_index_filename(const char *fn);
+
+/*! \brief
+ * Reads the index file of the xtc file \p fn.
+ *
+ * Returns false if the index file does not exist, cannot be read, or was
+ * not written for the current size and modification time of \p fn.
+ * The last frame in the index must also be a complete frame at the stored
+ * offset that ends at the end of \p fn, which detects a rewritten file
+ * within the one-second resolution of the modification time.
+ */
+bool xtc_index_read(const char *fn, t_xtc_index *index);
+
+/*! \brief
+ * Builds the index of the xtc file \p fn by reading all frame headers.
+ *
+ * The compressed coordinates are skipped, so this is much faster than
+ * reading the trajectory.  Returns false if the file is not a complete xtc
+ * file, in which case \p index contains the frames before the error.
+ */
+bool xtc_index_build(const char *fn, t_xtc_index *index);
+
+/*! \brief
+ * Writes \p index to the index file of the xtc file \p fn.
+ *
+ * The current size and modification time of \p fn are stored for
+ * validation in xtc_index_read().  Returns false if the index file cannot
+ * be created, e.g., in a read-only directory.  Nothing is written then,
+ * because the index is optional.
+ */
+bool xtc_index_write(const char *fn, const t_xtc_index &index);
+
+/*! \brief
+ * Returns the index or builds the index of the xtc file \p fn.
+ *
+ * Reads the index file if it is valid, otherwise builds the index and
+ * writes the index file, if its directory is writable.  Whether the index
+ * file was written is reported on stderr.  Returns an empty index if \p fn
+ * cannot be indexed.
+ */
+t_xtc_index *xtc_index_load(const char *fn);
+
+/*! \brief
+ * Positions \p fp at the first frame with time >= \p time.
+ *
+ * If \p bSeekForwardOnly, only frames at or after the current position
+ * of \p fp are considered.  Returns 0 on success and -1 if there is no
+ * such frame, in which case the position is not changed.
+ */
+int xtc_index_seek_time(const t_xtc_index &index, FILE *fp, real time,
+                        gmx_bool bSeekForwardOnly);
+
+/*! \brief
+ * Decodes frames of the xtc file \p fn concurrently.
+ *
+ * \param[in]     fn       Name of the xtc file.
+ * \param[in]     index    Index of \p fn.
+ * \param[in]     nframes  Number of frames to decode.
+ * \param[in]     frames   Index entries of the frames to decode.
+ * \param[in,out] fr       Frames to decode into.  natoms and x must be set
+ *     for each frame, the other fields are set as by read_next_frame().
+ * \param[in]     nthreads Number of threads for decoding.
+ *
+ * Each thread opens \p fn and decodes a contiguous part of the frames.
+ * Returns false if a frame could not be decoded, which is then marked with
+ * DATA_NOT_OK.
+ */
+bool xtc_read_frames(const char *fn, const t_xtc_index &index, int nframes,
+                     const int frames[], t_trxframe *fr[], int nthreads);
+
+#endif
@@ -38,12 +38,21 @@
 
 #include "cmat.h"
 
+#include "config.h"
+
 #include <algorithm>
 
+#if !GMX_NATIVE_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -57,8 +66,9 @@ t_mat *init_mat(int n1, gmx_bool b1D)
     m->b1D    = b1D;
     m->maxrms = 0;
     m->minrms = 1e20;
-    m->sumrms = 0;
-    m->mat    = mk_matrix(n1, n1, b1D);
+    m->sumrms  = 0;
+    m->mat     = mk_matrix(n1, n1, b1D);
+    m->mapsize = 0;
 
     snew(m->erow, n1);
     snew(m->m_ind, n1);
@@ -67,6 +77,59 @@ t_mat *init_mat(int n1, gmx_bool b1D)
     return m;
 }
 
+t_mat *init_mapped_mat(int n1, gmx_bool b1D)
+{
+#if GMX_NATIVE_WINDOWS
+    fprintf(stderr, "Memory mapping is not supported, storing the matrix in memory\n");
+    return init_mat(n1, b1D);
+#else
+    t_mat *m;
+    char   buf[] = "cmatXXXXXX";
+    size_t size  = static_cast<size_t>(n1)*n1*sizeof(real);
+    int    fd;
+    void  *data;
+
+    /* The file is removed right away, the mapping keeps it alive */
+    gmx_tmpnam(buf);
+    fd = open(buf, O_RDWR);
+    if (fd < 0 || unlink(buf) != 0)
+    {
+        gmx_fatal(FARGS, "Could not open temporary matrix file %s", buf);
+    }
+    /* A file extended with ftruncate is filled with zeros */
+    if (ftruncate(fd, size) != 0)
+    {
+        gmx_fatal(FARGS, "Could not allocate %zu bytes for the matrix in temporary file %s", size, buf);
+    }
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        gmx_fatal(FARGS, "Could not map the temporary matrix file %s into memory", buf);
+    }
+
+    snew(m, 1);
+    m->n1      = n1;
+    m->nn      = 0;
+    m->b1D     = b1D;
+    m->maxrms  = 0;
+    m->minrms  = 1e20;
+    m->sumrms  = 0;
+    m->mapsize = size;
+    snew(m->mat, n1);
+    for (int i = 0; i < n1; i++)
+    {
+        m->mat[i] = static_cast<real *>(data) + static_cast<size_t>(i)*n1;
+    }
+
+    snew(m->erow, n1);
+    snew(m->m_ind, n1);
+    reset_index(m);
+
+    return m;
+#endif
+}
+
 void copy_t_mat(t_mat *dst, t_mat *src)
 {
     int i, j;
@@ -140,7 +203,17 @@ void set_mat_entry(t_mat *m, int i, int j, real val)
 
 void done_mat(t_mat **m)
 {
-    done_matrix((*m)->n1, &((*m)->mat));
+#if !GMX_NATIVE_WINDOWS
+    if ((*m)->mapsize > 0)
+    {
+        munmap((*m)->mat[0], (*m)->mapsize);
+        sfree((*m)->mat);
+    }
+    else
+#endif
+    {
+        done_matrix((*m)->n1, &((*m)->mat));
+    }
     sfree((*m)->m_ind);
     sfree((*m)->erow);
     sfree(*m);
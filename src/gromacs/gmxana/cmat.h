@@ -38,6 +38,8 @@
 #ifndef _cmat_h
 #define _cmat_h
 
+#include <stddef.h>
+
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
@@ -64,6 +66,8 @@ typedef struct {
     real     minrms, maxrms, sumrms;
     real    *erow;
     real   **mat;
+    /* Size in bytes of the mapped storage of mat, 0 when mat is in memory */
+    size_t   mapsize;
 } t_mat;
 
 /* The matrix is indexed using the matrix index */
@@ -71,6 +75,15 @@ typedef struct {
 
 extern t_mat *init_mat(int n1, gmx_bool b1D);
 
+/* As init_mat, but the matrix is stored in a temporary file in the
+ * working directory which is mapped into memory, such that the operating
+ * system can page out parts of a matrix which does not fit in memory.
+ * The mapped rows are always contiguous, b1D is stored for copies made
+ * with init_mat. Falls back to init_mat when memory mapping is not
+ * supported.
+ */
+extern t_mat *init_mapped_mat(int n1, gmx_bool b1D);
+
 extern void copy_t_mat(t_mat *dst, t_mat *src);
 
 extern void enlarge_mat(t_mat *m, int deltan);
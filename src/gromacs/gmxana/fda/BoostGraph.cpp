@@ -12,22 +12,53 @@
 #include <fstream>
 #include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <boost/graph/filtered_graph.hpp>
 #include "BoostGraph.h"
 #include "Index.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 
 namespace fda_analysis {
 
+namespace {
+
+//! Mask out the edges removed for the spur path, the graph is undirected
+template <class G>
+struct RemovedEdgeFilter
+{
+    RemovedEdgeFilter() : graph(nullptr), removedEdges(nullptr) {}
+
+    RemovedEdgeFilter(G const* graph, std::vector<std::pair<BoostGraph::Vertex, BoostGraph::Vertex>> const* removedEdges)
+     : graph(graph), removedEdges(removedEdges)
+    {}
+
+    bool operator () (BoostGraph::Edge const& edge) const
+    {
+        BoostGraph::Vertex u = source(edge, *graph);
+        BoostGraph::Vertex v = target(edge, *graph);
+        for (auto const& removed : *removedEdges) {
+            if ((removed.first == u and removed.second == v) or (removed.first == v and removed.second == u)) return false;
+        }
+        return true;
+    }
+
+    G const* graph;
+    std::vector<std::pair<BoostGraph::Vertex, BoostGraph::Vertex>> const* removedEdges;
+};
+
+} // namespace
+
 BoostGraph::BoostGraph(std::vector<double> const& forceMatrix)
+ : BoostGraph(ForceMatrix(forceMatrix))
+{}
+
+BoostGraph::BoostGraph(ForceMatrix const& forceMatrix)
 {
-	int dim = sqrt(forceMatrix.size());
-	double force;
-
-    for (int i = 0; i < dim; ++i) {
-        for (int j = i; j < dim; ++j) {
-        	force = forceMatrix[i*dim+j];
-        	if (force != 0.0) {
-        		add_edge(i, j, force, graph_);
+    for (int i = 0; i < forceMatrix.dim(); ++i) {
+        for (auto const& entry : forceMatrix.row(i)) {
+        	if (entry.j >= i and entry.force != 0.0) {
+        		add_edge(i, entry.j, entry.force, graph_);
         	}
         }
     }
@@ -40,13 +71,48 @@ BoostGraph::BoostGraph(std::vector<double> const& forceMatrix)
 
 BoostGraph::Path BoostGraph::findShortestPath(size_t from, size_t to) const
 {
-	return dijkstra(from, to, graph_);
+	Workspace workspace;
+	return dijkstra(from, to, graph_, workspace);
 }
 
 BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size_t num) const
 {
+	Workspace workspace;
+	return findKShortestPaths(from, to, num, workspace);
+}
+
+std::vector<BoostGraph::PathList> BoostGraph::findKShortestPaths(std::vector<BoostGraph> const& graphs,
+    std::vector<SourceDest> const& pairs, size_t num)
+{
+	int nbSearches = graphs.size() * pairs.size();
+	std::vector<PathList> result(nbSearches);
+
+    #pragma omp parallel
+	{
+		Workspace workspace;
+
+        #pragma omp for schedule(dynamic)
+		for (int n = 0; n < nbSearches; ++n)
+		{
+			try {
+				SourceDest const& pair = pairs[n % pairs.size()];
+				result[n] = graphs[n / pairs.size()].findKShortestPaths(pair.first, pair.second, num, workspace);
+			}
+			GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+		}
+	}
+
+	return result;
+}
+
+BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size_t num, Workspace& workspace) const
+{
+	typedef boost::filtered_graph<Graph, RemovedEdgeFilter<Graph>> FilteredGraph;
+	FilteredGraph tmpGraph(graph_, RemovedEdgeFilter<Graph>(&graph_, &workspace.removedEdges));
+
 	PathList shortestPaths;
-	shortestPaths.push_back(findShortestPath(from, to));
+	workspace.removedEdges.clear();
+	shortestPaths.push_back(dijkstra(from, to, tmpGraph, workspace));
 
 	PathList variants;
 
@@ -63,13 +129,13 @@ BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size
 	  	    // The sequence of nodes from the source to the spur node of the previous k-shortest path.
 	  	    Path rootPath(previousPath.begin(), previousPath.begin() + i);
 
-	  	    Graph tmpGraph(graph_);
+	  	    workspace.removedEdges.clear();
 
 	  	    for (auto & p : shortestPaths) {
-	  	 	    if (rootPath == Path(p.begin(), p.begin() + i)) {
+	  	 	    if (p.size() > i + 1 and std::equal(rootPath.begin(), rootPath.end(), p.begin())) {
 	  	 	        // Remove the links that are part of the previous shortest paths which share the same root path.
 	  	            //std::cout << "remove edge " << p[i] << "  " << p[i+1] << std::endl;
-	  	 		    remove_edge(vertex(p[i], tmpGraph), vertex(p[i+1], tmpGraph), tmpGraph);
+	  	 		    workspace.removedEdges.push_back(std::make_pair(p[i], p[i+1]));
 	  	 	    }
 	  	    }
 
@@ -81,7 +147,7 @@ BoostGraph::PathList BoostGraph::findKShortestPaths(size_t from, size_t to, size
 	  	    // Calculate the spur path from the spur node to the sink.
 	  	    Path spurPath;
 	  	    try {
-	  	    	spurPath = dijkstra(spurNode, to, tmpGraph);
+	  	    	spurPath = dijkstra(spurNode, to, tmpGraph, workspace);
 	  	    } catch ( ... ) {
 	  	    	continue;
 	  	    }
@@ -139,20 +205,26 @@ double BoostGraph::distance(BoostGraph::Path const& path) const
     return dist;
 }
 
-BoostGraph::Path BoostGraph::dijkstra(Vertex source, Vertex dest, Graph const& graph) const
+template <class G>
+BoostGraph::Path BoostGraph::dijkstra(Vertex source, Vertex dest, G const& graph, Workspace& workspace) const
 {
     //std::cout << "dijkstra: source = " << source << ", dest = " << dest << std::endl;
 	//if (vertex(source, graph)) gmx_fatal(FARGS, "Vertex source is not an element of graph.");
 	//if (vertex(dest, graph)) gmx_fatal(FARGS, "Vertex dest is not an element of graph.");
 
-	std::vector<Vertex> predecessor(num_vertices(graph));
-	std::vector<double> distance(num_vertices(graph));
-	Vertex s = vertex(source, graph);
+	if (source >= num_vertices(graph) or dest >= num_vertices(graph))
+		throw std::runtime_error("No connection between source and dest.");
+
+	std::vector<Vertex>& predecessor = workspace.predecessor;
+	std::vector<double>& distance = workspace.distance;
+	predecessor.resize(num_vertices(graph));
+	distance.resize(num_vertices(graph));
+	Vertex s = source;
 
 	dijkstra_shortest_paths(graph, s, boost::predecessor_map(&predecessor[0]).distance_map(&distance[0]));
 
     #ifdef PRINT_DEBUG
-		boost::graph_traits<Graph>::vertex_iterator vi, vend;
+		typename boost::graph_traits<G>::vertex_iterator vi, vend;
 		for (boost::tie(vi, vend) = boost::vertices(graph); vi != vend; ++vi) {
 			std::cout << "distance(" << *vi << ") = " << distance[*vi] << ", ";
 			std::cout << "parent(" << *vi << ") = " << predecessor[*vi] << std::endl;
@@ -160,7 +232,7 @@ BoostGraph::Path BoostGraph::dijkstra(Vertex source, Vertex dest, Graph const& g
 	#endif
 
 	Path shortestPath;
-	Vertex cur = vertex(dest, graph);
+	Vertex cur = dest;
     while (cur != s) {
     	shortestPath.push_back(cur);
     	if (cur == predecessor[cur]) throw std::runtime_error("No connection between source and dest.");
@@ -171,13 +243,14 @@ BoostGraph::Path BoostGraph::dijkstra(Vertex source, Vertex dest, Graph const& g
 	return shortestPath;
 }
 
-void BoostGraph::print(Graph const& graph) const
+template <class G>
+void BoostGraph::print(G const& graph) const
 {
-	boost::graph_traits<Graph>::vertex_iterator vi, vend;
+	typename boost::graph_traits<G>::vertex_iterator vi, vend;
 	for (boost::tie(vi, vend) = boost::vertices(graph); vi != vend; ++vi) {
 		std::cout << *vi << std::endl;
 	}
-	boost::graph_traits <Graph>::edge_iterator ei, ei_end;
+	typename boost::graph_traits<G>::edge_iterator ei, ei_end;
 	for (boost::tie(ei, ei_end) = edges(graph); ei != ei_end; ++ei) {
 		std::cout << source(*ei, graph) << " -> " << target(*ei, graph) << std::endl;
 	}
@@ -11,7 +11,9 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <iostream>
+#include <utility>
 #include <vector>
+#include "ForceMatrix.h"
 
 namespace fda_analysis {
 
@@ -30,27 +32,56 @@ public:
     typedef std::vector<int> Path;
     typedef std::vector<Path> PathList;
 
+    //! Source and destination node of a path search
+    typedef std::pair<size_t, size_t> SourceDest;
+
+    /**
+     * Buffers of the path search, which can be reused for all searches of a thread.
+     * Instead of copying the graph for each spur path, the removed edges are masked out.
+     */
+    struct Workspace
+    {
+        std::vector<Vertex> predecessor;
+        std::vector<double> distance;
+        std::vector<std::pair<Vertex, Vertex>> removedEdges;
+    };
+
 	BoostGraph() {};
 
-	//! Build graph by adjacency matrix
+	//! Build graph by dense adjacency matrix
 	BoostGraph(std::vector<double> const& forceMatrix);
 
+	//! Build graph by sparse adjacency matrix
+	BoostGraph(ForceMatrix const& forceMatrix);
+
 	//! Use Dijkstra algorithm to find the shortest path.
 	Path findShortestPath(size_t source, size_t dest) const;
 
 	//! Yen's algorithm to find the k shortest paths.
 	PathList findKShortestPaths(size_t source, size_t dest, size_t num) const;
 
+	//! Yen's algorithm to find the k shortest paths using the buffers of workspace.
+	PathList findKShortestPaths(size_t source, size_t dest, size_t num, Workspace& workspace) const;
+
+	/**
+	 * Find the k shortest paths of all source/destination pairs in all graphs concurrently
+	 * using OpenMP threads. The path list of graph g and pair p is stored at g * pairs.size() + p.
+	 */
+	static std::vector<PathList> findKShortestPaths(std::vector<BoostGraph> const& graphs,
+	    std::vector<SourceDest> const& pairs, size_t num);
+
 	//! Determine the sum of weights (distance) of a graph.
     double distance(Path const& path) const;
 
 private:
 
 	//! Calculate the spur path from source to dest.
-	Path dijkstra(Vertex source, Vertex dest, Graph const& graph) const;
+	template <class G>
+	Path dijkstra(Vertex source, Vertex dest, G const& graph, Workspace& workspace) const;
 
 	//! Print graph for debugging
-	void print(Graph const& graph) const;
+	template <class G>
+	void print(G const& graph) const;
 
 	//! Print path for debugging
 	void print(Path const& path) const;
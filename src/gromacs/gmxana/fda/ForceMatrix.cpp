@@ -0,0 +1,130 @@
+/*
+ * ForceMatrix.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ForceMatrix.h"
+#include "gromacs/utility/fatalerror.h"
+
+namespace fda_analysis {
+
+namespace {
+
+bool lessColumn(ForceMatrix::Entry const& entry, int j)
+{
+    return entry.j < j;
+}
+
+} // namespace
+
+ForceMatrix::ForceMatrix(std::vector<double> const& denseMatrix)
+ : rows_(std::sqrt(denseMatrix.size()))
+{
+    int n = dim();
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            double force = denseMatrix[i*n+j];
+            if (force != 0.0) rows_[i].push_back(Entry(j, force));
+        }
+    }
+}
+
+double ForceMatrix::operator () (int i, int j) const
+{
+    Row const& row = rows_[i];
+    auto iter = std::lower_bound(row.begin(), row.end(), j, lessColumn);
+    return (iter != row.end() and iter->j == j) ? iter->force : 0.0;
+}
+
+void ForceMatrix::set(int i, int j, double force)
+{
+    if (i < 0 or i >= dim() or j < 0 or j >= dim())
+        gmx_fatal(FARGS, "Index is larger than dimension.");
+    Row& row = rows_[i];
+    // Pairs are mostly added in ascending order
+    if (row.empty() or row.back().j < j) {
+        row.push_back(Entry(j, force));
+        return;
+    }
+    auto iter = std::lower_bound(row.begin(), row.end(), j, lessColumn);
+    if (iter != row.end() and iter->j == j) iter->force = force;
+    else row.insert(iter, Entry(j, force));
+}
+
+size_t ForceMatrix::size() const
+{
+    size_t size = 0;
+    for (auto const& row : rows_) size += row.size();
+    return size;
+}
+
+void ForceMatrix::clear()
+{
+    for (auto& row : rows_) row.clear();
+}
+
+void ForceMatrix::add(ForceMatrix const& other, double factor)
+{
+    if (other.dim() != dim()) gmx_fatal(FARGS, "Dimensions of force matrices does not match.");
+    for (int i = 0; i < dim(); ++i) {
+        Row const& otherRow = other.rows_[i];
+        if (otherRow.empty()) continue;
+        Row& row = rows_[i];
+        // Merge the sorted rows
+        Row merged;
+        merged.reserve(row.size() + otherRow.size());
+        auto iter = row.begin();
+        auto otherIter = otherRow.begin();
+        while (iter != row.end() or otherIter != otherRow.end()) {
+            if (otherIter == otherRow.end() or (iter != row.end() and iter->j < otherIter->j)) {
+                merged.push_back(*iter++);
+            } else if (iter == row.end() or otherIter->j < iter->j) {
+                merged.push_back(Entry(otherIter->j, factor * otherIter->force));
+                ++otherIter;
+            } else {
+                merged.push_back(Entry(iter->j, iter->force + factor * otherIter->force));
+                ++iter;
+                ++otherIter;
+            }
+        }
+        row.swap(merged);
+    }
+}
+
+ForceMatrix& ForceMatrix::operator += (ForceMatrix const& other)
+{
+    add(other, 1.0);
+    return *this;
+}
+
+ForceMatrix& ForceMatrix::operator -= (ForceMatrix const& other)
+{
+    add(other, -1.0);
+    return *this;
+}
+
+ForceMatrix& ForceMatrix::operator *= (double factor)
+{
+    for (auto& row : rows_)
+        for (auto& entry : row) entry.force *= factor;
+    return *this;
+}
+
+ForceMatrix& ForceMatrix::operator /= (double divisor)
+{
+    for (auto& row : rows_)
+        for (auto& entry : row) entry.force /= divisor;
+    return *this;
+}
+
+void ForceMatrix::abs()
+{
+    for (auto& row : rows_)
+        for (auto& entry : row) entry.force = std::abs(entry.force);
+}
+
+} // namespace fda_analysis
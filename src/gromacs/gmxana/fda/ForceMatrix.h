@@ -0,0 +1,86 @@
+/*
+ * ForceMatrix.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef FORCEMATRIX_H_
+#define FORCEMATRIX_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace fda_analysis {
+
+/**
+ * Sparse force matrix of dimension nbParticles x nbParticles.
+ *
+ * Only the interacting pairs are stored, the entries of each row are sorted by the column index,
+ * such that the memory scales with the number of pairs instead of nbParticles².
+ */
+class ForceMatrix
+{
+public:
+
+    struct Entry
+    {
+        Entry(int j = 0, double force = 0.0) : j(j), force(force) {}
+
+        int j;
+        double force;
+    };
+
+    typedef std::vector<Entry> Row;
+
+    explicit ForceMatrix(int dim = 0) : rows_(dim) {}
+
+    /// Build by dense row-major matrix, zeros are not stored
+    explicit ForceMatrix(std::vector<double> const& denseMatrix);
+
+    int dim() const { return rows_.size(); }
+
+    /// Returns zero if the pair is not stored
+    double operator () (int i, int j) const;
+
+    /// Set the force of the pair (i,j)
+    void set(int i, int j, double force);
+
+    /// Set the force of the pairs (i,j) and (j,i)
+    void setSymmetric(int i, int j, double force)
+    {
+        set(i, j, force);
+        set(j, i, force);
+    }
+
+    Row const& row(int i) const { return rows_[i]; }
+
+    /// Number of stored pairs
+    size_t size() const;
+
+    /// Remove all pairs, the dimension is kept
+    void clear();
+
+    ForceMatrix& operator += (ForceMatrix const& other);
+
+    ForceMatrix& operator -= (ForceMatrix const& other);
+
+    ForceMatrix& operator *= (double factor);
+
+    ForceMatrix& operator /= (double divisor);
+
+    /// Replace all forces by their absolute value
+    void abs();
+
+private:
+
+    /// Add factor * other to all pairs
+    void add(ForceMatrix const& other, double factor);
+
+    std::vector<Row> rows_;
+
+};
+
+} // namespace fda_analysis
+
+#endif /* FORCEMATRIX_H_ */
@@ -20,50 +20,35 @@
 namespace fda_analysis {
 
 Graph::Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, int isize)
-{
-	double force;
-	bool addNode1, addNode2;
-	int dim = sqrt(forceMatrix.size());
-	std::vector<int>::iterator iterFind;
+ : Graph(ForceMatrix(forceMatrix), coord, index, isize)
+{}
 
-    for (int i = 0; i < dim; ++i) {
-        for (int j = 0; j < dim; ++j) {
-        	force = forceMatrix[i*dim+j];
-            if (force == 0.0) continue;
-			Node node1(i), node2(j);
-
-			iterFind = std::find(indices_.begin(), indices_.end(), i);
-			if (iterFind != indices_.end()) {
-				nodes_[std::distance(indices_.begin(), iterFind)].addConnectedNode(j, force);
-				addNode1 = false;
-			} else {
-				addNode1 = true;
-			}
+Graph::Graph(ForceMatrix const& forceMatrix, rvec *coord, int *index, int isize)
+{
+	int dim = forceMatrix.dim();
 
-			iterFind = std::find(indices_.begin(), indices_.end(), j);
-			if (iterFind != indices_.end()) {
-				nodes_[std::distance(indices_.begin(), iterFind)].addConnectedNode(i, force);
-				addNode2 = false;
-			} else {
-				addNode2 = true;
-			}
+	// Position of the particle in nodes_, -1 if not added yet
+	std::vector<int> position(dim, -1);
 
-			if (addNode1) {
-				node1.addConnectedNode(j, force);
-                nodes_.push_back(node1);
-                indices_.push_back(i);
-			}
+	auto addConnection = [&](int i, int j, double force) {
+		if (position[i] == -1) {
+			position[i] = nodes_.size();
+			nodes_.push_back(Node(i));
+			indices_.push_back(i);
+		}
+		nodes_[position[i]].addConnectedNode(j, force);
+	};
 
-			if (addNode2) {
-				node2.addConnectedNode(i, force);
-                nodes_.push_back(node2);
-                indices_.push_back(j);
-			}
+    for (int i = 0; i < dim; ++i) {
+        for (auto const& entry : forceMatrix.row(i)) {
+            if (entry.force == 0.0) continue;
+            addConnection(i, entry.j, entry.force);
+            addConnection(entry.j, i, entry.force);
         }
     }
     for (int i = 0; i < dim; ++i)
     {
-    	if (std::find(indices_.begin(), indices_.end(), i) == indices_.end()){
+    	if (position[i] == -1) {
 			nodes_.push_back(Node(i));
 			indices_.push_back(i);
 		}
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "gromacs/math/vectypes.h"
+#include "ForceMatrix.h"
 #include "Node.h"
 
 namespace fda_analysis {
@@ -27,9 +28,12 @@ public:
 
 	Graph() {};
 
-	//! Build graph by adjacency matrix
+	//! Build graph by dense adjacency matrix
 	Graph(std::vector<double> const& forceMatrix, rvec *coord, int *index, int isize);
 
+	//! Build graph by sparse adjacency matrix
+	Graph(ForceMatrix const& forceMatrix, rvec *coord, int *index, int isize);
+
 	void convertInPDBMinGraphOrder(std::string const& outFilename, double threshold,
 		size_t minGraphOrder, bool onlyBiggestNetwork, bool append) const;
 
@@ -6,6 +6,9 @@
  */
 
 #include "Helpers.h"
+#include "ScalarFrameReader.h"
+#include "gromacs/fda/BinaryPairwiseForces.h"
+#include "gromacs/fda/CompressedStream.h"
 #include "gromacs/utility/fatalerror.h"
 #include <cctype>
 #include <iostream>
@@ -14,55 +17,42 @@
 
 namespace fda_analysis {
 
-std::vector<double> parseScalarFileFormat(std::string const& filename,
+ForceMatrix parseScalarFileFormat(std::string const& filename,
 	int nbParticles, int frame)
 {
-    int nbParticles2 = nbParticles * nbParticles;
-
-    std::vector<double> array(nbParticles2, 0.0);
-    std::ifstream pfFile(filename);
-    if (!pfFile) gmx_fatal(FARGS, "Error opening file.");
-
-    std::string line;
-    bool foundFrame = false;
-    int frameNumber;
-    std::string tmp;
-    int i, j;
-    double value;
-
-    while (getline(pfFile, line))
-	{
-		if (line.find("frame") != std::string::npos)
-		{
-			if (foundFrame) break;
-			std::istringstream iss(line);
-			iss >> tmp >> frameNumber;
-			if (frameNumber != frame) continue;
-	        foundFrame = true;
-	        continue;
-		}
-		if (foundFrame) {
-			std::istringstream iss(line);
-            iss >> i >> j >> value;
-            if (i >= nbParticles or j >= nbParticles)
-            	gmx_fatal(FARGS, "Index is larger than dimension.");
-            array[i*nbParticles+j] = value;
-            array[j*nbParticles+i] = value;
-		}
-	}
-
-    if (!foundFrame) gmx_fatal(FARGS, "Frame not found.");
-    return array;
+    ForceMatrix array;
+    ScalarFrameReader reader(filename, nbParticles);
+    while (reader.hasNext()) {
+        if (reader.nextFrameNumber() == frame) {
+            reader.next(array);
+            return array;
+        }
+        reader.skip();
+    }
+    gmx_fatal(FARGS, "Frame not found.");
 }
 
-std::vector<double> getAveragedForcematrix(std::string const& filename,
+ForceMatrix getAveragedForcematrix(std::string const& filename,
     int nbParticles)
 {
-    std::ifstream pfFile(filename);
+    fda::InputFileStream pfFile(filename);
     if (!pfFile) gmx_fatal(FARGS, "Error opening file.");
 
-    int nbParticles2 = nbParticles * nbParticles;
-    std::vector<double> forcematrix(nbParticles2, 0.0);
+    ForceMatrix forcematrix(nbParticles);
+
+    if (fda::BinaryPairwiseForcesReader::is_binary(filename)) {
+        fda::BinaryPairwiseForcesReader reader(filename);
+        if (!reader.number_of_frames()) gmx_fatal(FARGS, "No frame found.");
+        for (size_t frame = 0; frame != reader.number_of_frames(); ++frame) {
+            for (auto pf = reader.begin(frame); pf != reader.end(frame); ++pf) {
+                if (pf->i < 0 or pf->i >= nbParticles or pf->j < 0 or pf->j >= nbParticles)
+                    gmx_fatal(FARGS, "Index error in getAveragedForcematrix.");
+                forcematrix.set(pf->i, pf->j, pf->force);
+            }
+        }
+        forcematrix /= reader.number_of_frames();
+        return forcematrix;
+    }
 
     std::string line;
     int numberOfFrames = 0;
@@ -80,11 +70,11 @@ std::vector<double> getAveragedForcematrix(std::string const& filename,
 		iss >> i >> j >> value;
 		if (i < 0 or i >= nbParticles or j < 0 or j >= nbParticles)
 			gmx_fatal(FARGS, "Index error in getAveragedForcematrix.");
-		forcematrix[i*nbParticles+j] = value;
+		forcematrix.set(i, j, value);
 	}
 
     if (!numberOfFrames) gmx_fatal(FARGS, "No frame found.");
-    for (auto & elem : forcematrix) elem /= numberOfFrames;
+    forcematrix /= numberOfFrames;
 
     return forcematrix;
 }
@@ -92,7 +82,7 @@ std::vector<double> getAveragedForcematrix(std::string const& filename,
 std::vector<real> readStress(std::string const& filename, int& nbFrames,
     int& nbParticles)
 {
-    std::ifstream file(filename);
+    fda::InputFileStream file(filename);
     if (!file) gmx_fatal(FARGS, "Error opening file %s.", filename.c_str());
 
     std::string line;
@@ -126,7 +116,10 @@ std::vector<real> readStress(std::string const& filename, int& nbFrames,
 
 size_t getNumberOfFrames(std::string const& filename)
 {
-    std::ifstream pfFile(filename);
+    if (fda::BinaryPairwiseForcesReader::is_binary(filename))
+        return fda::BinaryPairwiseForcesReader(filename).number_of_frames();
+
+    fda::InputFileStream pfFile(filename);
     if (!pfFile) gmx_fatal(FARGS, "Error opening file.");
 
     std::string line;
@@ -144,7 +137,17 @@ size_t getNumberOfFrames(std::string const& filename)
 
 size_t getMaxIndexSecondColumnFirstFrame(std::string const& filename)
 {
-    std::ifstream pfFile(filename);
+    if (fda::BinaryPairwiseForcesReader::is_binary(filename)) {
+        fda::BinaryPairwiseForcesReader reader(filename);
+        int maxIndex = 0;
+        if (reader.number_of_frames()) {
+            for (auto pf = reader.begin(0); pf != reader.end(0); ++pf)
+                if (pf->j > maxIndex) maxIndex = pf->j;
+        }
+        return maxIndex;
+    }
+
+    fda::InputFileStream pfFile(filename);
     if (!pfFile) gmx_fatal(FARGS, "Error opening file.");
 
     std::string line;
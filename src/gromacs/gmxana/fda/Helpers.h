@@ -11,6 +11,7 @@
 #include <iterator>
 #include <string>
 #include <vector>
+#include "ForceMatrix.h"
 #include "FrameType.h"
 #include "gromacs/utility/real.h"
 
@@ -20,14 +21,14 @@ namespace fda_analysis {
  * Parse a file in the scalar format which contains a given number of
  * atom/residues. Can read a single frame given by the argument frame.
  */
-std::vector<double> parseScalarFileFormat(std::string const& filename,
+ForceMatrix parseScalarFileFormat(std::string const& filename,
 	int nbParticles, int frame);
 
 /**
  * Parse a file in the scalar format which contains a given number of
  * atom/residues. Returns average over all frames.
  */
-std::vector<double> getAveragedForcematrix(std::string const& filename,
+ForceMatrix getAveragedForcematrix(std::string const& filename,
 	int nbParticles);
 
 /**
@@ -12,6 +12,7 @@
 #include <vector>
 #include <boost/array.hpp> // back-compatibility to gcc-4.7.2
 #include "gromacs/math/vectypes.h"
+#include "ForceMatrix.h"
 
 namespace fda_analysis {
 
@@ -32,7 +33,7 @@ public:
 	PDB(std::string const& pdbFilename, std::vector<int> groupAtoms);
 
     void writePaths(std::string const& filename, std::vector< std::vector<int> > const& shortestPaths,
-        std::vector<double> const& forceMatrix, bool append) const;
+        ForceMatrix const& forceMatrix, bool append) const;
 
     /// Update with coordinates of trajectory file.
     /// Values will be converted from nm into Angstrom.
@@ -0,0 +1,124 @@
+/*
+ * ScalarFrameReader.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include "ScalarFrameReader.h"
+#include "gromacs/utility/fatalerror.h"
+#include <sstream>
+
+namespace fda_analysis {
+
+namespace {
+
+/// Returns true if line is a frame header and sets frameNumber
+bool isFrameHeader(std::string const& line, int& frameNumber)
+{
+    if (line.find("frame") == std::string::npos) return false;
+    std::istringstream iss(line);
+    std::string tmp;
+    iss >> tmp >> frameNumber;
+    return true;
+}
+
+} // namespace
+
+ScalarFrameReader::ScalarFrameReader(std::string const& filename, int nbParticles)
+ : nbParticles(nbParticles),
+   pendingFrameNumber(-1),
+   binaryPosition(0)
+{
+    if (fda::BinaryPairwiseForcesReader::is_binary(filename)) {
+        binaryReader.reset(new fda::BinaryPairwiseForcesReader(filename));
+        return;
+    }
+
+    file.open(filename);
+    if (!file) gmx_fatal(FARGS, "Error opening file %s.", filename.c_str());
+
+    // Proceed to the first frame
+    std::string line;
+    int frameNumber;
+    while (getline(file, line)) {
+        if (isFrameHeader(line, frameNumber)) {
+            pendingFrameNumber = frameNumber;
+            break;
+        }
+    }
+}
+
+bool ScalarFrameReader::hasNext() const
+{
+    if (binaryReader) return binaryPosition < binaryReader->number_of_frames();
+    return pendingFrameNumber != -1;
+}
+
+int ScalarFrameReader::nextFrameNumber() const
+{
+    if (!hasNext()) gmx_fatal(FARGS, "No frame left.");
+    if (binaryReader) return binaryReader->frame_number(binaryPosition);
+    return pendingFrameNumber;
+}
+
+bool ScalarFrameReader::next(ForceMatrix& forceMatrix)
+{
+    return read(&forceMatrix);
+}
+
+bool ScalarFrameReader::skip()
+{
+    return read(nullptr);
+}
+
+bool ScalarFrameReader::read(ForceMatrix *forceMatrix)
+{
+    if (!hasNext()) return false;
+    if (forceMatrix) *forceMatrix = ForceMatrix(nbParticles);
+
+    if (binaryReader) {
+        if (forceMatrix) {
+            for (auto pf = binaryReader->begin(binaryPosition); pf != binaryReader->end(binaryPosition); ++pf)
+                forceMatrix->setSymmetric(pf->i, pf->j, pf->force);
+        }
+        ++binaryPosition;
+        return true;
+    }
+
+    std::string line;
+    int i, j, frameNumber;
+    double value;
+
+    pendingFrameNumber = -1;
+    while (getline(file, line)) {
+        if (isFrameHeader(line, frameNumber)) {
+            pendingFrameNumber = frameNumber;
+            break;
+        }
+        if (!forceMatrix) continue;
+        std::istringstream iss(line);
+        if (!(iss >> i >> j >> value)) continue;
+        forceMatrix->setSymmetric(i, j, value);
+    }
+    return true;
+}
+
+int readAveragedFrames(ScalarFrameReader& reader, ScalarFrameReader *readerDiff, int nbFrames, ForceMatrix& forceMatrix)
+{
+    ForceMatrix frameMatrix, frameMatrixDiff;
+    int nbAveragedFrames = 0;
+    for (; nbAveragedFrames < nbFrames and reader.next(frameMatrix); ++nbAveragedFrames) {
+        if (readerDiff) {
+            if (!readerDiff->next(frameMatrixDiff)) gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+            frameMatrix -= frameMatrixDiff;
+        }
+        frameMatrix.abs();
+        if (nbAveragedFrames == 0) forceMatrix = std::move(frameMatrix);
+        else forceMatrix += frameMatrix;
+    }
+    if (nbAveragedFrames > 1) forceMatrix /= nbAveragedFrames;
+    return nbAveragedFrames;
+}
+
+} // namespace fda_analysis
@@ -0,0 +1,72 @@
+/*
+ * ScalarFrameReader.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#ifndef SCALARFRAMEREADER_H_
+#define SCALARFRAMEREADER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "ForceMatrix.h"
+#include "gromacs/fda/BinaryPairwiseForces.h"
+#include "gromacs/fda/CompressedStream.h"
+
+namespace fda_analysis {
+
+/**
+ * Forward reader for files in the scalar format (ascii or binary pfa/pfr).
+ * The frames are read one after another in a single pass through the file.
+ */
+class ScalarFrameReader
+{
+public:
+
+    ScalarFrameReader(std::string const& filename, int nbParticles);
+
+    /// Return true if there is a frame left
+    bool hasNext() const;
+
+    /// Number of the next frame as written in the file
+    int nextFrameNumber() const;
+
+    /// Read the next frame as symmetric force matrix. Returns false if there is no frame left.
+    bool next(ForceMatrix& forceMatrix);
+
+    /// Skip the next frame. Returns false if there is no frame left.
+    bool skip();
+
+private:
+
+    /// Read next frame, the force matrix is only filled if it is not a nullptr
+    bool read(ForceMatrix *forceMatrix);
+
+    int nbParticles;
+
+    /// Ascii input
+    fda::InputFileStream file;
+
+    /// Frame number of the next frame in the ascii file, -1 if there is no frame left
+    int pendingFrameNumber;
+
+    /// Binary input
+    std::unique_ptr<fda::BinaryPairwiseForcesReader> binaryReader;
+
+    /// Position of the next frame in the binary file
+    size_t binaryPosition;
+
+};
+
+/**
+ * Read the next nbFrames frames and return the average of their absolute forces.
+ * If readerDiff is not a nullptr, its frames are subtracted from those of reader before.
+ * Returns the number of averaged frames, which is less than nbFrames at the end of the file.
+ */
+int readAveragedFrames(ScalarFrameReader& reader, ScalarFrameReader *readerDiff, int nbFrames, ForceMatrix& forceMatrix);
+
+} // namespace fda_analysis
+
+#endif /* SCALARFRAMEREADER_H_ */
@@ -118,3 +118,39 @@ TEST(BoostGraphTest, Yen2)
     	EXPECT_TRUE((EqualArrays(refPath[i], pathIndices)));
     }
 }
+
+//! Test for concurrent k-shortest paths of several graphs and source/destination pairs
+TEST(BoostGraphTest, KShortestPathsMultiple)
+{
+	const int N = 6;
+	std::vector<double> f(N*N);
+	f[      1] = 3.0;
+	f[      2] = 2.0;
+	f[1*N + 2] = 1.0;
+	f[1*N + 3] = 4.0;
+	f[2*N + 3] = 2.0;
+	f[2*N + 4] = 3.0;
+	f[3*N + 4] = 2.0;
+	f[3*N + 5] = 1.0;
+	f[4*N + 5] = 2.0;
+
+	// The second graph has a weak edge between 3 and 5
+	std::vector<double> f2(f);
+	f2[3*N + 5] = 10.0;
+
+	std::vector<BoostGraph> graphs{BoostGraph(f), BoostGraph(f2), BoostGraph(f)};
+	std::vector<BoostGraph::SourceDest> pairs{{0, 5}, {5, 1}};
+	std::vector<BoostGraph::PathList> kShortestPaths = BoostGraph::findKShortestPaths(graphs, pairs, 3);
+
+	std::vector<BoostGraph::PathList> refPaths{
+		{{0, 2, 3, 5}, {0, 1, 2, 3, 5}, {0, 2, 4, 5}},
+		{{5, 3, 2, 1}, {5, 3, 1}, {5, 4, 2, 1}},
+		{{0, 2, 4, 5}, {0, 2, 3, 4, 5}, {0, 1, 2, 4, 5}},
+		{{5, 4, 2, 1}, {5, 4, 3, 2, 1}, {5, 4, 3, 1}},
+		{{0, 2, 3, 5}, {0, 1, 2, 3, 5}, {0, 2, 4, 5}},
+		{{5, 3, 2, 1}, {5, 3, 1}, {5, 4, 2, 1}}
+	};
+
+	ASSERT_EQ(refPaths.size(), kShortestPaths.size());
+	for (size_t i = 0; i != refPaths.size(); ++i) EXPECT_EQ(refPaths[i], kShortestPaths[i]);
+}
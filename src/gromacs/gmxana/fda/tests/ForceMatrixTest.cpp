@@ -0,0 +1,43 @@
+/*
+ * ForceMatrixTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <gtest/gtest.h>
+#include "gromacs/gmxana/fda/ForceMatrix.h"
+
+using namespace fda_analysis;
+
+//! Test for ForceMatrix
+TEST(ForceMatrixTest, SetAndArithmetic)
+{
+	ForceMatrix m(4), m2(4);
+	m.setSymmetric(2, 0, 3.0);
+	m.set(0, 1, -1.0);
+	m2.set(0, 1, 2.0);
+	m2.set(3, 3, 5.0);
+
+	EXPECT_EQ(3U, m.size());
+	EXPECT_DOUBLE_EQ(3.0, m(0, 2));
+	EXPECT_DOUBLE_EQ(0.0, m(1, 0));
+
+	// Columns of a row are sorted
+	ASSERT_EQ(2U, m.row(0).size());
+	EXPECT_EQ(1, m.row(0)[0].j);
+	EXPECT_EQ(2, m.row(0)[1].j);
+
+	m -= m2;
+	m.abs();
+	m *= 2.0;
+	EXPECT_EQ(4U, m.size());
+	EXPECT_DOUBLE_EQ(6.0, m(0, 1));
+	EXPECT_DOUBLE_EQ(6.0, m(0, 2));
+	EXPECT_DOUBLE_EQ(10.0, m(3, 3));
+
+	ForceMatrix dense(std::vector<double>{0.0, 1.0, 2.0, 0.0});
+	EXPECT_EQ(2, dense.dim());
+	EXPECT_EQ(2U, dense.size());
+	EXPECT_DOUBLE_EQ(2.0, dense(1, 0));
+}
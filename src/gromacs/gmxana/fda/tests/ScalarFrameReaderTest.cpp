@@ -0,0 +1,57 @@
+/*
+ * ScalarFrameReaderTest.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <fstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "gromacs/gmxana/fda/ScalarFrameReader.h"
+#include "testutils/testfilemanager.h"
+
+using namespace fda_analysis;
+
+//! All frames of an interval contribute to the average, also if they differ
+TEST(ScalarFrameReaderTest, AverageOfDifferentFrames)
+{
+    gmx::test::TestFileManager fileManager;
+    std::string filename = fileManager.getTemporaryFilePath("fda.pfr");
+    std::ofstream(filename) << "frame 0\n0 1 1.0 1\n"
+                               "frame 1\n0 1 -2.0 1\n1 2 3.0 1\n"
+                               "frame 2\n0 1 6.0 1\n"
+                               "frame 3\n1 2 4.0 1\n";
+
+    ScalarFrameReader reader(filename, 3);
+    ForceMatrix forceMatrix;
+
+    EXPECT_EQ(3, readAveragedFrames(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(3.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(3.0, forceMatrix(1, 0));
+    EXPECT_DOUBLE_EQ(1.0, forceMatrix(1, 2));
+    EXPECT_DOUBLE_EQ(0.0, forceMatrix(0, 2));
+
+    // The last interval is incomplete
+    EXPECT_EQ(1, readAveragedFrames(reader, nullptr, 3, forceMatrix));
+    EXPECT_DOUBLE_EQ(0.0, forceMatrix(0, 1));
+    EXPECT_DOUBLE_EQ(4.0, forceMatrix(1, 2));
+
+    EXPECT_EQ(0, readAveragedFrames(reader, nullptr, 3, forceMatrix));
+}
+
+//! The absolute value is taken of the difference of each frame
+TEST(ScalarFrameReaderTest, AverageOfDifferences)
+{
+    gmx::test::TestFileManager fileManager;
+    std::string filename = fileManager.getTemporaryFilePath("fda.pfr");
+    std::string filenameDiff = fileManager.getTemporaryFilePath("fda_diff.pfr");
+    std::ofstream(filename) << "frame 0\n0 1 1.0 1\nframe 1\n0 1 5.0 1\n";
+    std::ofstream(filenameDiff) << "frame 0\n0 1 3.0 1\nframe 1\n0 1 1.0 1\n";
+
+    ScalarFrameReader reader(filename, 2), readerDiff(filenameDiff, 2);
+    ForceMatrix forceMatrix;
+
+    EXPECT_EQ(2, readAveragedFrames(reader, &readerDiff, 2, forceMatrix));
+    EXPECT_DOUBLE_EQ(3.0, forceMatrix(0, 1));
+}
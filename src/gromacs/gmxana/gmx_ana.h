@@ -291,6 +291,9 @@ gmx_fda_view_stress(int argc, char *argv[]);
 int
 gmx_fda_shortest_path(int argc, char *argv[]);
 
+int
+gmx_fda_rerun(int argc, char *argv[]);
+
 #ifdef __cplusplus
 }
 #endif
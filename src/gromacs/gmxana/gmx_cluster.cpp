@@ -36,11 +36,15 @@
  */
 #include "gmxpre.h"
 
+#include "config.h"
+
+#include <climits>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -64,6 +68,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -475,7 +480,6 @@ static void jarvis_patrick(int n1, real **mat, int M, int P,
     int       **nnb;
     int         i, j, k, cid, diff, maxval;
     gmx_bool    bChange;
-    real      **mcpy = nullptr;
 
     if (rmsdcut < 0)
     {
@@ -551,14 +555,21 @@ static void jarvis_patrick(int n1, real **mat, int M, int P,
 
     c = new_clustid(n1);
     fprintf(stderr, "Linking structures ");
-    /* Use mcpy for temporary storage of booleans */
-    mcpy = mk_matrix(n1, n1, FALSE);
+    /* Store the linked pairs i < j, ordered on i and j. Linked structures
+     * are neighbors, so only the neighbor lists need to be checked.
+     */
+    std::vector<std::vector<int> > links(n1);
     for (i = 0; i < n1; i++)
     {
-        for (j = i+1; j < n1; j++)
+        for (k = 0; nnb[i][k] >= 0; k++)
         {
-            mcpy[i][j] = jp_same(nnb, i, j, P);
+            j = nnb[i][k];
+            if (j > i && jp_same(nnb, i, j, P))
+            {
+                links[i].push_back(j);
+            }
         }
+        std::sort(links[i].begin(), links[i].end());
     }
     do
     {
@@ -566,22 +577,20 @@ static void jarvis_patrick(int n1, real **mat, int M, int P,
         bChange = FALSE;
         for (i = 0; i < n1; i++)
         {
-            for (j = i+1; j < n1; j++)
+            for (size_t l = 0; l < links[i].size(); l++)
             {
-                if (mcpy[i][j])
+                j    = links[i][l];
+                diff = c[j].clust - c[i].clust;
+                if (diff)
                 {
-                    diff = c[j].clust - c[i].clust;
-                    if (diff)
+                    bChange = TRUE;
+                    if (diff > 0)
                     {
-                        bChange = TRUE;
-                        if (diff > 0)
-                        {
-                            c[j].clust = c[i].clust;
-                        }
-                        else
-                        {
-                            c[i].clust = c[j].clust;
-                        }
+                        c[j].clust = c[i].clust;
+                    }
+                    else
+                    {
+                        c[i].clust = c[j].clust;
                     }
                 }
             }
@@ -622,8 +631,6 @@ static void jarvis_patrick(int n1, real **mat, int M, int P,
         }
     }
 
-    done_matrix(n1, &mcpy);
-
     sfree(c);
     for (i = 0; (i < n1); i++)
     {
@@ -1306,6 +1313,125 @@ static void convert_mat(t_matrix *mat, t_mat *rms)
     rms->nn = mat->nx;
 }
 
+/* Number of frames per tile of the RMSD matrix. The coordinates of the
+ * frames of a pair of tiles should fit in cache.
+ */
+static const int c_rmsdTileSize = 32;
+
+/* Computes the RMSD matrix of the frames xx, the pairs of tiles of frames
+ * are distributed over the OpenMP threads.
+ */
+static void calc_rmsd_matrix(t_mat *rms, int nf, int isize, rvec **xx,
+                             real *mass, gmx_bool bFit, gmx_bool bRMSdist)
+{
+    const int   ntile = (nf + c_rmsdTileSize - 1)/c_rmsdTileSize;
+    gmx_int64_t nrms  = (static_cast<gmx_int64_t>(nf)*static_cast<gmx_int64_t>(nf-1))/2;
+
+#pragma omp parallel
+    {
+        /* Work arrays of this thread */
+        rvec  *x1 = nullptr;
+        real **d1 = nullptr, **d2 = nullptr;
+        if (!bRMSdist)
+        {
+            snew(x1, isize);
+        }
+        else
+        {
+            snew(d1, isize);
+            snew(d2, isize);
+            for (int i = 0; i < isize; i++)
+            {
+                snew(d1[i], isize);
+                snew(d2[i], isize);
+            }
+        }
+
+#pragma omp for schedule(dynamic)
+        for (int t = 0; t < ntile*ntile; t++)
+        {
+            const int ti = t/ntile;
+            const int tj = t%ntile;
+            if (tj < ti)
+            {
+                continue;
+            }
+            const int   i1end = std::min(nf, (ti + 1)*c_rmsdTileSize);
+            const int   i2end = std::min(nf, (tj + 1)*c_rmsdTileSize);
+            gmx_int64_t npair = 0;
+            for (int i1 = ti*c_rmsdTileSize; i1 < i1end; i1++)
+            {
+                if (bRMSdist)
+                {
+                    calc_dist(isize, xx[i1], d1);
+                }
+                for (int i2 = std::max(i1 + 1, tj*c_rmsdTileSize); i2 < i2end; i2++)
+                {
+                    real rmsd;
+                    if (!bRMSdist)
+                    {
+                        for (int i = 0; i < isize; i++)
+                        {
+                            copy_rvec(xx[i1][i], x1[i]);
+                        }
+                        if (bFit)
+                        {
+                            do_fit(isize, mass, xx[i2], x1);
+                        }
+                        rmsd = rmsdev(isize, mass, xx[i2], x1);
+                    }
+                    else
+                    {
+                        calc_dist(isize, xx[i2], d2);
+                        rmsd = rms_dist(isize, d1, d2);
+                    }
+                    rms->mat[i1][i2] = rms->mat[i2][i1] = rmsd;
+                    npair++;
+                }
+            }
+#pragma omp critical
+            {
+                nrms -= npair;
+                if (tj == ntile - 1)
+                {
+                    fprintf(stderr, "\r# RMSD calculations left: " "%" GMX_PRId64 "   ", nrms);
+                    fflush(stderr);
+                }
+            }
+        }
+
+        sfree(x1);
+        if (bRMSdist)
+        {
+            for (int i = 0; i < isize; i++)
+            {
+                sfree(d1[i]);
+                sfree(d2[i]);
+            }
+            sfree(d1);
+            sfree(d2);
+        }
+    }
+
+    /* Accumulate the statistics in the order of the serial computation,
+     * such that they do not depend on the number of threads.
+     */
+    for (int i1 = 0; i1 < nf; i1++)
+    {
+        for (int i2 = i1 + 1; i2 < nf; i2++)
+        {
+            real rmsd   = rms->mat[i1][i2];
+            rms->maxrms = std::max(rms->maxrms, rmsd);
+            rms->minrms = std::min(rms->minrms, rmsd);
+            rms->sumrms += rmsd;
+        }
+    }
+    if (nf > 1)
+    {
+        rms->nn = nf;
+    }
+}
+
 int gmx_cluster(int argc, char *argv[])
 {
     const char        *desc[] = {
@@ -1385,10 +1511,9 @@ int gmx_cluster(int argc, char *argv[])
 
     FILE              *fp, *log;
     int                nf   = 0, i, i1, i2, j;
-    gmx_int64_t        nrms = 0;
 
     matrix             box;
-    rvec              *xtps, *usextps, *x1, **xx = nullptr;
+    rvec              *xtps, *usextps, **xx = nullptr;
     const char        *fn, *trx_out_fn;
     t_clusters         clust;
     t_mat             *rms, *orig = nullptr;
@@ -1402,7 +1527,7 @@ int gmx_cluster(int argc, char *argv[])
     int                isize = 0, ifsize = 0, iosize = 0;
     int               *index = nullptr, *fitidx = nullptr, *outidx = nullptr;
     char              *grpname;
-    real               rmsd, **d1, **d2, *time = nullptr, time_invfac, *mass = nullptr;
+    real              *time = nullptr, time_invfac, *mass = nullptr;
     char               buf[STRLEN], buf1[80];
     gmx_bool           bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bPBC = TRUE;
 
@@ -1423,6 +1548,8 @@ int gmx_cluster(int argc, char *argv[])
     static int        nlevels  = 40, skip = 1;
     static real       scalemax = -1.0, rmsdcut = 0.1, rmsmin = 0.0;
     gmx_bool          bRMSdist = FALSE, bBinary = FALSE, bAverage = FALSE, bFit = TRUE;
+    gmx_bool          bMapped  = FALSE;
+    static int        nThreads = 0;
     static int        niter    = 10000, nrandom = 0, seed = 0, write_ncl = 0, write_nst = 1, minstruct = 1;
     static real       kT       = 1e-3;
     static int        M        = 10, P = 3;
@@ -1472,7 +1599,16 @@ int gmx_cluster(int argc, char *argv[])
           "Boltzmann weighting factor for Monte Carlo optimization "
           "(zero turns off uphill steps)" },
         { "-pbc", FALSE, etBOOL,
-          { &bPBC }, "PBC check" }
+          { &bPBC }, "PBC check" },
+        { "-mmap", FALSE, etBOOL, {&bMapped},
+          "Store the RMSD matrix in a temporary file in the working directory "
+          "which is mapped into memory, for matrices larger than the memory. "
+          "Not supported with the monte-carlo and diagonalization methods, "
+          "which need copies of the matrix in memory" },
+#if GMX_OPENMP
+        { "-nthreads", FALSE, etINT, {&nThreads},
+          "Number of threads used for computing the RMSD matrix. nThreads <= 0 means maximum number of threads." },
+#endif
     };
     t_filenm          fnm[] = {
         { efTRX, "-f",     nullptr,        ffOPTRD },
@@ -1542,6 +1678,12 @@ int gmx_cluster(int argc, char *argv[])
     bAnalyze = (method == m_linkage || method == m_jarvis_patrick ||
                 method == m_gromos );
 
+    /* These methods keep further copies of the full matrix in memory */
+    if (bMapped && (method == m_monte_carlo || method == m_diagonalize))
+    {
+        gmx_fatal(FARGS, "Option -mmap is not supported with the %s method", methodname[0]);
+    }
+
     /* Open log file */
     log = ftp2FILE(efLOG, NFILE, fnm, "w");
 
@@ -1712,74 +1854,19 @@ int gmx_cluster(int argc, char *argv[])
             time[i] *= time_invfac;
         }
 
-        rms = init_mat(readmat[0].nx, method == m_diagonalize);
+        rms = bMapped ? init_mapped_mat(nf, method == m_diagonalize) : init_mat(nf, method == m_diagonalize);
         convert_mat(&(readmat[0]), rms);
 
         nlevels = readmat[0].nmap;
     }
     else   /* !bReadMat */
     {
-        rms  = init_mat(nf, method == m_diagonalize);
-        nrms = (static_cast<gmx_int64_t>(nf)*static_cast<gmx_int64_t>(nf-1))/2;
-        if (!bRMSdist)
-        {
-            fprintf(stderr, "Computing %dx%d RMS deviation matrix\n", nf, nf);
-            /* Initialize work array */
-            snew(x1, isize);
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                for (i2 = i1+1; i2 < nf; i2++)
-                {
-                    for (i = 0; i < isize; i++)
-                    {
-                        copy_rvec(xx[i1][i], x1[i]);
-                    }
-                    if (bFit)
-                    {
-                        do_fit(isize, mass, xx[i2], x1);
-                    }
-                    rmsd = rmsdev(isize, mass, xx[i2], x1);
-                    set_mat_entry(rms, i1, i2, rmsd);
-                }
-                nrms -= nf-i1-1;
-                fprintf(stderr, "\r# RMSD calculations left: " "%" GMX_PRId64 "   ", nrms);
-                fflush(stderr);
-            }
-            sfree(x1);
-        }
-        else /* bRMSdist */
-        {
-            fprintf(stderr, "Computing %dx%d RMS distance deviation matrix\n", nf, nf);
-
-            /* Initiate work arrays */
-            snew(d1, isize);
-            snew(d2, isize);
-            for (i = 0; (i < isize); i++)
-            {
-                snew(d1[i], isize);
-                snew(d2[i], isize);
-            }
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                calc_dist(isize, xx[i1], d1);
-                for (i2 = i1+1; (i2 < nf); i2++)
-                {
-                    calc_dist(isize, xx[i2], d2);
-                    set_mat_entry(rms, i1, i2, rms_dist(isize, d1, d2));
-                }
-                nrms -= nf-i1-1;
-                fprintf(stderr, "\r# RMSD calculations left: " "%" GMX_PRId64 "   ", nrms);
-                fflush(stderr);
-            }
-            /* Clean up work arrays */
-            for (i = 0; (i < isize); i++)
-            {
-                sfree(d1[i]);
-                sfree(d2[i]);
-            }
-            sfree(d1);
-            sfree(d2);
-        }
+        rms  = bMapped ? init_mapped_mat(nf, method == m_diagonalize) : init_mat(nf, method == m_diagonalize);
+        nThreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+        gmx_omp_set_num_threads(nThreads);
+        fprintf(stderr, "Computing %dx%d RMS %sdeviation matrix\n", nf, nf,
+                bRMSdist ? "distance " : "");
+        calc_rmsd_matrix(rms, nf, isize, xx, mass, bFit, bRMSdist);
         fprintf(stderr, "\n\n");
     }
     ffprintf_gg(stderr, log, buf, "The RMSD ranges from %g to %g nm\n",
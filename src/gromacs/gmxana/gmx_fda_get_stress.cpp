@@ -10,12 +10,14 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <cstddef>
 #include <vector>
 #include "fda/Graph.h"
 #include "fda/Helpers.h"
+#include "fda/ScalarFrameReader.h"
 #include "gmx_ana.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/commandline/pargs.h"
@@ -60,21 +62,15 @@ int gmx_fda_get_stress(int argc, char *argv[])
     if (!parse_common_args(&argc, argv, PCA_CAN_TIME,
         NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, NULL, &oenv)) return 0;
 
-    size_t nbFrames = getNumberOfFrames(opt2fn("-ipf", NFILE, fnm));
     size_t nbParticles = getMaxIndexSecondColumnFirstFrame(opt2fn("-ipf", NFILE, fnm)) + 1;
-    size_t nbParticles2 = nbParticles * nbParticles;
 
     if (opt2bSet("-ipf-diff", NFILE, fnm) and (fn2ftp(opt2fn("-ipf-diff", NFILE, fnm)) != fn2ftp(opt2fn("-ipf", NFILE, fnm))))
         gmx_fatal(FARGS, "Type of the file (-ipf-diff) does not match the type of the file (-ipf).");
 
-    if (opt2bSet("-ipf-diff", NFILE, fnm) and getNumberOfFrames(opt2fn("-ipf-diff", NFILE, fnm)) != nbFrames)
-        gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
-
 	#ifdef PRINT_DEBUG
         std::cout << "pfx filename = " << opt2fn("-ipf", NFILE, fnm) << std::endl;
         if (opt2bSet("-ipf-diff", NFILE, fnm)) std::cout << "pfx-diff filename = " << opt2fn("-ipf-diff", NFILE, fnm) << std::endl;
         std::cout << "result filename = " << opt2fn("-o", NFILE, fnm) << std::endl;
-		std::cout << "nbFrames = " << nbFrames << std::endl;
 		std::cout << "nbParticles = " << nbParticles << std::endl;
 	#endif
 
@@ -82,22 +78,32 @@ int gmx_fda_get_stress(int argc, char *argv[])
     if (!opsFile) gmx_fatal(FARGS, "Error opening file", opt2fn("-o", NFILE, fnm));
     opsFile << std::scientific << std::setprecision(6);
 
-    for (size_t frame = 0; frame != nbFrames; ++frame)
+    // The pairwise forces are read frame by frame in a single pass
+    ScalarFrameReader reader(opt2fn("-ipf", NFILE, fnm), nbParticles);
+    std::unique_ptr<ScalarFrameReader> readerDiff;
+    if (opt2bSet("-ipf-diff", NFILE, fnm)) readerDiff.reset(new ScalarFrameReader(opt2fn("-ipf-diff", NFILE, fnm), nbParticles));
+
+    ForceMatrix forceMatrix, forceMatrix2;
+    while (reader.next(forceMatrix))
     {
-        std::vector<double> forceMatrix = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
-        if (opt2bSet("-ipf-diff", NFILE, fnm)) {
-        	std::vector<double> forceMatrix2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-            for (size_t i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
+        if (readerDiff) {
+            if (!readerDiff->next(forceMatrix2))
+                gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+            forceMatrix -= forceMatrix2;
         }
 
         for (size_t i = 0; i < nbParticles; ++i) {
         	real value = 0.0;
-            for (size_t j = 0; j < nbParticles; ++j) value += std::abs(forceMatrix[i*nbParticles + j]);
+            for (auto const& entry : forceMatrix.row(i)) value += std::abs(entry.force);
             opsFile << value << " ";
         }
         opsFile << std::endl;
     }
 
+    // Additional frames of the difference file are an error as well
+    if (readerDiff and readerDiff->skip())
+        gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+
     std::cout << "All done." << std::endl;
     return 0;
 
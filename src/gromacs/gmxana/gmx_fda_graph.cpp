@@ -9,6 +9,7 @@
 #include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 #include "fda/EnumParser.h"
@@ -16,6 +17,7 @@
 #include "fda/Graph.h"
 #include "fda/Helpers.h"
 #include "fda/ResultFormat.h"
+#include "fda/ScalarFrameReader.h"
 #include "gmx_ana.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/commandline/pargs.h"
@@ -60,11 +62,11 @@ int gmx_fda_graph(int argc, char *argv[])
     };
 
     gmx_output_env_t *oenv;
-    static real threshold = 0.0;
-    static const char* frameString = "average 1";
-    static int minGraphOrder = 2;
-    static bool onlyBiggestNetwork = false;
-    static bool convert = false;
+    real threshold = 0.0;
+    const char* frameString = "average 1";
+    int minGraphOrder = 2;
+    gmx_bool onlyBiggestNetwork = FALSE;
+    gmx_bool convert = FALSE;
 
     t_pargs pa[] = {
         { "-frame", FALSE, etSTR, {&frameString}, "Specify a single frame number or \"average n\" to take the mean over every n-th frame"
@@ -98,7 +100,6 @@ int gmx_fda_graph(int argc, char *argv[])
 
     // Get number of particles
     int nbParticles = getMaxIndexSecondColumnFirstFrame(opt2fn("-ipf", NFILE, fnm)) + 1;
-    int nbParticles2 = nbParticles * nbParticles;
 
     // Interactive input of group name for residue model points
     int isize = 0;
@@ -140,7 +141,7 @@ int gmx_fda_graph(int argc, char *argv[])
     matrix box;
     read_tps_conf(ftp2fn(efTPS, NFILE, fnm), &top, &ePBC, &coord, NULL, box, TRUE);
 
-    std::vector<double> forceMatrix, forceMatrix2;
+    ForceMatrix forceMatrix, forceMatrix2;
 
     // Pymol pml-file
     std::string molecularTrajectoryFilename = "traj.pdb";
@@ -160,11 +161,11 @@ int gmx_fda_graph(int argc, char *argv[])
         forceMatrix = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frameValue);
         if (opt2bSet("-ipf-diff", NFILE, fnm)) forceMatrix2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frameValue);
 
-        if (opt2bSet("-ipf-diff", NFILE, fnm)) for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-        for (auto & f : forceMatrix) f = std::abs(f);
+        if (opt2bSet("-ipf-diff", NFILE, fnm)) forceMatrix -= forceMatrix2;
+        forceMatrix.abs();
 
         // Convert from kJ/mol/nm into pN
-        if (convert) for (auto & f : forceMatrix) f *= 1.66;
+        if (convert) forceMatrix *= 1.66;
 
         Graph graph(forceMatrix, coord, index, isize);
         if (resultFormat == PDB)
@@ -182,43 +183,28 @@ int gmx_fda_graph(int argc, char *argv[])
         rvec *coord_traj;
         matrix box;
 
-	    int nbFrames = getNumberOfFrames(opt2fn("-ipf", NFILE, fnm));
-		for (int frame = 0; frame < nbFrames; ++frame)
+        // The pairwise forces are read frame by frame in a single pass
+        ScalarFrameReader reader(opt2fn("-ipf", NFILE, fnm), nbParticles);
+        std::unique_ptr<ScalarFrameReader> readerDiff;
+        if (opt2bSet("-ipf-diff", NFILE, fnm)) readerDiff.reset(new ScalarFrameReader(opt2fn("-ipf-diff", NFILE, fnm), nbParticles));
+
+		for (int frame = 0; reader.hasNext(); ++frame)
 		{
 		    if (frame == 0) read_first_x(oenv, &status, opt2fn("-traj", NFILE, fnm), &time, &coord_traj, box);
 		    else read_next_x(oenv, status, &time, coord_traj, box);
 
-		    if (frameType == SKIP and frame%frameValue) continue;
+		    if (frameType == SKIP and frame%frameValue) {
+		        reader.skip();
+		        if (readerDiff and !readerDiff->skip())
+		            gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+		        continue;
+		    }
 
-            forceMatrix = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
-            if (opt2bSet("-ipf-diff", NFILE, fnm)) {
-                forceMatrix2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-            }
-            for (auto & f : forceMatrix) f = std::abs(f);
+            // For AVERAGE the frames of the interval are averaged, otherwise only the current frame is used
+            int nbFramesRead = readAveragedFrames(reader, readerDiff.get(), frameType == AVERAGE ? frameValue : 1, forceMatrix);
 
             // Convert from kJ/mol/nm into pN
-            if (convert) for (auto & f : forceMatrix) f *= 1.66;
-
-		    if (frameType == AVERAGE) {
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg)
-                {
-                    std::vector<double> forceMatrixAvg, forceMatrixAvg2;
-                    forceMatrixAvg = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
-                    if (opt2bSet("-ipf-diff", NFILE, fnm)) {
-                        forceMatrixAvg2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-                        for (int i = 0; i < nbParticles2; ++i) forceMatrixAvg[i] -= forceMatrixAvg2[i];
-                    }
-
-                    for (auto & f : forceMatrixAvg) f = std::abs(f);
-
-                    // Convert from kJ/mol/nm into pN
-                    if (convert) for (auto & f : forceMatrixAvg) f *= 1.66;
-
-                    for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] += forceMatrixAvg[i];
-                }
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] /= frameValue;
-		    }
+            if (convert) forceMatrix *= 1.66;
 
             Graph graph(forceMatrix, coord_traj, index, isize);
             graph.convertInPDBMinGraphOrder(opt2fn("-o", NFILE, fnm), threshold, minGraphOrder, onlyBiggestNetwork, frame);
@@ -227,14 +213,13 @@ int gmx_fda_graph(int argc, char *argv[])
             if (opt2bSet("-pymol", NFILE, fnm))
                 write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms, coord_traj, ePBC, box, ' ', 0, NULL, TRUE);
 
-            if (frameType == AVERAGE) {
-                frame += frameValue - 1;
-                // It would be better to skip the next frameValue - 1 frames instead of reading them.
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg) {
-                    read_next_x(oenv, status, &time, coord_traj, box);
-                }
-            }
+            // The coordinates of the averaged frames are not used.
+            frame += nbFramesRead - 1;
+            for (int frameAvg = 1; frameAvg < nbFramesRead; ++frameAvg)
+                read_next_x(oenv, status, &time, coord_traj, box);
 		}
+		if (readerDiff and readerDiff->skip())
+		    gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
 		close_trx(status);
 	}
 
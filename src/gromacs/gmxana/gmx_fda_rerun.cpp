@@ -0,0 +1,388 @@
+/*
+ * gmx_fda_rerun.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "gmx_ana.h"
+#include "gromacs/commandline/filenm.h"
+#include "gromacs/commandline/pargs.h"
+#include "gromacs/fda/BinaryPairwiseForces.h"
+#include "gromacs/fda/CompressedStream.h"
+#include "gromacs/fda/FDASettings.h"
+#include "gromacs/fda/ResultType.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/readinp.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/warninp.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/filestream.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/programcontext.h"
+
+#if GMX_NATIVE_WINDOWS
+#include <direct.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// FDA result files which are passed to mdrun and merged afterwards
+const char *result_options[] = {"-pfa", "-pfr", "-psa", "-psr", "-vsa", "-vma"};
+
+/// Files written by mdrun -rerun besides the FDA results, removed after each task
+const char *mdrun_extensions[] = {".log", ".edr", ".trr", ".xtc", ".gro", ".cpt"};
+
+/// Returns for each frame of the trajectory whether mdrun -rerun collects the pairwise forces, i.e. whether its step is a multiple of nstfda
+std::vector<bool> find_fda_frames(gmx_output_env_t *oenv, const char *filename, int nstfda)
+{
+    t_trxstatus *status;
+    t_trxframe fr;
+    std::vector<bool> fda_frames;
+    if (read_first_frame(oenv, &status, filename, &fr, TRX_NEED_X)) {
+        do {
+            // mdrun counts the frames without step from zero
+            gmx_int64_t step = fr.bStep ? fr.step : fda_frames.size();
+            fda_frames.push_back(step % nstfda == 0);
+        } while (read_next_frame(oenv, status, &fr));
+        close_trx(status);
+    }
+    return fda_frames;
+}
+
+/**
+ * Returns the first frame of each chunk followed by the number of frames.
+ * A chunk has at least chunk_size frames and ends after a complete time averaging period of FDA frames,
+ * such that each average is taken in a single chunk.
+ */
+std::vector<int> chunk_boundaries(std::vector<bool> const& fda_frames, int chunk_size, int time_averaging_period)
+{
+    int nb_frames = fda_frames.size();
+    std::vector<int> boundaries(1, 0);
+    int nb_fda_frames = 0;
+    for (int frame = 0; frame != nb_frames - 1; ++frame) {
+        if (!fda_frames[frame]) continue;
+        ++nb_fda_frames;
+        if (frame + 1 - boundaries.back() >= chunk_size and nb_fda_frames % time_averaging_period == 0)
+            boundaries.push_back(frame + 1);
+    }
+    boundaries.push_back(nb_frames);
+    return boundaries;
+}
+
+/// Write the chunks of the trajectory one after another in a single pass, each just before it is evaluated
+class TrajectorySplitter
+{
+public:
+
+    TrajectorySplitter(gmx_output_env_t *oenv, const char *filename)
+     : oenv(oenv)
+    {
+        has_frame = read_first_frame(oenv, &status, filename, &fr, TRX_NEED_X | TRX_READ_V | TRX_READ_F);
+        if (!has_frame) gmx_fatal(FARGS, "No frame found in %s.", filename);
+    }
+
+    ~TrajectorySplitter() { close_trx(status); }
+
+    /// Write the next nb_frames frames into the file chunk_filename
+    void write_next(std::string const& chunk_filename, int nb_frames)
+    {
+        t_trxstatus *out = open_trx(chunk_filename.c_str(), "w");
+        for (int frame = 0; frame != nb_frames; ++frame) {
+            if (!has_frame) gmx_fatal(FARGS, "The trajectory ended while writing %s.", chunk_filename.c_str());
+            write_trxframe(out, &fr, nullptr);
+            has_frame = read_next_frame(oenv, status, &fr);
+        }
+        close_trx(out);
+    }
+
+private:
+
+    gmx_output_env_t *oenv;
+    t_trxstatus *status;
+    t_trxframe fr;
+    bool has_frame;
+};
+
+/// Quote an argument for the shell
+std::string quote(std::string const& arg)
+{
+#if GMX_NATIVE_WINDOWS
+    return "\"" + arg + "\"";
+#else
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+#endif
+}
+
+/// Create a private directory for the chunk files in TMPDIR, or /tmp if it is not set
+std::string make_temporary_directory()
+{
+    char const* tmpdir = std::getenv("TMPDIR");
+#if GMX_NATIVE_WINDOWS
+    if (!tmpdir or !*tmpdir) tmpdir = std::getenv("TEMP");
+    std::string path = std::string(tmpdir ? tmpdir : ".") + "\\fda_rerun_XXXXXX";
+    std::vector<char> buffer(path.begin(), path.end());
+    buffer.push_back('\0');
+    if (!_mktemp(buffer.data()) or _mkdir(buffer.data()) != 0)
+#else
+    std::string path = std::string(tmpdir and *tmpdir ? tmpdir : "/tmp") + "/fda_rerun_XXXXXX";
+    std::vector<char> buffer(path.begin(), path.end());
+    buffer.push_back('\0');
+    if (!mkdtemp(buffer.data()))
+#endif
+        gmx_fatal(FARGS, "Error creating temporary directory %s.", path.c_str());
+    return buffer.data();
+}
+
+/**
+ * Append the frames of the chunk result file to os and add first_frame to their frame numbers.
+ * Binary files are re-indexed, compressed text files are decompressed. Returns the number of frames.
+ */
+std::int64_t append_result(std::string const& chunk_filename, std::ostream& os, std::int64_t first_frame,
+    std::unique_ptr<fda::BinaryPairwiseForcesWriter>& binary_writer)
+{
+    std::int64_t nb_frames = 0;
+    if (fda::BinaryPairwiseForcesReader::is_binary(chunk_filename)) {
+        fda::BinaryPairwiseForcesReader reader(chunk_filename);
+        if (!binary_writer) binary_writer.reset(new fda::BinaryPairwiseForcesWriter(os, reader.get_syslen(), reader.get_precision()));
+        std::vector<fda::BinaryPairwiseForce> pairwise_forces;
+        for (size_t frame = 0; frame != reader.number_of_frames(); ++frame, ++nb_frames) {
+            pairwise_forces.assign(reader.begin(frame), reader.end(frame));
+            binary_writer->write_frame(first_frame + reader.frame_number(frame), pairwise_forces);
+        }
+    } else {
+        fda::InputFileStream is(chunk_filename);
+        if (!is) gmx_fatal(FARGS, "Error opening file %s.", chunk_filename.c_str());
+        for (std::string line; std::getline(is, line); ) {
+            if (line.compare(0, 6, "frame ") == 0) {
+                os << "frame " << first_frame + std::stoll(line.substr(6)) << '\n';
+                ++nb_frames;
+            } else {
+                os << line << '\n';
+            }
+        }
+    }
+    return nb_frames;
+}
+
+/**
+ * Merge the result files of all chunks in the order of the frames and remove them.
+ * If renumber is true, the frame numbers of each chunk are continued from the previous chunk.
+ * The merged file is compressed if the chunk files are compressed.
+ */
+void merge_results(std::string const& result_filename, std::vector<std::string> const& chunk_filenames, bool renumber)
+{
+    auto first = std::find_if(chunk_filenames.begin(), chunk_filenames.end(),
+        [](std::string const& chunk_filename){ return gmx_fexist(chunk_filename.c_str()); });
+    if (first == chunk_filenames.end()) return;
+
+    make_backup(result_filename.c_str());
+    std::ofstream file(result_filename, std::ios::binary);
+    if (!file) gmx_fatal(FARGS, "Error opening file %s.", result_filename.c_str());
+    if (chunk_filenames.size() == 1) {
+        // Results of a single chunk, e.g. in compatibility mode, are copied unchanged
+        std::ifstream is(*first, std::ios::binary);
+        file << is.rdbuf();
+        std::remove(first->c_str());
+        if (!file) gmx_fatal(FARGS, "Error writing file %s.", result_filename.c_str());
+        return;
+    }
+    std::unique_ptr<fda::CompressingStreamBuffer> compressor;
+    if (fda::is_compressed(*first)) compressor.reset(new fda::CompressingStreamBuffer(file.rdbuf()));
+    std::ostream os(compressor ? static_cast<std::streambuf*>(compressor.get()) : file.rdbuf());
+
+    std::unique_ptr<fda::BinaryPairwiseForcesWriter> binary_writer;
+    std::int64_t first_frame = 0;
+    for (auto const& chunk_filename : chunk_filenames) {
+        if (!gmx_fexist(chunk_filename.c_str())) continue;
+        std::int64_t nb_frames = append_result(chunk_filename, os, first_frame, binary_writer);
+        if (renumber) first_frame += nb_frames;
+        std::remove(chunk_filename.c_str());
+    }
+    if (binary_writer) binary_writer->write_index();
+    if (!os) gmx_fatal(FARGS, "Error writing file %s.", result_filename.c_str());
+}
+
+} // namespace
+
+int gmx_fda_rerun(int argc, char *argv[])
+{
+    const char *desc[] = {
+        "[THISMODULE] calculates the pairwise forces of an existing trajectory. ",
+        "The trajectory is split into chunks of consecutive frames, which are ",
+        "evaluated by independent [TT]gmx mdrun -rerun[tt] processes, [TT]-nt[tt] at a time. ",
+        "Each chunk is written to a private directory in [TT]TMPDIR[tt] ([TT]/tmp[tt] if not set) ",
+        "just before its evaluation and removed afterwards. ",
+        "The FDA result files of the chunks are merged in the order of the frames and ",
+        "the frames are numbered as in a single rerun, ",
+        "such that the results are identical to a single rerun.[PAR]",
+        "A chunk ends only after a complete period of [TT]time_averages_period[tt] frames ",
+        "whose step is a multiple of [TT]nstfda[tt], therefore chunks can be larger than [TT]-chunk[tt]. ",
+        "Averages over the whole trajectory ([TT]time_averages_period = 0[tt]) ",
+        "and the compatibility formats can only be computed in a single chunk."
+    };
+
+    gmx_output_env_t *oenv;
+    int nb_tasks = 0;
+    int chunk_size = 0;
+    int nb_threads_mdrun = 1;
+
+    t_pargs pa[] = {
+        { "-nt", FALSE, etINT, {&nb_tasks}, "Number of concurrent mdrun processes, 0 is the number of cores" },
+        { "-chunk", FALSE, etINT, {&chunk_size}, "Minimal number of frames per mdrun process, 0 distributes the frames evenly" },
+        { "-ntmdrun", FALSE, etINT, {&nb_threads_mdrun}, "Number of threads of each mdrun process" }
+    };
+
+    t_filenm fnm[] = {
+        { efTPR, "-s", NULL, ffREAD },
+        { efTRX, "-f", NULL, ffREAD },
+        { efPFI, "-pfi", "fda", ffREAD },
+        { efNDX, "-pfn", NULL, ffREAD },
+        { efPFA, "-pfa", "fda", ffOPTWR },
+        { efPFR, "-pfr", "fda", ffOPTWR },
+        { efPSA, "-psa", "fda", ffOPTWR },
+        { efPSR, "-psr", "fda", ffOPTWR },
+        { efVSA, "-vsa", "fda", ffOPTWR },
+        { efVMA, "-vma", "fda", ffOPTWR }
+    };
+
+#define NFILE asize(fnm)
+
+    if (!parse_common_args(&argc, argv, 0,
+        NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, NULL, &oenv)) return 0;
+
+    if (nb_tasks < 0) gmx_fatal(FARGS, "Invalid value for -nt: %d", nb_tasks);
+    if (chunk_size < 0) gmx_fatal(FARGS, "Invalid value for -chunk: %d", chunk_size);
+    if (nb_threads_mdrun < 1) gmx_fatal(FARGS, "Invalid value for -ntmdrun: %d", nb_threads_mdrun);
+    if (nb_tasks == 0) nb_tasks = std::max(1u, std::thread::hardware_concurrency() / nb_threads_mdrun);
+
+    // The settings which restrict the chunking
+    const char *pfi_filename = opt2fn("-pfi", NFILE, fnm);
+    warninp_t wi = init_warning(FALSE, 0);
+    int ninp;
+    gmx::TextInputFile stream(pfi_filename);
+    t_inpfile *inp = read_inpfile(&stream, pfi_filename, &ninp, wi);
+    fda::ResultType atom_based_result_type, residue_based_result_type;
+    std::stringstream(get_estr(&ninp, &inp, "atombased", "no")) >> atom_based_result_type;
+    std::stringstream(get_estr(&ninp, &inp, "residuebased", "no")) >> residue_based_result_type;
+    int time_averaging_period = get_eint(&ninp, &inp, "time_averages_period", 1, wi);
+    int nstfda = get_eint(&ninp, &inp, "nstfda", 1, wi);
+    bool time_averaging_stddev = strcasecmp(get_estr(&ninp, &inp, "time_averages_stddev", "no"), "no");
+    done_warning(wi, FARGS);
+    if (nstfda < 1) gmx_fatal(FARGS, "Invalid value for nstfda: %d", nstfda);
+
+    fda::FDASettings fda_settings;
+    bool single_chunk = time_averaging_period == 0 or
+        fda_settings.compatibility_mode(atom_based_result_type) or fda_settings.compatibility_mode(residue_based_result_type);
+
+    std::vector<bool> fda_frames = find_fda_frames(oenv, opt2fn("-f", NFILE, fnm), nstfda);
+    int nb_frames = fda_frames.size();
+    if (nb_frames == 0) gmx_fatal(FARGS, "No frame found in %s.", opt2fn("-f", NFILE, fnm));
+
+    if (single_chunk) chunk_size = nb_frames;
+    else if (chunk_size == 0) chunk_size = (nb_frames + nb_tasks - 1) / nb_tasks;
+    std::vector<int> boundaries = chunk_boundaries(fda_frames, chunk_size, std::max(time_averaging_period, 1));
+    int nb_chunks = boundaries.size() - 1;
+
+    // mdrun numbers the frames consecutively, but all time averages as frame 0
+    bool renumber = time_averaging_period == 1;
+
+    std::cout << "Evaluating " << nb_frames << " frames in " << nb_chunks << " chunks of at least " << std::min(chunk_size, nb_frames)
+              << " frames with " << std::min(nb_tasks, nb_chunks) << " concurrent mdrun processes." << std::endl;
+
+    std::string directory = make_temporary_directory();
+    std::vector<std::string> chunk_prefixes, chunk_trajectories;
+    for (int chunk = 0; chunk != nb_chunks; ++chunk) {
+        chunk_prefixes.push_back(directory + "/chunk" + std::to_string(chunk));
+        chunk_trajectories.push_back(chunk_prefixes.back() + "_traj.trr");
+    }
+
+    // Result options of mdrun, the file extensions are those of the final result files
+    std::vector<std::pair<std::string, std::string>> results;
+    for (auto option : result_options) {
+        if (opt2bSet(option, NFILE, fnm)) {
+            std::string filename = opt2fn(option, NFILE, fnm);
+            results.push_back(std::make_pair(option, filename.substr(filename.find_last_of('.'))));
+        }
+    }
+    if (results.empty()) gmx_fatal(FARGS, "No FDA result file was requested.");
+
+    std::string gmx_binary = gmx::getProgramContext().fullBinaryPath();
+    std::vector<int> exit_codes(nb_chunks, 0);
+    TrajectorySplitter splitter(oenv, opt2fn("-f", NFILE, fnm));
+    std::mutex splitter_mutex;
+    int next_chunk = 0;
+    auto worker = [&]() {
+        for (;;) {
+            // The chunks are taken and written in the order of the frames
+            int chunk;
+            {
+                std::lock_guard<std::mutex> lock(splitter_mutex);
+                if (next_chunk == nb_chunks) return;
+                chunk = next_chunk++;
+                splitter.write_next(chunk_trajectories[chunk], boundaries[chunk + 1] - boundaries[chunk]);
+            }
+            std::string const& chunk_prefix = chunk_prefixes[chunk];
+            std::string command = quote(gmx_binary) + " mdrun -s " + quote(opt2fn("-s", NFILE, fnm)) +
+                " -rerun " + quote(chunk_trajectories[chunk]) +
+                " -pfi " + quote(pfi_filename) + " -pfn " + quote(opt2fn("-pfn", NFILE, fnm)) +
+                " -deffnm " + quote(chunk_prefix) + " -nt " + std::to_string(nb_threads_mdrun);
+            for (auto const& result : results) command += " " + result.first + " " + quote(chunk_prefix + result.second);
+            command += " > " + quote(chunk_prefix + ".out") + " 2>&1";
+            exit_codes[chunk] = std::system(command.c_str());
+            std::remove(chunk_trajectories[chunk].c_str());
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min(nb_tasks, nb_chunks); ++t) workers.emplace_back(worker);
+    for (auto& w : workers) w.join();
+
+    for (int chunk = 0; chunk != nb_chunks; ++chunk) {
+        if (exit_codes[chunk] != 0)
+            gmx_fatal(FARGS, "mdrun failed for frames %d to %d, see %s.out.",
+                      boundaries[chunk], boundaries[chunk + 1] - 1, chunk_prefixes[chunk].c_str());
+    }
+
+    for (auto const& result : results) {
+        std::vector<std::string> chunk_results, chunk_stddev_results;
+        for (auto const& chunk_prefix : chunk_prefixes) {
+            chunk_results.push_back(chunk_prefix + result.second);
+            chunk_stddev_results.push_back(fda::FDASettings::stddev_filename(chunk_results.back()));
+        }
+        std::string result_filename = opt2fn(result.first.c_str(), NFILE, fnm);
+        merge_results(result_filename, chunk_results, renumber);
+        if (time_averaging_stddev) merge_results(fda::FDASettings::stddev_filename(result_filename), chunk_stddev_results, renumber);
+    }
+
+    for (auto const& chunk_prefix : chunk_prefixes) {
+        for (auto extension : mdrun_extensions) std::remove((chunk_prefix + extension).c_str());
+        std::remove((chunk_prefix + ".out").c_str());
+    }
+    std::remove(directory.c_str());
+
+    std::cout << "All done." << std::endl;
+    return 0;
+}
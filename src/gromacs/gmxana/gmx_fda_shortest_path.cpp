@@ -5,18 +5,24 @@
  *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
  */
 
+#include <algorithm>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include "fda/BoostGraph.h"
 #include "fda/EnumParser.h"
 #include "fda/FrameType.h"
 #include "fda/Helpers.h"
 #include "fda/PDB.h"
+#include "fda/ScalarFrameReader.h"
 #include "gmx_ana.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/commandline/pargs.h"
@@ -24,6 +30,7 @@
 #include "gromacs/fileio/pdbio.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
@@ -31,6 +38,7 @@
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 
 #ifdef HAVE_CONFIG_H
@@ -41,6 +49,50 @@ using namespace fda_analysis;
 
 #define PRINT_DEBUG
 
+namespace {
+
+//! Read source and destination nodes, one pair per line, lines starting with # are ignored
+std::vector<BoostGraph::SourceDest> readSourceDestPairs(std::string const& filename, int nbParticles)
+{
+    std::ifstream is(filename);
+    if (!is) gmx_fatal(FARGS, "Error opening file %s.", filename.c_str());
+
+    std::vector<BoostGraph::SourceDest> pairs;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if (line.empty() or line[0] == '#') continue;
+        std::istringstream iss(line);
+        int source, dest;
+        if (!(iss >> source >> dest)) gmx_fatal(FARGS, "Error reading source and destination in %s.", filename.c_str());
+        if (source < 0 or source >= nbParticles or dest < 0 or dest >= nbParticles)
+            gmx_fatal(FARGS, "Source or destination node in %s is out of range.", filename.c_str());
+        pairs.push_back(BoostGraph::SourceDest(source, dest));
+    }
+    if (pairs.empty()) gmx_fatal(FARGS, "No source and destination pair found in %s.", filename.c_str());
+    return pairs;
+}
+
+//! Pairwise forces and coordinates of a frame, which are kept until the paths are written
+struct FrameData
+{
+    int frame;
+    ForceMatrix forceMatrix;
+    std::vector<gmx::RVec> coord;
+    matrix box;
+};
+
+//! Concatenate the paths of all source/destination pairs of graph g
+BoostGraph::PathList collectPaths(std::vector<BoostGraph::PathList> const& paths, size_t g, size_t nbPairs)
+{
+    BoostGraph::PathList result;
+    for (size_t p = 0; p < nbPairs; ++p)
+        result.insert(result.end(), paths[g * nbPairs + p].begin(), paths[g * nbPairs + p].end());
+    return result;
+}
+
+} // namespace
+
 int gmx_fda_shortest_path(int argc, char *argv[])
 {
     const char *desc[] = {
@@ -55,14 +107,18 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         "(32 different colors). The Bfactor column will be used for the value of "
         "the force and helps the coloring as a function of the force magnitude. "
         "The CONNECT header will be used to create bonds between nodes. "
+        "Multiple source and destination pairs can be given by the file [TT]-pairs[tt], "
+        "which contains one pair per line. The paths of all pairs are written into the same model. "
+        "The paths of several pairs and frames are calculated concurrently with [TT]-nt[tt] threads. "
     };
 
     gmx_output_env_t *oenv;
-    static const char* frameString = "average 1";
-    static int source = 0;
-    static int dest = 0;
-    static int numberOfShortestPaths = 1;
-    static bool convert = false;
+    const char* frameString = "average 1";
+    int source = 0;
+    int dest = 0;
+    int numberOfShortestPaths = 1;
+    gmx_bool convert = FALSE;
+    int nbThreads = 0;
 
     t_pargs pa[] = {
         { "-frame", FALSE, etSTR, {&frameString}, "Specify a single frame number or \"average n\" to take the mean over every n-th frame"
@@ -70,7 +126,8 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         { "-source", FALSE, etINT, {&source}, "Source node of the path" },
         { "-dest", FALSE, etINT, {&dest}, "Destination point of the path" },
         { "-nk", FALSE, etINT, {&numberOfShortestPaths}, "Number of shortest paths" },
-        { "-convert", FALSE, etBOOL, {&convert}, "Convert force unit from kJ/mol/nm into pN" }
+        { "-convert", FALSE, etBOOL, {&convert}, "Convert force unit from kJ/mol/nm into pN" },
+        { "-nt", FALSE, etINT, {&nbThreads}, "Number of threads for the path search, 0 means maximum number of threads" }
     };
 
     t_filenm fnm[] = {
@@ -80,7 +137,8 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         { efTRX, "-traj", NULL, ffOPTRD },
         { efNDX, NULL, NULL, ffOPTRD },
         { efPDB, "-o", "result", ffWRITE },
-        { efPML, "-pymol", "result", ffOPTWR }
+        { efPML, "-pymol", "result", ffOPTWR },
+        { efDAT, "-pairs", "pairs", ffOPTRD }
     };
 
 #define NFILE asize(fnm)
@@ -96,7 +154,6 @@ int gmx_fda_shortest_path(int argc, char *argv[])
 
     // Get number of particles
     int nbParticles = getMaxIndexSecondColumnFirstFrame(opt2fn("-ipf", NFILE, fnm)) + 1;
-    int nbParticles2 = nbParticles * nbParticles;
 
     // Interactive input of group name for residue model points
     int isize = 0;
@@ -109,6 +166,13 @@ int gmx_fda_shortest_path(int argc, char *argv[])
     int frameValue;
     FrameType frameType = getFrameTypeAndSkipValue(frameString, frameValue);
 
+    std::vector<BoostGraph::SourceDest> pairs;
+    if (opt2bSet("-pairs", NFILE, fnm)) pairs = readSourceDestPairs(opt2fn("-pairs", NFILE, fnm), nbParticles);
+    else pairs.push_back(BoostGraph::SourceDest(source, dest));
+
+    nbThreads = std::min((nbThreads <= 0) ? INT_MAX : nbThreads, gmx_omp_get_max_threads());
+    gmx_omp_set_num_threads(nbThreads);
+
 	#ifdef PRINT_DEBUG
 		std::cerr << "frameType = " << EnumParser<FrameType>()(frameType) << std::endl;
 		std::cerr << "frameValue = " << frameValue << std::endl;
@@ -133,7 +197,7 @@ int gmx_fda_shortest_path(int argc, char *argv[])
 
     PDB pdb(opt2fn("-s", NFILE, fnm), std::vector<int>(index, index + isize));
 
-    std::vector<double> forceMatrix, forceMatrix2;
+    ForceMatrix forceMatrix, forceMatrix2;
 
     // Pymol pml-file
     std::string molecularTrajectoryFilename = "traj.pdb";
@@ -153,18 +217,18 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         forceMatrix = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
         if (opt2bSet("-ipf-diff", NFILE, fnm)) {
             forceMatrix2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-            for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
+            forceMatrix -= forceMatrix2;
         }
 
-        for (auto & f : forceMatrix) f = std::abs(f);
+        forceMatrix.abs();
 
         // Convert from kJ/mol/nm into pN
-        if (convert) for (auto & f : forceMatrix) f *= 1.66;
+        if (convert) forceMatrix *= 1.66;
 
-        BoostGraph graph(forceMatrix);
-        BoostGraph::PathList shortestPaths = graph.findKShortestPaths(source, dest, numberOfShortestPaths);
+        std::vector<BoostGraph> graphs(1, BoostGraph(forceMatrix));
+        std::vector<BoostGraph::PathList> paths = BoostGraph::findKShortestPaths(graphs, pairs, numberOfShortestPaths);
 
-        pdb.writePaths(opt2fn("-o", NFILE, fnm), shortestPaths, forceMatrix, false);
+        pdb.writePaths(opt2fn("-o", NFILE, fnm), collectPaths(paths, 0, pairs.size()), forceMatrix, false);
 
     } else {
 
@@ -173,63 +237,71 @@ int gmx_fda_shortest_path(int argc, char *argv[])
         real time;
         rvec *coord_traj;
         matrix box;
+        int natoms = 0;
 
-        int nbFrames = getNumberOfFrames(opt2fn("-ipf", NFILE, fnm));
-        for (int frame = 0; frame < nbFrames; ++frame)
-        {
-            if (frame == 0) read_first_x(oenv, &status, opt2fn("-traj", NFILE, fnm), &time, &coord_traj, box);
-            else read_next_x(oenv, status, &time, coord_traj, box);
+        // The frames are collected in batches, whose paths are calculated concurrently and written in order
+        std::vector<FrameData> batch;
+        size_t batchSize = 4 * nbThreads;
 
-            if (frameType == SKIP and frame%frameValue) continue;
+        auto processBatch = [&]()
+        {
+            std::vector<BoostGraph> graphs(batch.size());
+            #pragma omp parallel for schedule(dynamic)
+            for (int f = 0; f < static_cast<int>(batch.size()); ++f) graphs[f] = BoostGraph(batch[f].forceMatrix);
 
-			forceMatrix = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
-			if (opt2bSet("-ipf-diff", NFILE, fnm)) {
-			    forceMatrix2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-			    for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] -= forceMatrix2[i];
-			}
-    		for (auto & f : forceMatrix) f = std::abs(f);
+            std::vector<BoostGraph::PathList> paths = BoostGraph::findKShortestPaths(graphs, pairs, numberOfShortestPaths);
 
-    		// Convert from kJ/mol/nm into pN
-    		if (convert) for (auto & f : forceMatrix) f *= 1.66;
+            for (size_t f = 0; f < batch.size(); ++f)
+            {
+                pdb.updateCoordinates(as_rvec_array(batch[f].coord.data()));
+                pdb.writePaths(opt2fn("-o", NFILE, fnm), collectPaths(paths, f, pairs.size()), batch[f].forceMatrix, batch[f].frame);
 
-            if (frameType == AVERAGE) {
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg)
-                {
-                    std::vector<double> forceMatrixAvg, forceMatrixAvg2;
-                    forceMatrixAvg = parseScalarFileFormat(opt2fn("-ipf", NFILE, fnm), nbParticles, frame);
-                    if (opt2bSet("-ipf-diff", NFILE, fnm)) {
-                        forceMatrixAvg2 = parseScalarFileFormat(opt2fn("-ipf-diff", NFILE, fnm), nbParticles, frame);
-                        for (int i = 0; i < nbParticles2; ++i) forceMatrixAvg[i] -= forceMatrixAvg2[i];
-                    }
+                // Write moleculare trajectory for pymol script
+                if (opt2bSet("-pymol", NFILE, fnm))
+                    write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms,
+                        as_rvec_array(batch[f].coord.data()), ePBC, batch[f].box, ' ', 0, NULL, TRUE);
+            }
+            batch.clear();
+        };
 
-                    for (auto & f : forceMatrixAvg) f = std::abs(f);
+        // The pairwise forces are read frame by frame in a single pass
+        ScalarFrameReader reader(opt2fn("-ipf", NFILE, fnm), nbParticles);
+        std::unique_ptr<ScalarFrameReader> readerDiff;
+        if (opt2bSet("-ipf-diff", NFILE, fnm)) readerDiff.reset(new ScalarFrameReader(opt2fn("-ipf-diff", NFILE, fnm), nbParticles));
 
-                    // Convert from kJ/mol/nm into pN
-                    if (convert) for (auto & f : forceMatrixAvg) f *= 1.66;
+        for (int frame = 0; reader.hasNext(); ++frame)
+        {
+            if (frame == 0) natoms = read_first_x(oenv, &status, opt2fn("-traj", NFILE, fnm), &time, &coord_traj, box);
+            else read_next_x(oenv, status, &time, coord_traj, box);
 
-                    for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] += forceMatrixAvg[i];
-                }
-                for (int i = 0; i < nbParticles2; ++i) forceMatrix[i] /= frameValue;
+            if (frameType == SKIP and frame%frameValue) {
+                reader.skip();
+                if (readerDiff and !readerDiff->skip())
+                    gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
+                continue;
             }
 
-    		BoostGraph graph(forceMatrix);
-    		BoostGraph::PathList shortestPaths = graph.findKShortestPaths(source, dest, numberOfShortestPaths);
+            // For AVERAGE the frames of the interval are averaged, otherwise only the current frame is used
+            int nbFramesRead = readAveragedFrames(reader, readerDiff.get(), frameType == AVERAGE ? frameValue : 1, forceMatrix);
 
-    		pdb.updateCoordinates(coord_traj);
-    		pdb.writePaths(opt2fn("-o", NFILE, fnm), shortestPaths, forceMatrix, frame);
+            // Convert from kJ/mol/nm into pN
+            if (convert) forceMatrix *= 1.66;
 
-            // Write moleculare trajectory for pymol script
-            if (opt2bSet("-pymol", NFILE, fnm))
-                write_pdbfile(molecularTrajectoryFile, "FDA trajectory for Pymol visualization", &top.atoms, coord_traj, ePBC, box, ' ', 0, NULL, TRUE);
+            batch.push_back(FrameData());
+            batch.back().frame = frame;
+            batch.back().forceMatrix = std::move(forceMatrix);
+            batch.back().coord.assign(coord_traj, coord_traj + natoms);
+            copy_mat(box, batch.back().box);
+            if (batch.size() == batchSize) processBatch();
 
-            if (frameType == AVERAGE) {
-                frame += frameValue - 1;
-                // It would be better to skip the next frameValue - 1 frames instead of reading them.
-                for (int frameAvg = 0; frameAvg < frameValue - 1; ++frameAvg) {
-                    read_next_x(oenv, status, &time, coord_traj, box);
-                }
-            }
+            // The coordinates of the averaged frames are not used.
+            frame += nbFramesRead - 1;
+            for (int frameAvg = 1; frameAvg < nbFramesRead; ++frameAvg)
+                read_next_x(oenv, status, &time, coord_traj, box);
         }
+        if (!batch.empty()) processBatch();
+        if (readerDiff and readerDiff->skip())
+            gmx_fatal(FARGS, "Number of frames is not identical between the two pairwise force files.");
         close_trx(status);
     }
 
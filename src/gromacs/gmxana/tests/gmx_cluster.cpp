@@ -0,0 +1,171 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2026, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx cluster.
+ */
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <cmath>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Number of frames, enough to cover several tiles of the RMSD matrix.
+const int c_numFrames = 70;
+
+class ClusterTest : public gmx::test::CommandLineTestBase
+{
+    public:
+        ClusterTest()
+            : trajectory_(fileManager().getTemporaryFilePath("traj.trr"))
+        {
+            writeTrajectory();
+        }
+
+        /*! \brief Runs gmx cluster and returns the contents of its
+         * outputs without the comment and xmgrace header lines, which
+         * contain the command line. */
+        std::string runCluster(const char *method, int numThreads, bool mapped)
+        {
+            std::string suffix = std::string(method) + "-" + std::to_string(numThreads)
+                + (mapped ? "-mmap" : "");
+            std::string clust  = fileManager().getTemporaryFilePath(suffix + "-clust.xpm");
+            std::string dist   = fileManager().getTemporaryFilePath(suffix + "-dist.xvg");
+            std::string log    = fileManager().getTemporaryFilePath(suffix + ".log");
+            std::string clid   = fileManager().getTemporaryFilePath(suffix + "-clid.xvg");
+
+            gmx::test::CommandLine cmdline;
+            cmdline.append("cluster");
+            cmdline.addOption("-s", fileManager().getInputFilePath("spc2.gro"));
+            cmdline.addOption("-f", trajectory_);
+            cmdline.addOption("-method", method);
+            cmdline.addOption("-cutoff", "0.05");
+            cmdline.addOption("-o", clust);
+            cmdline.addOption("-dist", dist);
+            cmdline.addOption("-g", log);
+            cmdline.addOption("-clid", clid);
+#if GMX_OPENMP
+            gmx_omp_set_num_threads(numThreads);
+            cmdline.addOption("-nthreads", numThreads);
+#endif
+            if (mapped)
+            {
+                cmdline.addOption("-mmap");
+            }
+
+            gmx::test::StdioTestHelper stdioHelper(&fileManager());
+            stdioHelper.redirectStringToStdin("System\nSystem\n");
+            EXPECT_EQ(0, gmx_cluster(cmdline.argc(), cmdline.argv()));
+
+            return stripHeaders(clust) + stripHeaders(dist) + stripHeaders(log) + stripHeaders(clid);
+        }
+
+    private:
+        //! Writes water molecules that move and rotate deterministically.
+        void writeTrajectory()
+        {
+            const rvec base[] = {
+                { 0.569, 1.275, 1.165 }, { 0.476, 1.268, 1.128 }, { 0.580, 1.364, 1.209 },
+                { 1.555, 1.511, 0.703 }, { 1.498, 1.495, 0.784 }, { 1.496, 1.521, 0.623 }
+            };
+            const int  natoms = asize(base);
+            matrix     box    = {{ 3.01, 0, 0 }, { 0, 3.01, 0 }, { 0, 0, 3.01 }};
+            rvec       x[asize(base)];
+
+            t_fileio  *fio = gmx_trr_open(trajectory_.c_str(), "w");
+            for (int frame = 0; frame < c_numFrames; ++frame)
+            {
+                for (int i = 0; i < natoms; ++i)
+                {
+                    for (int d = 0; d < DIM; ++d)
+                    {
+                        x[i][d] = base[i][d] + 0.1*std::sin(0.37*frame*(d + 1) + 1.3*i);
+                    }
+                }
+                gmx_trr_write_frame(fio, frame, frame, 0, box, natoms, x, nullptr, nullptr);
+            }
+            gmx_trr_close(fio);
+        }
+
+        static std::string stripHeaders(const std::string &fileName)
+        {
+            std::istringstream input(gmx::TextReader::readFileToString(fileName));
+            std::string        result;
+            std::string        line;
+            while (std::getline(input, line))
+            {
+                if (!line.empty() && line[0] != '#' && line[0] != '@')
+                {
+                    result += line + "\n";
+                }
+            }
+            return result;
+        }
+
+        std::string trajectory_;
+};
+
+TEST_F(ClusterTest, OutputIsIndependentOfThreadsAndMapping)
+{
+    for (const char *method : { "linkage", "gromos", "jarvis-patrick" })
+    {
+        SCOPED_TRACE(method);
+        const std::string reference = runCluster(method, 1, false);
+        EXPECT_EQ(reference, runCluster(method, 4, false));
+        EXPECT_EQ(reference, runCluster(method, 1, true));
+        EXPECT_EQ(reference, runCluster(method, 4, true));
+    }
+}
+
+} // namespace
@@ -153,24 +153,36 @@ static void bc_strings_resinfo(const t_commrec *cr, t_symtab *symtab,
 
 static void bc_symtab(const t_commrec *cr, t_symtab *symtab)
 {
-    int       i, nr, len;
+    int       i, j, nr, len;
     t_symbuf *symbuf;
 
     block_bc(cr, symtab->nr);
     nr = symtab->nr;
     snew_bc(cr, symtab->symbuf, 1);
     symbuf          = symtab->symbuf;
-    symbuf->bufsize = nr;
+    if (!MASTER(cr))
+    {
+        symbuf->bufsize = nr;
+    }
     snew_bc(cr, symbuf->buf, nr);
-    for (i = 0; i < nr; i++)
+    /* On the master names added after reading the tpr file, e.g. the FDA
+     * energy groups, are stored in further buffers of the symtab.
+     * The other ranks receive all names in a single buffer.
+     */
+    for (i = 0, j = 0; i < nr; i++, j++)
     {
         if (MASTER(cr))
         {
-            len = strlen(symbuf->buf[i]) + 1;
+            if (j == symbuf->bufsize)
+            {
+                symbuf = symbuf->next;
+                j      = 0;
+            }
+            len = strlen(symbuf->buf[j]) + 1;
         }
         block_bc(cr, len);
-        snew_bc(cr, symbuf->buf[i], len);
-        nblock_bc(cr, len, symbuf->buf[i]);
+        snew_bc(cr, symbuf->buf[j], len);
+        nblock_bc(cr, len, symbuf->buf[j]);
     }
 }
 
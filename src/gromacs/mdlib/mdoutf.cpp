@@ -36,6 +36,8 @@
 
 #include "mdoutf.h"
 
+#include <string>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
@@ -43,6 +45,7 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/vec.h"
@@ -61,6 +64,7 @@
 struct gmx_mdoutf {
     t_fileio               *fp_trn;
     t_fileio               *fp_xtc;
+    t_xtc_index            *xtc_index;               /* frames written to fp_xtc, NULL when appending */
     tng_trajectory_t        tng;
     tng_trajectory_t        tng_low_prec;
     int                     x_compression_precision; /* only used by XTC output */
@@ -98,6 +102,7 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
     of->fp_trn       = nullptr;
     of->fp_ene       = nullptr;
     of->fp_xtc       = nullptr;
+    of->xtc_index    = nullptr;
     of->tng          = nullptr;
     of->tng_low_prec = nullptr;
     of->fp_dhdl      = nullptr;
@@ -128,6 +133,12 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
             {
                 case efXTC:
                     of->fp_xtc                  = open_xtc(filename, filemode);
+                    if (!bAppendFiles)
+                    {
+                        /* Write the frame index next to the file at the end,
+                         * such that tools do not have to build it */
+                        of->xtc_index = new t_xtc_index;
+                    }
                     break;
                 case efTNG:
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
@@ -366,6 +377,7 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                     }
                 }
             }
+            gmx_off_t xtcOffset = (of->xtc_index ? gmx_fio_ftell(of->fp_xtc) : 0);
             if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
                           state_local->box, xxtc, of->x_compression_precision) == 0)
             {
@@ -374,6 +386,12 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, t_commrec *cr,
                           "simulation with major instabilities resulting in coordinates "
                           "that are NaN or too large to be represented in the XTC format.\n");
             }
+            if (of->xtc_index)
+            {
+                of->xtc_index->offset.push_back(xtcOffset);
+                of->xtc_index->step.push_back(step);
+                of->xtc_index->time.push_back(t);
+            }
             gmx_fwrite_tng(of->tng_low_prec,
                            TRUE,
                            step,
@@ -411,7 +429,13 @@ void done_mdoutf(gmx_mdoutf_t of)
     }
     if (of->fp_xtc)
     {
+        std::string xtcFilename = gmx_fio_getname(of->fp_xtc);
         close_xtc(of->fp_xtc);
+        if (of->xtc_index)
+        {
+            xtc_index_write(xtcFilename.c_str(), *of->xtc_index);
+            delete of->xtc_index;
+        }
     }
     if (of->fp_trn)
     {
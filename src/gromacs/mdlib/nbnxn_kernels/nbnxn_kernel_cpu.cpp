@@ -47,6 +47,7 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/simd/simd.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/real.h"
 
 #include "nbnxn_kernel_common.h"
@@ -316,7 +317,9 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                                                                out->f,
                                                                fshift_p,
                                                                out->Vvdw,
-                                                               out->Vc);
+                                                               out->Vc,
+                                                               fda,
+                                                               cellInv);
                     break;
 #endif
 #ifdef GMX_NBNXN_SIMD_4XN
@@ -327,7 +330,9 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                                                               out->f,
                                                               fshift_p,
                                                               out->Vvdw,
-                                                              out->Vc);
+                                                              out->Vc,
+                                                              fda,
+                                                              cellInv);
                     break;
 #endif
                 default:
@@ -364,7 +369,9 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                                                                   out->f,
                                                                   fshift_p,
                                                                   out->VSvdw,
-                                                                  out->VSc);
+                                                                  out->VSc,
+                                                                  fda,
+                                                                  cellInv);
                     break;
 #endif
 #ifdef GMX_NBNXN_SIMD_4XN
@@ -376,7 +383,9 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                                                                  out->f,
                                                                  fshift_p,
                                                                  out->VSvdw,
-                                                                 out->VSc);
+                                                                 out->VSc,
+                                                                 fda,
+                                                                 cellInv);
                     break;
 #endif
                 default:
@@ -410,6 +419,12 @@ nbnxn_kernel_cpu(nonbonded_verlet_group_t  *nbvg,
                 }
             }
         }
+
+        if (fda != nullptr)
+        {
+            /* Add the pairs collected by the SIMD kernels to FDA */
+            fda->flush_nonbonded_pair_buffer(gmx_omp_get_thread_num());
+        }
     }
 
     if (forceFlags & GMX_FORCE_ENERGY)
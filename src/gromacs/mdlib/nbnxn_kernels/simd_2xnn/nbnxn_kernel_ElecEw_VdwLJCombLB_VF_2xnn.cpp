@@ -69,7 +69,9 @@ nbnxn_kernel_ElecEw_VdwLJCombLB_VF_2xnn(const nbnxn_pairlist_t    gmx_unused *nb
                                         real                      gmx_unused *f,
                                         real                      gmx_unused *fshift,
                                         real                      gmx_unused *Vvdw,
-                                        real                      gmx_unused *Vc)
+                                        real                      gmx_unused *Vc,
+                                        FDA                       gmx_unused *fda,
+                                        int                       gmx_unused *cellInv)
 #else /* CALC_ENERGIES */
 void
 nbnxn_kernel_ElecEw_VdwLJCombLB_VF_2xnn(const nbnxn_pairlist_t    gmx_unused *nbl,
@@ -866,6 +866,42 @@
     fscal_S2    = rinvsq_S2 * frcoul_S2;
 #endif
 
+#ifdef CALC_ENERGIES
+    if (fdaBuffer != nullptr && fdaBuffer->cluster_pair_in_groups(ci*UNROLLI, UNROLLI, aj, UNROLLJ))
+    {
+        /* Store the scalar pair forces of all lanes, the lanes are masked
+         * with the FDA groups when they are added to the pair buffer.
+         * Each register holds two i-atoms, so the layout is the same as for 4xn.
+         */
+#ifdef CALC_COULOMB
+        store(fdaFcoul + 0*UNROLLJ, rinvsq_S0 * frcoul_S0);
+        store(fdaFcoul + 2*UNROLLJ, rinvsq_S2 * frcoul_S2);
+#else
+        store(fdaFcoul + 0*UNROLLJ, zero_S);
+        store(fdaFcoul + 2*UNROLLJ, zero_S);
+#endif
+#ifdef CALC_LJ
+        store(fdaFvdw + 0*UNROLLJ, rinvsq_S0 * frLJ_S0);
+#else
+        store(fdaFvdw + 0*UNROLLJ, zero_S);
+#endif
+#if defined CALC_LJ && !defined HALF_LJ
+        store(fdaFvdw + 2*UNROLLJ, rinvsq_S2 * frLJ_S2);
+#else
+        store(fdaFvdw + 2*UNROLLJ, zero_S);
+#endif
+        store(fdaDx + 0*UNROLLJ, dx_S0);
+        store(fdaDx + 2*UNROLLJ, dx_S2);
+        store(fdaDy + 0*UNROLLJ, dy_S0);
+        store(fdaDy + 2*UNROLLJ, dy_S2);
+        store(fdaDz + 0*UNROLLJ, dz_S0);
+        store(fdaDz + 2*UNROLLJ, dz_S2);
+
+        fdaBuffer->add_cluster_pair(cellInv, ci*UNROLLI, aj, UNROLLI, UNROLLJ,
+                                    fdaFcoul, fdaFvdw, fdaDx, fdaDy, fdaDz);
+    }
+#endif /* CALC_ENERGIES */
+
     /* Calculate temporary vectorial force */
     tx_S0       = fscal_S0 * dx_S0;
     tx_S2       = fscal_S2 * dx_S2;
@@ -1143,6 +1143,55 @@
     fscal_S3    = rinvsq_S3 * frcoul_S3;
 #endif
 
+#ifdef CALC_ENERGIES
+    if (fdaBuffer != nullptr && fdaBuffer->cluster_pair_in_groups(ci*UNROLLI, UNROLLI, aj, UNROLLJ))
+    {
+        /* Store the scalar pair forces of all lanes, the lanes are masked
+         * with the FDA groups when they are added to the pair buffer.
+         */
+#ifdef CALC_COULOMB
+        store(fdaFcoul + 0*UNROLLJ, rinvsq_S0 * frcoul_S0);
+        store(fdaFcoul + 1*UNROLLJ, rinvsq_S1 * frcoul_S1);
+        store(fdaFcoul + 2*UNROLLJ, rinvsq_S2 * frcoul_S2);
+        store(fdaFcoul + 3*UNROLLJ, rinvsq_S3 * frcoul_S3);
+#else
+        store(fdaFcoul + 0*UNROLLJ, zero_S);
+        store(fdaFcoul + 1*UNROLLJ, zero_S);
+        store(fdaFcoul + 2*UNROLLJ, zero_S);
+        store(fdaFcoul + 3*UNROLLJ, zero_S);
+#endif
+#ifdef CALC_LJ
+        store(fdaFvdw + 0*UNROLLJ, rinvsq_S0 * frLJ_S0);
+        store(fdaFvdw + 1*UNROLLJ, rinvsq_S1 * frLJ_S1);
+#else
+        store(fdaFvdw + 0*UNROLLJ, zero_S);
+        store(fdaFvdw + 1*UNROLLJ, zero_S);
+#endif
+#if defined CALC_LJ && !defined HALF_LJ
+        store(fdaFvdw + 2*UNROLLJ, rinvsq_S2 * frLJ_S2);
+        store(fdaFvdw + 3*UNROLLJ, rinvsq_S3 * frLJ_S3);
+#else
+        store(fdaFvdw + 2*UNROLLJ, zero_S);
+        store(fdaFvdw + 3*UNROLLJ, zero_S);
+#endif
+        store(fdaDx + 0*UNROLLJ, dx_S0);
+        store(fdaDx + 1*UNROLLJ, dx_S1);
+        store(fdaDx + 2*UNROLLJ, dx_S2);
+        store(fdaDx + 3*UNROLLJ, dx_S3);
+        store(fdaDy + 0*UNROLLJ, dy_S0);
+        store(fdaDy + 1*UNROLLJ, dy_S1);
+        store(fdaDy + 2*UNROLLJ, dy_S2);
+        store(fdaDy + 3*UNROLLJ, dy_S3);
+        store(fdaDz + 0*UNROLLJ, dz_S0);
+        store(fdaDz + 1*UNROLLJ, dz_S1);
+        store(fdaDz + 2*UNROLLJ, dz_S2);
+        store(fdaDz + 3*UNROLLJ, dz_S3);
+
+        fdaBuffer->add_cluster_pair(cellInv, ci*UNROLLI, aj, UNROLLI, UNROLLJ,
+                                    fdaFcoul, fdaFvdw, fdaDx, fdaDy, fdaDz);
+    }
+#endif /* CALC_ENERGIES */
+
     /* Calculate temporary vectorial force */
     tx_S0       = fscal_S0 * dx_S0;
     tx_S1       = fscal_S1 * dx_S1;
@@ -117,6 +117,20 @@
     SimdReal  sh_ewald_S;
 #endif
 
+#ifdef CALC_ENERGIES
+    /* Force distribution analysis: the pair forces of a cluster pair
+     * are stored here and appended to the pair buffer of this thread,
+     * which is drained into FDA after the kernel has finished.
+     */
+    fda::NonbondedPairBuffer *fdaBuffer =
+        (fda != nullptr && fda->is_fda_step() ? &fda->nonbonded_pair_buffer(gmx_omp_get_thread_num()) : nullptr);
+    alignas(GMX_SIMD_ALIGNMENT) real fdaFcoul[UNROLLI*UNROLLJ];
+    alignas(GMX_SIMD_ALIGNMENT) real fdaFvdw[UNROLLI*UNROLLJ];
+    alignas(GMX_SIMD_ALIGNMENT) real fdaDx[UNROLLI*UNROLLJ];
+    alignas(GMX_SIMD_ALIGNMENT) real fdaDy[UNROLLI*UNROLLJ];
+    alignas(GMX_SIMD_ALIGNMENT) real fdaDz[UNROLLI*UNROLLJ];
+#endif
+
 #if defined LJ_CUT && defined CALC_ENERGIES
     SimdReal   p6_cpot_S, p12_cpot_S;
 #endif
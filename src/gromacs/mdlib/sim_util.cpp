@@ -1212,6 +1212,11 @@ static void do_force_cutsVERLET(FILE *fplog, t_commrec *cr,
         }
 
         nbnxn_atomdata_set(nbv->nbat, nbv->nbs, mdatoms, fr->cginfo);
+        if (fr->fda != nullptr)
+        {
+            /* Restrict the FDA pairs of the SIMD kernels to the cluster pairs of the FDA groups */
+            fr->fda->set_nbnxn_atom_order(nbv->nbs->a, nbv->nbat->natoms);
+        }
         wallcycle_stop(wcycle, ewcNS);
     }
 
@@ -43,6 +43,8 @@
 
 #include "selection.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "gromacs/selection/nbsearch.h"
@@ -51,6 +53,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textwriter.h"
 
@@ -63,6 +66,37 @@ namespace gmx
 namespace internal
 {
 
+namespace
+{
+
+/*! \brief
+ * Copies the atoms of the current positions into memory owned by \p dest.
+ *
+ * For dynamic selections, the atoms of \p src can point to memory used
+ * in the evaluation, which is overwritten when the next frame is evaluated.
+ */
+void copyMappedAtoms(gmx_ana_indexmap_t *dest, const gmx_ana_indexmap_t &src)
+{
+    if (dest->mapb.nalloc_a < src.mapb.nra)
+    {
+        if (dest->mapb.nalloc_a == 0)
+        {
+            // The atoms are not owned by dest.
+            dest->mapb.a = nullptr;
+        }
+        const int nalloc = std::max(src.b.nra, src.mapb.nra);
+        srenew(dest->mapb.a, nalloc);
+        dest->mapb.nalloc_a = nalloc;
+    }
+    if (dest->mapb.nalloc_a > 0)
+    {
+        std::copy(src.mapb.a, src.mapb.a + src.mapb.nra, dest->mapb.a);
+    }
+    dest->mapb.nra = src.mapb.nra;
+}
+
+}   // namespace
+
 /********************************************************************
  * SelectionData
  */
@@ -121,6 +155,21 @@ SelectionData::SelectionData(SelectionTreeElement *elem,
 }
 
 
+SelectionData::SelectionData(const SelectionData &source)
+    : name_(source.name_), selectionText_(source.selectionText_),
+      posMass_(source.posMass_), posCharge_(source.posCharge_),
+      flags_(source.flags_), rootElement_(source.rootElement_),
+      coveredFractionType_(source.coveredFractionType_),
+      coveredFraction_(source.coveredFraction_),
+      averageCoveredFraction_(source.averageCoveredFraction_),
+      bDynamic_(source.bDynamic_),
+      bDynamicCoveredFraction_(source.bDynamicCoveredFraction_)
+{
+    gmx_ana_pos_copy(&rawPositions_, const_cast<gmx_ana_pos_t *>(&source.rawPositions_), true);
+    copyMappedAtoms(&rawPositions_.m, source.rawPositions_.m);
+}
+
+
 SelectionData::~SelectionData()
 {
 }
@@ -195,6 +244,37 @@ SelectionData::hasSortedAtomIndices() const
     return gmx_ana_index_check_sorted(&g);
 }
 
+void
+SelectionData::copyFrame(const SelectionData &source)
+{
+    const gmx_ana_pos_t &src   = source.rawPositions_;
+    const int            count = src.count();
+    gmx_ana_pos_reserve(&rawPositions_, count, -1);
+    std::memcpy(rawPositions_.x, src.x, count*sizeof(*src.x));
+    if (rawPositions_.v != nullptr)
+    {
+        std::memcpy(rawPositions_.v, src.v, count*sizeof(*src.v));
+    }
+    if (rawPositions_.f != nullptr)
+    {
+        std::memcpy(rawPositions_.f, src.f, count*sizeof(*src.f));
+    }
+    // The other mapping arrays have been allocated for the maximal group
+    // in the constructor.
+    gmx_ana_indexmap_t &m = rawPositions_.m;
+    m.mapb.nr = src.m.mapb.nr;
+    std::copy(src.m.refid, src.m.refid + count, m.refid);
+    std::copy(src.m.mapid, src.m.mapid + count, m.mapid);
+    std::copy(src.m.mapb.index, src.m.mapb.index + count + 1, m.mapb.index);
+    m.bStatic = src.m.bStatic;
+    copyMappedAtoms(&m, src.m);
+
+    posMass_         = source.posMass_;
+    posCharge_       = source.posCharge_;
+    coveredFraction_ = source.coveredFraction_;
+}
+
+
 void
 SelectionData::refreshName()
 {
@@ -93,6 +93,20 @@ class SelectionData
          * \throws    std::bad_alloc if out of memory.
          */
         SelectionData(SelectionTreeElement *elem, const char *selstr);
+        /*! \brief
+         * Creates a copy of the current frame of another selection.
+         *
+         * \param[in] source Selection to copy.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * The copy shares the evaluation tree with \p source, but has its own
+         * positions, masses, charges and covered fraction, such that it keeps
+         * the values of the frame while \p source is evaluated for other
+         * frames.  The copy must not be evaluated itself.
+         *
+         * \see copyFrame()
+         */
+        explicit SelectionData(const SelectionData &source);
         ~SelectionData();
 
         //! Returns the name for this selection.
@@ -124,6 +138,16 @@ class SelectionData
         //! \copydoc Selection::initCoveredFraction()
         bool initCoveredFraction(e_coverfrac_t type);
 
+        /*! \brief
+         * Copies the values of the current frame from another selection.
+         *
+         * \param[in] source Selection from which this object was copied.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * Called by SelectionCollection::copyFrame().
+         */
+        void copyFrame(const SelectionData &source);
+
         /*! \brief
          * Updates the name of the selection if missing.
          *
@@ -221,7 +245,7 @@ class SelectionData
          */
         friend class gmx::SelectionPosition;
 
-        GMX_DISALLOW_COPY_AND_ASSIGN(SelectionData);
+        GMX_DISALLOW_ASSIGN(SelectionData);
 };
 
 }   // namespace internal
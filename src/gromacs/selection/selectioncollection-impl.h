@@ -187,6 +187,8 @@ class SelectionCollection::Impl
         bool                    bExternalGroupsSet_;
         //! External index groups (can be NULL).
         gmx_ana_indexgrps_t    *grps_;
+        //! Collection from which the selections are copied by copyFrame() (can be NULL).
+        const gmx_ana_selcollection_t *frameSource_;
 };
 
 /*! \internal
@@ -84,7 +84,8 @@ namespace gmx
  */
 
 SelectionCollection::Impl::Impl()
-    : debugLevel_(0), bExternalGroupsSet_(false), grps_(nullptr)
+    : debugLevel_(0), bExternalGroupsSet_(false), grps_(nullptr),
+      frameSource_(nullptr)
 {
     sc_.nvars     = 0;
     sc_.varstrs   = nullptr;
@@ -907,6 +908,50 @@ SelectionCollection::evaluate(t_trxframe *fr, t_pbc *pbc)
 }
 
 
+void
+SelectionCollection::copyFrame(const SelectionCollection &source)
+{
+    const SelectionDataList &sourceSelections = source.impl_->sc_.sel;
+    SelectionDataList       &selections       = impl_->sc_.sel;
+    if (impl_->frameSource_ == nullptr)
+    {
+        GMX_RELEASE_ASSERT(selections.empty(),
+                           "Frame copies can only be made into an empty collection");
+        for (const auto &sel : sourceSelections)
+        {
+            selections.emplace_back(new internal::SelectionData(*sel));
+        }
+        impl_->frameSource_ = &source.impl_->sc_;
+        return;
+    }
+    GMX_RELEASE_ASSERT(impl_->frameSource_ == &source.impl_->sc_
+                       && selections.size() == sourceSelections.size(),
+                       "Frame copies can only be made from the same collection");
+    for (size_t i = 0; i < selections.size(); ++i)
+    {
+        selections[i]->copyFrame(*sourceSelections[i]);
+    }
+}
+
+
+Selection
+SelectionCollection::frameCopy(const Selection &selection) const
+{
+    if (impl_->frameSource_ != nullptr)
+    {
+        const SelectionDataList &sourceSelections = impl_->frameSource_->sel;
+        for (size_t i = 0; i < sourceSelections.size(); ++i)
+        {
+            if (Selection(sourceSelections[i].get()) == selection)
+            {
+                return Selection(impl_->sc_.sel[i].get());
+            }
+        }
+    }
+    return selection;
+}
+
+
 void
 SelectionCollection::evaluateFinal(int nframes)
 {
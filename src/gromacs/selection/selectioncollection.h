@@ -389,6 +389,34 @@ class SelectionCollection
          */
         void evaluateFinal(int nframes);
 
+        /*! \brief
+         * Copies the evaluated selections of the current frame from another
+         * collection.
+         *
+         * \param[in] source  Compiled selection collection.
+         * \throws    std::bad_alloc if out of memory.
+         *
+         * On the first call, a copy of each selection in \p source is created
+         * in this collection, which must not contain any selections itself.
+         * Later calls must use the same \p source and update the copies.
+         * The copies keep the positions of the frame while \p source is
+         * evaluated for other frames, which allows frames to be analyzed
+         * concurrently.  This collection cannot be evaluated.
+         *
+         * \see frameCopy()
+         */
+        void copyFrame(const SelectionCollection &source);
+        /*! \brief
+         * Returns the copy of a selection made by copyFrame().
+         *
+         * \param[in] selection  Selection in the collection passed to copyFrame().
+         * \returns   The corresponding selection in this collection, or
+         *      \p selection if copyFrame() has not been called.
+         *
+         * Does not throw.
+         */
+        Selection frameCopy(const Selection &selection) const;
+
         /*! \brief
          * Prints a human-readable version of the internal selection element
          * tree.
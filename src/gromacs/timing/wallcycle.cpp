@@ -130,6 +130,8 @@ static const char *wcsn[ewcsNR] =
     "Ewald F correction",
     "NB X buffer ops.",
     "NB F buffer ops.",
+    "FDA accumulate",
+    "FDA write",
 };
 
 /* PME GPU timing events' names - correspond to the enum in the gpu_timing.h */
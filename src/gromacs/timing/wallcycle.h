@@ -77,6 +77,8 @@ enum {
     ewcsEWALD_CORRECTION,
     ewcsNB_X_BUF_OPS,
     ewcsNB_F_BUF_OPS,
+    ewcsFDA_ACCUMULATE,
+    ewcsFDA_WRITE,
     ewcsNR
 };
 
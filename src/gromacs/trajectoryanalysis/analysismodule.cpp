@@ -48,6 +48,7 @@
 
 #include "gromacs/analysisdata/analysisdata.h"
 #include "gromacs/selection/selection.h"
+#include "gromacs/selection/selectioncollection.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
 
@@ -193,8 +194,7 @@ TrajectoryAnalysisModuleData::dataHandle(const AnalysisData &data)
 
 Selection TrajectoryAnalysisModuleData::parallelSelection(const Selection &selection)
 {
-    // TODO: Implement properly.
-    return selection;
+    return impl_->selections_.frameCopy(selection);
 }
 
 
@@ -121,6 +121,17 @@ class TrajectoryAnalysisSettings
              * \see setRmPBC()
              */
             efNoUserRmPBC    = 1<<5,
+            /*! \brief
+             * Allows the user to analyze several frames concurrently.
+             *
+             * If this flag is specified, a `-nt` command-line option is
+             * provided.  The module must then only access selections through
+             * TrajectoryAnalysisModuleData::parallelSelection() and output
+             * data through the data handles in
+             * TrajectoryAnalysisModule::analyzeFrame(), and must not modify
+             * other state of the module there.
+             */
+            efFrameParallel  = 1<<6,
         };
 
         //! Initializes default settings.
@@ -43,9 +43,14 @@
 
 #include "cmdlinerunner.h"
 
+#include <future>
+#include <memory>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -66,6 +71,53 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * FrameSlot
+ */
+
+/*! \brief
+ * Data for analyzing one frame concurrently with other frames.
+ *
+ * The members are declared such that the pending analysis is waited for
+ * before the thread-local data and the selections are destroyed.
+ */
+struct FrameSlot
+{
+    //! Copy of the selections evaluated for the frame.
+    SelectionCollection                 selections;
+    //! Thread-local data of the analysis module.
+    TrajectoryAnalysisModuleDataPointer pdata;
+    //! Copy of the frame (the coordinates are stored in \a x, \a v, \a f).
+    t_trxframe                          frame;
+    //! Coordinates of \a frame.
+    std::vector<RVec>                   x;
+    //! Velocities of \a frame.
+    std::vector<RVec>                   v;
+    //! Forces of \a frame.
+    std::vector<RVec>                   f;
+    //! PBC information for \a frame.
+    t_pbc                               pbc;
+    //! Index of the frame being analyzed.
+    int                                 frameIndex;
+    //! Pending analysis of the frame.
+    std::future<void>                   analysis;
+};
+
+/*! \brief
+ * Copies the coordinate array \p src of \p natoms atoms into \p dest.
+ *
+ * Returns a pointer to the copy, or `nullptr` if \p src is `nullptr`.
+ */
+rvec *copyFrameArray(const rvec *src, int natoms, std::vector<RVec> *dest)
+{
+    if (src == nullptr)
+    {
+        return nullptr;
+    }
+    dest->assign(src, src + natoms);
+    return as_rvec_array(dest->data());
+}
+
 /********************************************************************
  * RunnerModule
  */
@@ -84,6 +136,13 @@ class RunnerModule : public ICommandLineOptionsModule
         virtual void optionsFinished();
         virtual int run();
 
+        /*! \brief
+         * Analyzes all frames with \p threadCount frames concurrently.
+         *
+         * \returns The number of frames analyzed.
+         */
+        int runFrameParallel(int threadCount);
+
         TrajectoryAnalysisModulePointer module_;
         TrajectoryAnalysisSettings      settings_;
         TrajectoryAnalysisRunnerCommon  common_;
@@ -127,35 +186,42 @@ int RunnerModule::run()
     common_.initFrameIndexGroup();
     module_->initAfterFirstFrame(settings_, common_.frame());
 
-    t_pbc  pbc;
-    t_pbc *ppbc = settings_.hasPBC() ? &pbc : nullptr;
-
-    int    nframes = 0;
-    AnalysisDataParallelOptions         dataOptions;
-    TrajectoryAnalysisModuleDataPointer pdata(
-            module_->startFrames(dataOptions, selections_));
-    do
+    int nframes = 0;
+    if (common_.threadCount() > 1)
     {
-        common_.initFrame();
-        t_trxframe &frame = common_.frame();
-        if (ppbc != nullptr)
+        nframes = runFrameParallel(common_.threadCount());
+    }
+    else
+    {
+        t_pbc  pbc;
+        t_pbc *ppbc = settings_.hasPBC() ? &pbc : nullptr;
+
+        AnalysisDataParallelOptions         dataOptions;
+        TrajectoryAnalysisModuleDataPointer pdata(
+                module_->startFrames(dataOptions, selections_));
+        do
         {
-            set_pbc(ppbc, topology.ePBC(), frame.box);
-        }
+            common_.initFrame();
+            t_trxframe &frame = common_.frame();
+            if (ppbc != nullptr)
+            {
+                set_pbc(ppbc, topology.ePBC(), frame.box);
+            }
 
-        selections_.evaluate(&frame, ppbc);
-        module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
-        module_->finishFrameSerial(nframes);
+            selections_.evaluate(&frame, ppbc);
+            module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
+            module_->finishFrameSerial(nframes);
 
-        ++nframes;
-    }
-    while (common_.readNextFrame());
-    module_->finishFrames(pdata.get());
-    if (pdata.get() != nullptr)
-    {
-        pdata->finish();
+            ++nframes;
+        }
+        while (common_.readNextFrame());
+        module_->finishFrames(pdata.get());
+        if (pdata.get() != nullptr)
+        {
+            pdata->finish();
+        }
+        pdata.reset();
     }
-    pdata.reset();
 
     if (common_.hasTrajectory())
     {
@@ -176,6 +242,88 @@ int RunnerModule::run()
     return 0;
 }
 
+int RunnerModule::runFrameParallel(int threadCount)
+{
+    const TopologyInformation  &topology = common_.topologyInformation();
+    const bool                  bPBC     = settings_.hasPBC();
+    t_pbc                       pbc;
+    t_pbc                      *ppbc     = bPBC ? &pbc : nullptr;
+
+    // Frames are read and selections evaluated in this thread, and the
+    // evaluated selections and the frame are copied for the analysis, which
+    // runs in the background for up to threadCount frames.
+    AnalysisDataParallelOptions             dataOptions(threadCount);
+    std::vector<std::unique_ptr<FrameSlot> > slots;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        slots.emplace_back(new FrameSlot());
+    }
+
+    int nframes = 0;
+    do
+    {
+        FrameSlot &slot = *slots[nframes % threadCount];
+        if (slot.analysis.valid())
+        {
+            slot.analysis.get();
+            module_->finishFrameSerial(slot.frameIndex);
+        }
+
+        common_.initFrame();
+        t_trxframe &frame = common_.frame();
+        if (ppbc != nullptr)
+        {
+            set_pbc(ppbc, topology.ePBC(), frame.box);
+        }
+        selections_.evaluate(&frame, ppbc);
+
+        slot.selections.copyFrame(selections_);
+        if (!slot.pdata)
+        {
+            slot.pdata = module_->startFrames(dataOptions, slot.selections);
+        }
+        slot.frame   = frame;
+        slot.frame.x = copyFrameArray(frame.x, frame.natoms, &slot.x);
+        slot.frame.v = copyFrameArray(frame.v, frame.natoms, &slot.v);
+        slot.frame.f = copyFrameArray(frame.f, frame.natoms, &slot.f);
+        if (bPBC)
+        {
+            set_pbc(&slot.pbc, topology.ePBC(), slot.frame.box);
+        }
+        slot.frameIndex = nframes;
+        slot.analysis   = std::async(std::launch::async, [this, &slot, bPBC]
+                {
+                    module_->analyzeFrame(slot.frameIndex, slot.frame,
+                                          bPBC ? &slot.pbc : nullptr,
+                                          slot.pdata.get());
+                });
+
+        ++nframes;
+    }
+    while (common_.readNextFrame());
+
+    // Finish the pending frames in order.
+    for (int i = 0; i < threadCount; ++i)
+    {
+        FrameSlot &slot = *slots[(nframes + i) % threadCount];
+        if (slot.analysis.valid())
+        {
+            slot.analysis.get();
+            module_->finishFrameSerial(slot.frameIndex);
+        }
+    }
+    for (auto &slot : slots)
+    {
+        if (slot->pdata)
+        {
+            module_->finishFrames(slot->pdata.get());
+            slot->pdata->finish();
+            slot->pdata.reset();
+        }
+    }
+    return nframes;
+}
+
 }   // namespace
 
 /********************************************************************
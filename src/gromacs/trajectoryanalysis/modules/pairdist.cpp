@@ -214,6 +214,7 @@ PairDistance::initOptions(IOptionsContainer *options, TrajectoryAnalysisSettings
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("o").filetype(eftPlot).outputFile().required()
                            .store(&fnDist_).defaultBasename("dist")
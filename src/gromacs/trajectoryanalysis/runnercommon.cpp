@@ -125,6 +125,8 @@ class TrajectoryAnalysisRunnerCommon::Impl : public ITopologyProvider
         bool                        bStartTimeSet_;
         bool                        bEndTimeSet_;
         bool                        bDeltaTimeSet_;
+        //! Number of frames to analyze concurrently.
+        int                         threadCount_;
 
         bool                        bTrajOpen_;
         //! The current frame, or \p NULL if no frame loaded yet.
@@ -140,6 +142,7 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings *settings)
     : settings_(*settings),
       startTime_(0.0), endTime_(0.0), deltaTime_(0.0),
       bStartTimeSet_(false), bEndTimeSet_(false), bDeltaTimeSet_(false),
+      threadCount_(1),
       bTrajOpen_(false), fr(nullptr), gpbc_(nullptr), status_(nullptr), oenv_(nullptr)
 {
 }
@@ -228,6 +231,8 @@ TrajectoryAnalysisRunnerCommon::Impl::initFirstFrame()
             GMX_THROW(FileIOError("Could not read coordinates from trajectory"));
         }
         bTrajOpen_ = true;
+        // Decode the next frames while the current ones are analyzed.
+        trx_prefetch(oenv_, status_, fr, std::max(2, threadCount_));
 
         if (topInfo_.hasTopology())
         {
@@ -389,6 +394,11 @@ TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer *options,
         options->addOption(BooleanOption("pbc").store(&settings.impl_->bPBC)
                                .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt").store(&impl_->threadCount_)
+                               .description("Number of frames to analyze concurrently"));
+    }
 }
 
 
@@ -405,6 +415,11 @@ TrajectoryAnalysisRunnerCommon::optionsFinished()
         GMX_THROW(InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->threadCount_ < 1)
+    {
+        GMX_THROW(InvalidInputError("-nt must be at least one"));
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
@@ -471,6 +486,13 @@ TrajectoryAnalysisRunnerCommon::initFrame()
 }
 
 
+int
+TrajectoryAnalysisRunnerCommon::threadCount() const
+{
+    return impl_->threadCount_;
+}
+
+
 bool
 TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 {
@@ -96,4 +96,16 @@ TEST_F(DistanceModuleTest, HandlesDynamicSelections)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(DistanceModuleTest, ComputesDistancesWithConcurrentFrames)
+{
+    const char *const cmdline[] = {
+        "distance",
+        "-select", "atomname S1 S2", "atomname S1 S2 and res_cog x < 2.8",
+        "-len", "2", "-binw", "0.5", "-nt", "2"
+    };
+    setTopology("simple.gro");
+    setTrajectory("simple.gro");
+    runTest(CommandLine(cmdline));
+}
+
 } // namespace
@@ -371,6 +371,8 @@ void registerLegacyModules(gmx::CommandLineModuleManager *manager)
                    "Plot punctual and von Mises virial stress as xpm or pdb");
     registerModule(manager, &gmx_fda_shortest_path, "fda_shortest_path",
                    "Generate the k-shortest paths of a FDA force network as pdb-graph");
+    registerModule(manager, &gmx_fda_rerun, "fda_rerun",
+                   "Calculate pairwise forces of a trajectory with concurrent mdrun reruns");
 
     {
         gmx::CommandLineModuleGroup group =
@@ -5,12 +5,16 @@
  *      Author: Bernd Doser, HITS gGmbH <bernd.doser@h-its.org>
  */
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <gtest/gtest.h>
 #include "gromacs/fda/PairwiseForces.h"
 #include "gromacs/options/filenameoption.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/path.h"
 #include "gromacs/utility/real.h"
@@ -36,14 +40,18 @@ struct TestDataStructure
         std::string const& residueFileExtension,
         std::string const& trajectoryFilename = "traj.trr",
         bool is_vector = false,
-        bool must_die = false
+        bool must_die = false,
+        int nthreads_omp = 1,
+        int nranks = 1
     )
       : testDirectory(testDirectory),
         atomFileExtension(atomFileExtension),
         residueFileExtension(residueFileExtension),
         trajectoryFilename(trajectoryFilename),
         is_vector(is_vector),
-        must_die(must_die)
+        must_die(must_die),
+        nthreads_omp(nthreads_omp),
+        nranks(nranks)
     {}
 
     std::string testDirectory;
@@ -52,8 +60,73 @@ struct TestDataStructure
     std::string trajectoryFilename;
     bool is_vector;
     bool must_die;
+    int nthreads_omp;
+    int nranks;
 };
 
+//! Copy the data set testDirectory into a temporary directory and change into it
+void copyTestData(TestFileManager& fileManager, std::string const& testDirectory)
+{
+    std::string dataPath = std::string(fileManager.getInputDataDirectory()) + "/data";
+    std::string testPath = fileManager.getTemporaryFilePath("/" + testDirectory);
+
+    std::string cmd = "mkdir -p " + testPath;
+    ASSERT_FALSE(system(cmd.c_str()));
+
+    cmd = "cp -r " + dataPath + "/" + testDirectory + "/* " + testPath;
+    ASSERT_FALSE(system(cmd.c_str()));
+
+    gmx_chdir(testPath.c_str());
+}
+
+//! Returns the content of the file
+std::string fileContent(std::string const& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+//! Command line of mdrun -rerun with the FDA input files of the test data set, the result files are added by the caller
+::gmx::test::CommandLine rerunCommandLine(std::string const& trajectoryFilename)
+{
+    ::gmx::test::CommandLine callRerun;
+    callRerun.append("gmx_fda mdrun");
+    callRerun.addOption("-deffnm", "rerun");
+    callRerun.addOption("-s", "topol.tpr");
+    callRerun.addOption("-rerun", trajectoryFilename);
+    callRerun.addOption("-pfn", "index.ndx");
+    callRerun.addOption("-pfi", "fda.pfi");
+    return callRerun;
+}
+
+//! Returns the lines of a scalar text result file with the force column removed
+std::string pairsWithoutForces(std::string const& filename)
+{
+    std::string pairs;
+    std::ifstream file(filename);
+    for (std::string line; std::getline(file, line); ) {
+        std::istringstream iss(line);
+        std::string i, j, force, type;
+        iss >> i >> j >> force >> type;
+        pairs += i + " " + j + " " + type + '\n';
+    }
+    return pairs;
+}
+
+//! Returns the frames of a text result file without the frame headers
+std::vector<std::string> frameContents(std::string const& filename)
+{
+    std::vector<std::string> frames;
+    std::ifstream file(filename);
+    for (std::string line; std::getline(file, line); ) {
+        if (line.compare(0, 6, "frame ") == 0) frames.push_back("");
+        else if (!frames.empty()) frames.back() += line + '\n';
+    }
+    return frames;
+}
+
 //! Test fixture for FDA
 class FDATest : public ::testing::WithParamInterface<TestDataStructure>,
                 public CommandLineTestBase
@@ -88,7 +161,16 @@ TEST_P(FDATest, Basic)
     callRerun.addOption("-deffnm", "rerun");
     callRerun.addOption("-s", "topol.tpr");
     callRerun.addOption("-rerun", GetParam().trajectoryFilename);
-    callRerun.addOption("-nt", "1");
+    if (GetParam().nranks > 1) {
+        callRerun.addOption("-ntmpi", GetParam().nranks);
+        callRerun.addOption("-npme", "0");
+        callRerun.addOption("-ntomp", GetParam().nthreads_omp);
+    } else if (GetParam().nthreads_omp > 1) {
+        callRerun.addOption("-ntmpi", "1");
+        callRerun.addOption("-ntomp", GetParam().nthreads_omp);
+    } else {
+        callRerun.addOption("-nt", "1");
+    }
     callRerun.addOption("-pfn", "index.ndx");
     callRerun.addOption("-pfi", "fda.pfi");
     if (!GetParam().atomFileExtension.empty()) callRerun.addOption(atomOption.c_str(), atomFilename.c_str());
@@ -144,6 +226,7 @@ INSTANTIATE_TEST_CASE_P(AllFDATests, FDATest, ::testing::Values(
     TestDataStructure("alagly_pairwise_forces_scalar_detailed_nonbonded", "pfa", "pfr"),
     TestDataStructure("alagly_pairwise_forces_vector_detailed_nonbonded", "pfa", "pfr", "traj.trr", true),
     TestDataStructure("alagly_verlet_summed_scalar", "pfa", "pfr"),
+    TestDataStructure("alagly_verlet_summed_scalar", "pfa", "pfr", "traj.trr", false, false, 2),
     TestDataStructure("alagly_group_excl", "pfa", "pfr"),
     TestDataStructure("alagly_group_excl_uncomplete_cgs", "pfa", "pfr"),
     TestDataStructure("alagly_pairwise_forces_scalar_all", "pfa", "pfr"),
@@ -160,10 +243,167 @@ INSTANTIATE_TEST_CASE_P(AllFDATests, FDATest, ::testing::Values(
     TestDataStructure("alagly_unknown_option", "pfa", "pfr", "", false, true),
     TestDataStructure("vwf_a2_domain_nframes1_pairwise_forces_scalar", "pfa", "pfr", "traj.xtc"),
     TestDataStructure("vwf_a2_domain_nframes1_punctual_stress", "psa", "psr", "traj.xtc"),
+    TestDataStructure("vwf_a2_domain_nframes1_punctual_stress", "psa", "psr", "traj.xtc", false, false, 1, 2),
     TestDataStructure("vwf_a2_domain_nframes10_pairwise_forces_scalar", "pfa", "pfr", "traj.xtc"),
     TestDataStructure("vwf_a2_domain_nframes10_punctual_stress", "psa", "psr", "traj.xtc")
 ));
 
+//! Test fixture for FDA runs with different settings of the same data set
+class FDARunTest : public CommandLineTestBase
+{};
+
+/**
+ * The unsorted pairwise forces of more than one OpenMP thread are bit-identical between runs with the same
+ * number of threads and have the same order of pairs for all numbers of threads. The forces of a single thread
+ * only agree within the tolerance, as the summation order of the contributions to a pair depends on the threads.
+ */
+TEST_F(FDARunTest, SameOutputForAllThreadCounts)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    copyTestData(fileManager(), "alagly_verlet_summed_scalar");
+
+    // The number of OpenMP threads is set only once per process, therefore mdrun is started as separate process.
+    std::string cmd = std::string(GMX_FDA_BINARY) + " mdrun -deffnm rerun -s topol.tpr -rerun traj.trr -pfn index.ndx -pfi fda.pfi";
+    for (std::string run : {"nt1", "nt2", "nt4", "nt4_repeated"}) {
+        std::string threads = run == "nt1" ? "-nt 1" : run == "nt2" ? "-ntmpi 1 -ntomp 2" : "-ntmpi 1 -ntomp 4";
+        std::string cmd_run = cmd + " " + threads + " -pfa " + run + ".pfa -pfr " + run + ".pfr > " + run + ".out 2>&1";
+        ASSERT_FALSE(system(cmd_run.c_str())) << cmd_run;
+    }
+
+    EXPECT_FALSE(fileContent("nt4.pfa").empty());
+    EXPECT_EQ(fileContent("nt4.pfa"), fileContent("nt4_repeated.pfa"));
+    EXPECT_EQ(fileContent("nt4.pfr"), fileContent("nt4_repeated.pfr"));
+
+    EXPECT_EQ(pairsWithoutForces("nt2.pfa"), pairsWithoutForces("nt4.pfa"));
+    EXPECT_EQ(pairsWithoutForces("nt2.pfr"), pairsWithoutForces("nt4.pfr"));
+
+    const double error_factor = 1e4;
+    const bool weight_by_magnitude = true;
+    const bool ignore_sign = true;
+
+    LogicallyEqualComparer<weight_by_magnitude, ignore_sign> comparer(error_factor);
+
+    for (std::string run : {"nt2", "nt4"}) {
+        EXPECT_TRUE((fda::PairwiseForces<fda::Force<real>>("nt1.pfa").equal(fda::PairwiseForces<fda::Force<real>>(run + ".pfa"), comparer))) << run;
+        EXPECT_TRUE((fda::PairwiseForces<fda::Force<real>>("nt1.pfr").equal(fda::PairwiseForces<fda::Force<real>>(run + ".pfr"), comparer))) << run;
+    }
+
+    gmx_chdir(cwd.c_str());
+}
+
+#if GMX_SIMD
+//! The SIMD kernels must give the same pairwise forces as the plain-C reference kernels
+TEST_F(FDARunTest, SimdKernelEqualsReferenceKernel)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    copyTestData(fileManager(), "alagly_verlet_summed_scalar");
+
+    ::gmx::test::CommandLine callRerunSimd = rerunCommandLine("traj.trr");
+    callRerunSimd.addOption("-nt", "1");
+    callRerunSimd.addOption("-pfa", "simd.pfa");
+    callRerunSimd.addOption("-pfr", "simd.pfr");
+    ASSERT_FALSE(gmx_mdrun(callRerunSimd.argc(), callRerunSimd.argv()));
+
+    ::gmx::test::CommandLine callRerunReference = rerunCommandLine("traj.trr");
+    callRerunReference.addOption("-nt", "1");
+    callRerunReference.addOption("-pfa", "reference.pfa");
+    callRerunReference.addOption("-pfr", "reference.pfr");
+    setenv("GMX_DISABLE_SIMD_KERNELS", "1", 1);
+    int result = gmx_mdrun(callRerunReference.argc(), callRerunReference.argv());
+    unsetenv("GMX_DISABLE_SIMD_KERNELS");
+    ASSERT_FALSE(result);
+
+    const double error_factor = 1e4;
+    const bool weight_by_magnitude = true;
+    const bool ignore_sign = true;
+
+    LogicallyEqualComparer<weight_by_magnitude, ignore_sign> comparer(error_factor);
+
+    EXPECT_TRUE((fda::PairwiseForces<fda::Force<real>>("simd.pfa").equal(
+        fda::PairwiseForces<fda::Force<real>>("reference.pfa"), comparer)));
+    EXPECT_TRUE((fda::PairwiseForces<fda::Force<real>>("simd.pfr").equal(
+        fda::PairwiseForces<fda::Force<real>>("reference.pfr"), comparer)));
+
+    gmx_chdir(cwd.c_str());
+}
+#endif
+
+//! With nstfda = 3 only the steps 0, 3, 6, and 9 of the trajectory with the steps 0 to 10 are written
+TEST_F(FDARunTest, OnlyEveryNstfdaStepIsWritten)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    copyTestData(fileManager(), "alagly_verlet_summed_scalar");
+
+    ::gmx::test::CommandLine callRerun = rerunCommandLine("traj.trr");
+    callRerun.addOption("-nt", "1");
+    callRerun.addOption("-pfa", "nstfda1.pfa");
+    ASSERT_FALSE(gmx_mdrun(callRerun.argc(), callRerun.argv()));
+
+    std::string settings = fileContent("fda.pfi");
+    std::ofstream("fda.pfi") << settings << "\nnstfda = 3\n";
+    ::gmx::test::CommandLine callRerunNstfda = rerunCommandLine("traj.trr");
+    callRerunNstfda.addOption("-nt", "1");
+    callRerunNstfda.addOption("-pfa", "nstfda3.pfa");
+    ASSERT_FALSE(gmx_mdrun(callRerunNstfda.argc(), callRerunNstfda.argv()));
+
+    std::vector<std::string> frames = frameContents("nstfda1.pfa");
+    std::vector<std::string> framesNstfda = frameContents("nstfda3.pfa");
+    ASSERT_EQ(11U, frames.size());
+    ASSERT_EQ(4U, framesNstfda.size());
+    for (size_t frame = 0; frame != framesNstfda.size(); ++frame)
+        EXPECT_EQ(frames[3 * frame], framesNstfda[frame]) << "frame " << frame;
+
+    gmx_chdir(cwd.c_str());
+}
+
+//! The merged results of concurrent gmx fda_rerun chunks must be identical to those of a single rerun
+TEST_F(FDARunTest, FDARerunEqualsSingleRerun)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    copyTestData(fileManager(), "vwf_a2_domain_nframes10_punctual_stress");
+
+    ::gmx::test::CommandLine callRerun = rerunCommandLine("traj.xtc");
+    callRerun.addOption("-nt", "1");
+    callRerun.addOption("-psa", "single.psa");
+    callRerun.addOption("-psr", "single.psr");
+    ASSERT_FALSE(gmx_mdrun(callRerun.argc(), callRerun.argv()));
+
+    std::string cmd = std::string(GMX_FDA_BINARY) + " fda_rerun -s topol.tpr -f traj.xtc -pfi fda.pfi -pfn index.ndx"
+        " -psa chunks.psa -psr chunks.psr -nt 2 -chunk 3 > fda_rerun.out 2>&1";
+    ASSERT_FALSE(system(cmd.c_str())) << cmd;
+
+    EXPECT_FALSE(fileContent("single.psa").empty());
+    EXPECT_EQ(fileContent("single.psa"), fileContent("chunks.psa"));
+    EXPECT_EQ(fileContent("single.psr"), fileContent("chunks.psr"));
+
+    gmx_chdir(cwd.c_str());
+}
+
+//! The chunks of gmx fda_rerun must contain complete time averaging periods of the FDA steps
+TEST_F(FDARunTest, FDARerunEqualsSingleRerunWithNstfdaAndTimeAveraging)
+{
+    std::string cwd = gmx::Path::getWorkingDirectory();
+    copyTestData(fileManager(), "alagly_verlet_summed_scalar");
+
+    // The steps 0, 2, ..., 10 are averaged in pairs, the last chunk has the remaining frames
+    std::string settings = fileContent("fda.pfi");
+    std::ofstream("fda.pfi") << settings << "\nnstfda = 2\ntime_averages_period = 2\n";
+
+    ::gmx::test::CommandLine callRerun = rerunCommandLine("traj.trr");
+    callRerun.addOption("-nt", "1");
+    callRerun.addOption("-pfa", "single.pfa");
+    ASSERT_FALSE(gmx_mdrun(callRerun.argc(), callRerun.argv()));
+
+    std::string cmd = std::string(GMX_FDA_BINARY) + " fda_rerun -s topol.tpr -f traj.trr -pfi fda.pfi -pfn index.ndx"
+        " -pfa chunks.pfa -nt 2 -chunk 2 > fda_rerun.out 2>&1";
+    ASSERT_FALSE(system(cmd.c_str())) << cmd;
+
+    EXPECT_EQ(3U, frameContents("single.pfa").size());
+    EXPECT_EQ(fileContent("single.pfa"), fileContent("chunks.pfa"));
+
+    gmx_chdir(cwd.c_str());
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
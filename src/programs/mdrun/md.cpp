@@ -1184,11 +1184,16 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
                   do_per_step(step, nstglobalcomm) ||
                   (EI_VV(ir->eI) && inputrecNvtTrotter(ir) && do_per_step(step-1, nstglobalcomm)));
 
+        /* FDA collects the pairwise forces only every nstfda steps,
+         * the nonbonded pairs are only passed to FDA by the energy kernels.
+         */
+        fr->fda->set_step(step);
+
         force_flags = (GMX_FORCE_STATECHANGED |
                        ((inputrecDynamicBox(ir) || bRerunMD) ? GMX_FORCE_DYNAMICBOX : 0) |
                        GMX_FORCE_ALLFORCES |
                        (bCalcVir ? GMX_FORCE_VIRIAL : 0) |
-                       (bCalcEner ? GMX_FORCE_ENERGY : 0) |
+                       ((bCalcEner || fr->fda->is_fda_step()) ? GMX_FORCE_ENERGY : 0) |
                        (bDoFEP ? GMX_FORCE_DHDL : 0)
                        );
 
@@ -1390,8 +1395,21 @@ double gmx::do_md(FILE *fplog, t_commrec *cr, const gmx::MDLogger &mdlog,
         /* ########  END FIRST UPDATE STEP  ############## */
         /* ########  If doing VV, we now have v(dt) ###### */
 
-        // FDA
-        fr->fda->save_and_write_scalar_time_averages(state->x, top_global);
+        // FDA, the pairwise forces are only collected every nstfda steps
+        if (fr->fda->is_fda_step())
+        {
+            if (DOMAINDECOMP(cr))
+            {
+                /* The FDA output needs the global coordinates on the master rank */
+                dd_collect_vec(cr->dd, state, state->x,
+                               MASTER(cr) ? gmx::makeArrayRef(state_global->x) : gmx::EmptyArrayRef());
+                fr->fda->save_and_write_scalar_time_averages(MASTER(cr) ? state_global->x : state->x);
+            }
+            else
+            {
+                fr->fda->save_and_write_scalar_time_averages(state->x);
+            }
+        }
 
         if (bDoExpanded)
         {
@@ -555,9 +555,12 @@ int Mdrunner::mdrunner()
         read_tpx_state(ftp2fn(efTPR, nfile, fnm), inputrec, globalState.get(), mtop);
 
 #ifdef BUILD_WITH_FDA
-        ptr_fda_settings = std::make_shared<fda::FDASettings>(nfile, fnm, mtop, PAR(cr));
+        ptr_fda_settings = std::make_shared<fda::FDASettings>(nfile, fnm, mtop);
         ptr_fda = std::make_shared<FDA>(*ptr_fda_settings);
-        ptr_fda->modify_energy_group_exclusions(mtop, inputrec);
+        if (inputrec->cutoff_scheme == ecutsGROUP)
+        {
+            ptr_fda->modify_energy_group_exclusions(mtop, inputrec);
+        }
 #endif
 
         if (inputrec->cutoff_scheme != ecutsVERLET)
@@ -1165,7 +1168,25 @@ int Mdrunner::mdrunner()
                       pforce);
 
 #ifdef BUILD_WITH_FDA
+        if (!ptr_fda)
+        {
+            /* The other ranks set up FDA with the broadcasted topology, only the master rank writes */
+            ptr_fda_settings = std::make_shared<fda::FDASettings>(nfile, fnm, mtop);
+            ptr_fda = std::make_shared<FDA>(*ptr_fda_settings, MASTER(cr));
+        }
         fr->fda = ptr_fda.get();
+        if (fr->fda)
+        {
+            fr->fda->set_commrec(cr);
+            fr->fda->set_wallcycle(wcycle);
+
+            int nthreads_fda = 1;
+            for (int m = 0; m < emntNR; m++)
+            {
+                nthreads_fda = std::max(nthreads_fda, gmx_omp_nthreads_get(m));
+            }
+            fr->fda->set_nthreads(nthreads_fda);
+        }
 #endif
 
         /* Initialize QM-MM */